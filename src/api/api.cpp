@@ -21,46 +21,91 @@
 #pragma once
 
 #include "api.h"
+#include "renderjob.h"
+#include "scenebuilder.h"
+#include "sceneparser.h"
+#include "scenesnapshot.h"
 
-#include "core/camera/camera.h"
-#include "core/integrator/pathintegrator.h"
-#include "core/light/pointlight.h"
-#include "core/light/directionallight.h"
-#include "core/material/dielectric.h"
-#include "core/material/matte.h"
-#include "core/material/metal.h"
-#include "core/primitive/mesh.h"
-#include "core/primitive/primitive.h"
-#include "core/primitive/shape/quad.h"
-#include "core/primitive/shape/sphere.h"
-#include "core/primitive/shape/triangle.h"
-#include "core/scene/scene.h"
-#include "core/spatial/accelerator/accelerator.h"
+#include "core/integrator/pathstatistics.h"
+#include "core/primitive/geometrycache.h"
+#include "core/primitive/tessellationcache.h"
+
+#include <filesystem>
+#include <random>
 
 exrBEGIN_NAMESPACE
 
 ElixirOptions g_RuntimeOptions;
 
-// These options PER RENDER options. Scenes, cameras, integrators, etc.
-// General elixir settings (number of threads, etc) should go into ElixirOptions.
-struct RenderJob
-{
-    std::unique_ptr<Camera> m_Camera;
-    std::unique_ptr<Scene> m_Scene;
-    std::unique_ptr<Integrator> m_Integrator;
-};
-
 static std::unique_ptr<RenderJob> g_CurrentRenderJob = nullptr;
 
+// Not part of the render job, so that a render can be cancelled without touching the job
+static CancellationToken g_CancellationToken;
+
 void ElixirInit(const ElixirOptions& options)
 {
     g_RuntimeOptions = options;
-    g_CurrentRenderJob = std::make_unique<RenderJob>();
+
+    // The threads are kept for all render jobs of the process, so that jobs do not pay for
+    // spawning and joining them
+    exrAssert(options.numThreads > 0, "Unable to start elixir with 0 threads!");
+    ParallelInit(options.numThreads, options.pinThreads);
+
+    if (options.pinThreads && ThreadAffinity::GetNumNumaNodes() > 1)
+        exrInfoLine("Replicating scene data across " << ThreadAffinity::GetNumNumaNodes() << " NUMA nodes");
 }
 
 void ElixirCleanup()
 {
-    // Nothing to clean up for now.
+    ElixirEndRenderJob();
+    ParallelCleanup();
+}
+
+// The geometry cache goes into the cache directory, or the system temp directory if there is
+// none, rather than next to the output image. The random suffix keeps concurrent processes apart.
+static exrString GetGeometryCacheFileName(const ElixirOptions& options)
+{
+    std::filesystem::path directory = options.cacheDirectory;
+    if (directory.empty())
+    {
+        std::error_code error;
+        directory = std::filesystem::temp_directory_path(error);
+        if (error)
+            directory = ".";
+    }
+
+    std::ostringstream fileName;
+    fileName << "elixir_" << std::filesystem::path(options.outputFile).filename().string()
+        << "_" << std::hex << std::random_device()() << ".geocache";
+
+    return (directory / fileName.str()).string();
+}
+
+void ElixirBeginRenderJob(const ElixirOptions& options)
+{
+    // The thread pool has already been started with the options passed to ElixirInit()
+    const exrU32 numThreads = g_RuntimeOptions.numThreads;
+    g_RuntimeOptions = options;
+    g_RuntimeOptions.numThreads = numThreads;
+    g_CurrentRenderJob = std::make_unique<RenderJob>();
+
+    if (g_RuntimeOptions.outOfCore)
+    {
+        g_CurrentRenderJob->m_GeometryCache = std::make_unique<GeometryCache>(
+            GetGeometryCacheFileName(g_RuntimeOptions), g_RuntimeOptions.geometryCacheBudget * 1024 * 1024);
+    }
+
+    g_CurrentRenderJob->m_TessellationCache = std::make_unique<TessellationCache>(g_RuntimeOptions.tessellationCacheBudget * 1024 * 1024);
+}
+
+void ElixirEndRenderJob()
+{
+    // Release the scene so that the next render job starts from a clean slate
+    g_CurrentRenderJob = nullptr;
+
+    // Only a job that has finished clears the token. A cancel that arrives between two jobs
+    // stays pending, and stops the next render as soon as it starts.
+    g_CancellationToken.Reset();
 }
 
 void ElixirParseFile(const exrString& filename)
@@ -68,168 +113,156 @@ void ElixirParseFile(const exrString& filename)
     if (filename == "-")
         return ElixirSetupCornellBox();
 
-    // Load obj file
-    exrPoint3 position(2.0f, 3.75f, 10.0f);
-    exrPoint3 lookat(-0.6f, 2.0f, 0.0f);
-    exrFloat fov = 40.0f;
-    exrFloat focusDist = (position - lookat).Magnitude();
-    exrFloat aperture = 1 / 20.0f;
-    g_CurrentRenderJob->m_Camera = std::make_unique<Camera>(position, lookat, exrVector3::Up(), fov, aperture, focusDist);
-    g_CurrentRenderJob->m_Scene = std::make_unique<Scene>();
+    if (HasExtension(filename, ".snapshot"))
+        return SceneSnapshot::Load(filename, *g_CurrentRenderJob);
 
-    // Setup materials in the scene
-    // 0 - White
-    g_CurrentRenderJob->m_Scene->AddMaterial(std::make_unique<Matte>(exrSpectrum(1.0), 20));
-    // 1 - Red
-    g_CurrentRenderJob->m_Scene->AddMaterial(std::make_unique<Matte>(exrSpectrum::FromRGB(exrVector3(1.0, 0.0, 0.0)), 20));
-    // 2 - Green
-    g_CurrentRenderJob->m_Scene->AddMaterial(std::make_unique<Matte>(exrSpectrum::FromRGB(exrVector3(0.0, 1.0, 0.0)), 20));
-    // 3 - Glossy
-    g_CurrentRenderJob->m_Scene->AddMaterial(std::make_unique<Metal>(exrSpectrum::FromRGB(exrVector3(1.022f, 0.782f, 0.344f))));
+    if (!HasExtension(filename, ".scene"))
+        return ElixirParseFiles({ filename });
 
-    // Setup scene primitives
-    // Sphere
-    std::unique_ptr<Primitive> primitive = std::make_unique<Primitive>();
-    Transform transform;
+    SceneParser::ParseFile(filename, g_CurrentRenderJob->m_Description);
+    SceneBuilder::Build(g_CurrentRenderJob->m_Description, *g_CurrentRenderJob);
+}
 
-    std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(Mesh::LoadFromFile(filename.c_str()));
+void ElixirParseFiles(const std::vector<exrString>& filenames)
+{
+    SceneDescription& description = g_CurrentRenderJob->m_Description;
+
+    // Load obj files
+    description.m_Camera.m_Position = exrPoint3(2.0f, 3.75f, 10.0f);
+    description.m_Camera.m_LookAt = exrPoint3(-0.6f, 2.0f, 0.0f);
+    description.m_Camera.m_Fov = 40.0f;
+    description.m_Camera.m_FocusDistance = (description.m_Camera.m_Position - description.m_Camera.m_LookAt).Magnitude();
+    description.m_Camera.m_Aperture = 1 / 20.0f;
+
+    // Setup materials in the scene
+    description.m_Materials = {
+        // 0 - White
+        { MaterialDescription::MATERIALTYPE_MATTE, exrVector3(1.0f), 20, exrVector3::Zero() },
+        // 1 - Red
+        { MaterialDescription::MATERIALTYPE_MATTE, exrVector3(1.0f, 0.0f, 0.0f), 20, exrVector3::Zero() },
+        // 2 - Green
+        { MaterialDescription::MATERIALTYPE_MATTE, exrVector3(0.0f, 1.0f, 0.0f), 20, exrVector3::Zero() },
+        // 3 - Glossy
+        { MaterialDescription::MATERIALTYPE_METAL, exrVector3(1.022f, 0.782f, 0.344f), 0, exrVector3::Zero() }
+    };
 
-    for (exrU32 i = 0; i < mesh->m_NumFaces; ++i)
+    // Setup scene primitives
+    for (const exrString& filename : filenames)
     {
-        primitive = std::make_unique<Primitive>();
-        primitive->SetShape(std::make_unique<Triangle>(mesh, i));
-        primitive->SetMaterial(g_CurrentRenderJob->m_Scene->GetMaterial(0));
-        g_CurrentRenderJob->m_Scene->AddPrimitive(std::move(primitive));
+        InstanceDescription instance = {};
+        instance.m_Mesh = static_cast<exrU32>(description.m_Meshes.size());
+        description.m_Meshes.push_back({ filename, DisplacementSettings() });
+        description.m_Instances.push_back(instance);
     }
 
-    transform.SetTranslation(exrVector3(0,100,0));
-    transform.SetRotation(exrVector3(exrDegToRad(0), exrDegToRad(0), exrDegToRad(40)));
-    g_CurrentRenderJob->m_Scene->AddLight(std::make_unique<DirectionalLight>(transform, exrSpectrum::FromRGB(exrVector3(1,0.7,0.2)) * 2));
+    LightDescription light = {};
+    light.m_Type = LightDescription::LIGHTTYPE_DIRECTIONAL;
+    light.m_Intensity = exrVector3(1.0f, 0.7f, 0.2f) * 2;
+    light.m_Transform.m_Translation = exrVector3(0, 100, 0);
+    light.m_Transform.m_Rotation = exrVector3(exrDegToRad(0), exrDegToRad(0), exrDegToRad(40));
+    description.m_Lights.push_back(light);
 
-    // Init accel
-    g_CurrentRenderJob->m_Scene->InitAccelerator();
+    description.m_Integrator.m_NumSamples = 8;
+    description.m_Integrator.m_NumBounces = 8;
 
-    const exrU32 numSamples = 8;
-    const exrU32 numBounces = 8;
-    g_CurrentRenderJob->m_Integrator = std::make_unique<PathIntegrator>(g_CurrentRenderJob->m_Camera.get(), numSamples, numBounces);
+    SceneBuilder::Build(description, *g_CurrentRenderJob);
 }
 
 void ElixirSetupCornellBox()
 {
-    exrPoint3 position(0.0f, 2.75f, 10.0f);
-    exrPoint3 lookat(0.0f, 2.75f, 0.0f);
-    exrFloat fov = 40.0f;
-    exrFloat focusDist = (position - lookat).Magnitude();
-    exrFloat aperture = 1 / 20.0f;
-    g_CurrentRenderJob->m_Camera = std::make_unique<Camera>(position, lookat, exrVector3::Up(), fov, aperture, focusDist);
-    g_CurrentRenderJob->m_Scene = std::make_unique<Scene>();
+    SceneDescription& description = g_CurrentRenderJob->m_Description;
+
+    description.m_Camera.m_Position = exrPoint3(0.0f, 2.75f, 10.0f);
+    description.m_Camera.m_LookAt = exrPoint3(0.0f, 2.75f, 0.0f);
+    description.m_Camera.m_Fov = 40.0f;
+    description.m_Camera.m_FocusDistance = (description.m_Camera.m_Position - description.m_Camera.m_LookAt).Magnitude();
+    description.m_Camera.m_Aperture = 1 / 20.0f;
 
     // Setup materials in the scene
-    // 0 - White
-    g_CurrentRenderJob->m_Scene->AddMaterial(std::make_unique<Matte>(exrSpectrum(1.0), 20));
-    // 1 - Red
-    g_CurrentRenderJob->m_Scene->AddMaterial(std::make_unique<Matte>(exrSpectrum::FromRGB(exrVector3(1.0, 0.0, 0.0)), 20));
-    // 2 - Green
-    g_CurrentRenderJob->m_Scene->AddMaterial(std::make_unique<Matte>(exrSpectrum::FromRGB(exrVector3(0.0, 1.0, 0.0)), 20));
-    // 3 - Glossy
-    g_CurrentRenderJob->m_Scene->AddMaterial(std::make_unique<Metal>(exrSpectrum::FromRGB(exrVector3(1.022f, 0.782f, 0.344f) * 2)));
-    // 4 - Plastic
-    g_CurrentRenderJob->m_Scene->AddMaterial(std::make_unique<Dielectric>(exrSpectrum::FromRGB(exrVector3(0,1,1)), 0.4));
+    description.m_Materials = {
+        // 0 - White
+        { MaterialDescription::MATERIALTYPE_MATTE, exrVector3(1.0f), 20, exrVector3::Zero() },
+        // 1 - Red
+        { MaterialDescription::MATERIALTYPE_MATTE, exrVector3(1.0f, 0.0f, 0.0f), 20, exrVector3::Zero() },
+        // 2 - Green
+        { MaterialDescription::MATERIALTYPE_MATTE, exrVector3(0.0f, 1.0f, 0.0f), 20, exrVector3::Zero() },
+        // 3 - Glossy
+        { MaterialDescription::MATERIALTYPE_METAL, exrVector3(1.022f, 0.782f, 0.344f) * 2, 0, exrVector3::Zero() },
+        // 4 - Plastic
+        { MaterialDescription::MATERIALTYPE_DIELECTRIC, exrVector3(0, 1, 1), 0.4f, exrVector3::Zero() }
+    };
 
     // Setup scene primitives
-    // Sphere
-    std::unique_ptr<Primitive> primitive = std::make_unique<Primitive>();
-    Transform transform;
-    transform.SetTranslation(exrVector3(-0.6f, 1.0f, -0.1f));
-    primitive->SetShape(std::make_unique<Sphere>(1.0f));
-    primitive->SetMaterial(g_CurrentRenderJob->m_Scene->GetMaterial(4));
-    primitive->SetTransform(std::make_unique<Transform>(transform));
-    g_CurrentRenderJob->m_Scene->AddPrimitive(std::move(primitive));
-
-    primitive = std::make_unique<Primitive>();
-    transform.SetTranslation(exrVector3(1.0f, 0.7f, 1.5f));
-    primitive->SetShape(std::make_unique<Sphere>(0.7f));
-    primitive->SetMaterial(g_CurrentRenderJob->m_Scene->GetMaterial(3));
-    primitive->SetTransform(std::make_unique<Transform>(transform));
-    g_CurrentRenderJob->m_Scene->AddPrimitive(std::move(primitive));
-
+    auto addShape = [&](ShapeDescription::ShapeType type, exrU32 material, const exrVector2& size,
+        const exrVector3& translation, const exrVector3& rotation)
+    {
+        ShapeDescription shape = {};
+        shape.m_Type = type;
+        shape.m_Material = material;
+        shape.m_Size = size;
+        shape.m_Transform.m_Translation = translation;
+        shape.m_Transform.m_Rotation = rotation;
+        description.m_Shapes.push_back(shape);
+    };
+
+    // Spheres
+    addShape(ShapeDescription::SHAPETYPE_SPHERE, 4, exrVector2(1.0f), exrVector3(-0.6f, 1.0f, -0.1f), exrVector3::Zero());
+    addShape(ShapeDescription::SHAPETYPE_SPHERE, 3, exrVector2(0.7f), exrVector3(1.0f, 0.7f, 1.5f), exrVector3::Zero());
     // Back wall
-    primitive = std::make_unique<Primitive>();
-    transform.SetTranslation(exrVector3(0.0f, 2.75f, -2.75f));
-    primitive->SetShape(std::make_unique<Quad>(exrVector2(5.5f)));
-    primitive->SetMaterial(g_CurrentRenderJob->m_Scene->GetMaterial(0));
-    primitive->SetTransform(std::make_unique<Transform>(transform));
-    g_CurrentRenderJob->m_Scene->AddPrimitive(std::move(primitive));
-
-    // left wall
-    primitive = std::make_unique<Primitive>();
-    transform.SetTranslation(exrVector3(-2.75f, 2.75f, -0.0f));
-    transform.SetRotation(exrVector3(0.0f, EXR_M_PIOVER2, 0.0f));
-    primitive->SetShape(std::make_unique<Quad>(exrVector2(5.5f)));
-    primitive->SetMaterial(g_CurrentRenderJob->m_Scene->GetMaterial(1));
-    primitive->SetTransform(std::make_unique<Transform>(transform));
-    g_CurrentRenderJob->m_Scene->AddPrimitive(std::move(primitive));
-
-    // right wall
-    primitive = std::make_unique<Primitive>();
-    transform.SetTranslation(exrVector3(2.75f, 2.75f, -0.0f));
-    transform.SetRotation(exrVector3(0.0f, -EXR_M_PIOVER2, 0.0f));
-    primitive->SetShape(std::make_unique<Quad>(exrVector2(5.5f)));
-    primitive->SetMaterial(g_CurrentRenderJob->m_Scene->GetMaterial(2));
-    primitive->SetTransform(std::make_unique<Transform>(transform));
-    g_CurrentRenderJob->m_Scene->AddPrimitive(std::move(primitive));
-
-    // ceiling
-    primitive = std::make_unique<Primitive>();
-    transform.SetTranslation(exrVector3(0.0f, 5.5f, 0.0f));
-    transform.SetRotation(exrVector3(EXR_M_PIOVER2, 0.0f, 0.0f));
-    primitive->SetShape(std::make_unique<Quad>(exrVector2(5.5f)));
-    primitive->SetMaterial(g_CurrentRenderJob->m_Scene->GetMaterial(0));
-    primitive->SetTransform(std::make_unique<Transform>(transform));
-    g_CurrentRenderJob->m_Scene->AddPrimitive(std::move(primitive));
-
-    // ceiling light
-    // geoPrimitive = std::make_unique<Primitive>();
-    // transform.SetTranslation(exrVector3(0.0f, 5.5f, 0.0f));64
-    // transform.SetRotation(exrVector3(EXR_M_PIOVER2, 0.0f, 0.0f));
-    // geoPrimitive->m_Shape = std::make_unique<Quad>(transform, exrVector2(1.5f));
-    // geoPrimitive->m_Material = g_CurrentRenderJob->m_Scene->GetMaterial(3);
-    // g_CurrentRenderJob->m_Scene->AddPrimitive(std::move(geoPrimitive));
-
-    // floor
-    primitive = std::make_unique<Primitive>();
-    transform.SetTranslation(exrVector3(0.0f, 0.0f, 0.0f));
-    transform.SetRotation(exrVector3(-EXR_M_PIOVER2, 0.0f, 0.0f));
-    primitive->SetShape(std::make_unique<Quad>(exrVector2(5.5f)));
-    primitive->SetMaterial(g_CurrentRenderJob->m_Scene->GetMaterial(0));
-    primitive->SetTransform(std::make_unique<Transform>(transform));
-    g_CurrentRenderJob->m_Scene->AddPrimitive(std::move(primitive));
+    addShape(ShapeDescription::SHAPETYPE_QUAD, 0, exrVector2(5.5f), exrVector3(0.0f, 2.75f, -2.75f), exrVector3::Zero());
+    // Left wall
+    addShape(ShapeDescription::SHAPETYPE_QUAD, 1, exrVector2(5.5f), exrVector3(-2.75f, 2.75f, 0.0f), exrVector3(0.0f, EXR_M_PIOVER2, 0.0f));
+    // Right wall
+    addShape(ShapeDescription::SHAPETYPE_QUAD, 2, exrVector2(5.5f), exrVector3(2.75f, 2.75f, 0.0f), exrVector3(0.0f, -EXR_M_PIOVER2, 0.0f));
+    // Ceiling
+    addShape(ShapeDescription::SHAPETYPE_QUAD, 0, exrVector2(5.5f), exrVector3(0.0f, 5.5f, 0.0f), exrVector3(EXR_M_PIOVER2, 0.0f, 0.0f));
+    // Floor
+    addShape(ShapeDescription::SHAPETYPE_QUAD, 0, exrVector2(5.5f), exrVector3::Zero(), exrVector3(-EXR_M_PIOVER2, 0.0f, 0.0f));
 
     // Lights
-    transform.SetRotation(exrVector3::Zero());
-    transform.SetTranslation(exrVector3(0.0f, 5.2f, 0.0f));
-    g_CurrentRenderJob->m_Scene->AddLight(std::make_unique<PointLight>(transform, 3.0f));
-
-    // transform.SetRotation(exrVector3::Zero());
-    // transform.SetTranslation(exrVector3(-1.5f, 0.4f, 0.0f));
-    // g_CurrentRenderJob->m_Scene->AddLight(std::make_unique<PointLight>(transform, exrSpectrum::FromRGB(exrVector3(0.1f, 0.5f, 1.0f) * 10.0f)));
+    LightDescription light = {};
+    light.m_Type = LightDescription::LIGHTTYPE_POINT;
+    light.m_Intensity = exrVector3(3.0f);
+    light.m_Transform.m_Translation = exrVector3(0.0f, 5.2f, 0.0f);
+    description.m_Lights.push_back(light);
 
-    // transform.SetRotation(exrVector3::Zero());
-    // transform.SetTranslation(exrVector3(1.5f, 0.4f, 0.0f));
-    // g_CurrentRenderJob->m_Scene->AddLight(std::make_unique<PointLight>(transform, exrSpectrum::FromRGB(exrVector3(0.8f, 0.7f, 0.3f) * 10.0f)));
+    description.m_Integrator.m_NumSamples = 512;
+    description.m_Integrator.m_NumBounces = 16;
 
-    // Init accel
-    g_CurrentRenderJob->m_Scene->InitAccelerator();
+    SceneBuilder::Build(description, *g_CurrentRenderJob);
+}
 
-    const exrU32 numSamples = 512;
-    const exrU32 numBounces = 16;
-    g_CurrentRenderJob->m_Integrator = std::make_unique<PathIntegrator>(g_CurrentRenderJob->m_Camera.get(), numSamples, numBounces);
+void ElixirCompileScene(const exrString& filename)
+{
+    SceneSnapshot::Write(filename, *g_CurrentRenderJob);
+    exrInfoLine("Compiled scene snapshot " << filename);
 }
 
 void ElixirRender()
 {
     // Do render/write file
-    g_CurrentRenderJob->m_Integrator->Render(*g_CurrentRenderJob->m_Scene);
+    MemoryArena::ResetStatistics();
+    PathStatistics::ResetStatistics();
+    g_CancellationToken.SetTimeBudget(g_RuntimeOptions.timeBudget);
+    g_CurrentRenderJob->m_Integrator->Render(*g_CurrentRenderJob->m_Scene, g_CancellationToken);
+    MemoryArena::PrintStatistics();
+    PathStatistics::PrintStatistics();
+
+    if (g_CurrentRenderJob->m_GeometryCache != nullptr)
+        g_CurrentRenderJob->m_GeometryCache->PrintStatistics();
+
+    for (const MeshDescription& mesh : g_CurrentRenderJob->m_Description.m_Meshes)
+    {
+        if (mesh.m_Displacement.m_Level > 0)
+            return g_CurrentRenderJob->m_TessellationCache->PrintStatistics();
+    }
+}
+
+// Safe to call from any thread and from signal handlers. Cancels the current render job, or the
+// next one if none is running.
+void ElixirCancelRender()
+{
+    g_CancellationToken.Cancel();
 }
 
 exrEND_NAMESPACE
@@ -36,9 +36,14 @@
 exrBEGIN_NAMESPACE
 
 void ElixirInit(const ElixirOptions& options);
+void ElixirBeginRenderJob(const ElixirOptions& options);
 void ElixirParseFile(const exrString& filename);
+void ElixirParseFiles(const std::vector<exrString>& filenames);
 void ElixirSetupCornellBox();
+void ElixirCompileScene(const exrString& filename);
 void ElixirRender();
+void ElixirCancelRender();
+void ElixirEndRenderJob();
 void ElixirCleanup();
 
 exrEND_NAMESPACE
\ No newline at end of file
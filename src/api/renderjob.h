@@ -0,0 +1,53 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "scenedescription.h"
+#include "core/camera/camera.h"
+#include "core/integrator/integrator.h"
+#include "core/primitive/geometrycache.h"
+#include "core/primitive/tessellationcache.h"
+#include "core/scene/scene.h"
+#include "system/memory/mappedfile.h"
+
+exrBEGIN_NAMESPACE
+
+// These options PER RENDER options. Scenes, cameras, integrators, etc.
+// General elixir settings (number of threads, etc) should go into ElixirOptions.
+struct RenderJob
+{
+    // Declared first so that they outlive the meshes and accelerators that read from them
+    std::shared_ptr<MappedRegion> m_Snapshot;
+    std::unique_ptr<GeometryCache> m_GeometryCache;
+    std::unique_ptr<TessellationCache> m_TessellationCache;
+
+    //! The description the job was built from, kept so that it can be compiled into a snapshot
+    SceneDescription m_Description;
+
+    //! The shapes of the scene in group 0 (null if there are none), followed by one group per mesh file
+    std::vector<std::shared_ptr<Scene::PrimitiveGroup>> m_PrimitiveGroups;
+
+    std::unique_ptr<Camera> m_Camera;
+    std::unique_ptr<Scene> m_Scene;
+    std::unique_ptr<Integrator> m_Integrator;
+};
+
+exrEND_NAMESPACE
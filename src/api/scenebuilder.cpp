@@ -0,0 +1,209 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scenebuilder.h"
+#include "renderjob.h"
+
+#include "core/integrator/pathintegrator.h"
+#include "core/integrator/wavefrontintegrator.h"
+#include "core/light/directionallight.h"
+#include "core/light/pointlight.h"
+#include "core/material/dielectric.h"
+#include "core/material/matte.h"
+#include "core/material/metal.h"
+#include "core/primitive/shape/quad.h"
+#include "core/primitive/shape/sphere.h"
+#include "core/scene/meshloader.h"
+#include "core/spatial/accelerator/bvh.h"
+
+exrBEGIN_NAMESPACE
+
+static std::unique_ptr<Material> CreateMaterial(const MaterialDescription& description)
+{
+    const exrSpectrum color = exrSpectrum::FromRGB(description.m_Color);
+    std::unique_ptr<Material> material;
+
+    switch (description.m_Type)
+    {
+    case MaterialDescription::MATERIALTYPE_MATTE:
+        material = std::make_unique<Matte>(color, description.m_Value);
+        break;
+    case MaterialDescription::MATERIALTYPE_METAL:
+        material = std::make_unique<Metal>(color);
+        break;
+    case MaterialDescription::MATERIALTYPE_DIELECTRIC:
+        material = std::make_unique<Dielectric>(color, description.m_Value);
+        break;
+    default:
+        throw std::runtime_error("Invalid material type " + std::to_string(description.m_Type));
+    }
+
+    material->SetEmission(exrSpectrum::FromRGB(description.m_Emission));
+    return material;
+}
+
+static std::unique_ptr<Light> CreateLight(const LightDescription& description)
+{
+    const exrSpectrum intensity = exrSpectrum::FromRGB(description.m_Intensity);
+
+    switch (description.m_Type)
+    {
+    case LightDescription::LIGHTTYPE_POINT:
+    {
+        Transform transform;
+        transform.SetTranslation(description.m_Transform.m_Translation);
+        return std::make_unique<PointLight>(transform, intensity);
+    }
+    case LightDescription::LIGHTTYPE_DIRECTIONAL:
+        return std::make_unique<DirectionalLight>(description.m_Transform.ToTransform(), intensity);
+    default:
+        throw std::runtime_error("Invalid light type " + std::to_string(description.m_Type));
+    }
+}
+
+std::unique_ptr<Primitive> SceneBuilder::CreateShape(const ShapeDescription& description, Scene& scene)
+{
+    std::unique_ptr<Primitive> primitive = std::make_unique<Primitive>();
+
+    switch (description.m_Type)
+    {
+    case ShapeDescription::SHAPETYPE_SPHERE:
+        primitive->SetShape(std::make_unique<Sphere>(description.m_Size.x));
+        break;
+    case ShapeDescription::SHAPETYPE_QUAD:
+        primitive->SetShape(std::make_unique<Quad>(description.m_Size));
+        break;
+    default:
+        throw std::runtime_error("Invalid shape type " + std::to_string(description.m_Type));
+    }
+
+    primitive->SetMaterial(scene.GetMaterial(description.m_Material));
+    primitive->SetTransform(std::make_unique<Transform>(description.m_Transform.ToTransform()));
+    return primitive;
+}
+
+void SceneBuilder::Build(const SceneDescription& description, RenderJob& job)
+{
+    BuildWithoutGeometry(description, job);
+
+    std::vector<std::shared_ptr<Scene::PrimitiveGroup>> groups;
+    groups.reserve(description.m_Meshes.size() + 1);
+
+    if (description.m_Shapes.empty())
+        groups.push_back(nullptr);
+    else
+    {
+        std::shared_ptr<Scene::PrimitiveGroup> shapes = std::make_shared<Scene::PrimitiveGroup>();
+        std::vector<Primitive*> primitivePtrs;
+
+        for (const ShapeDescription& shape : description.m_Shapes)
+        {
+            shapes->m_Primitives.push_back(CreateShape(shape, *job.m_Scene));
+            primitivePtrs.push_back(shapes->m_Primitives.back().get());
+        }
+
+        shapes->m_Accelerator = std::make_unique<BVHAccelerator>(primitivePtrs);
+        groups.push_back(std::move(shapes));
+    }
+
+    if (!description.m_Meshes.empty())
+    {
+        std::vector<MeshLoader::Request> meshRequests;
+        for (exrU32 i = 0; i < description.m_Meshes.size(); ++i)
+        {
+            const Material* material = job.m_Scene->GetMaterial(GetMeshMaterial(description, i));
+            meshRequests.push_back({ description.m_Meshes[i].m_FileName, material, description.m_Meshes[i].m_Displacement });
+        }
+
+        std::vector<std::shared_ptr<Scene::PrimitiveGroup>> meshes = MeshLoader::LoadMeshes(meshRequests,
+            job.m_GeometryCache.get(), job.m_TessellationCache.get());
+        groups.insert(groups.end(), meshes.begin(), meshes.end());
+    }
+
+    AddGeometry(description, job, std::move(groups));
+}
+
+void SceneBuilder::BuildWithoutGeometry(const SceneDescription& description, RenderJob& job)
+{
+    const CameraDescription& camera = description.m_Camera;
+    job.m_Camera = std::make_unique<Camera>(camera.m_Position, camera.m_LookAt, camera.m_Up, camera.m_Fov,
+        camera.m_Aperture, camera.m_FocusDistance, Point2<exrU32>(camera.m_ResolutionX, camera.m_ResolutionY));
+
+    job.m_Scene = std::make_unique<Scene>();
+
+    for (const MaterialDescription& material : description.m_Materials)
+        job.m_Scene->AddMaterial(CreateMaterial(material));
+
+    for (const LightDescription& light : description.m_Lights)
+        job.m_Scene->AddLight(CreateLight(light));
+
+    const IntegratorDescription& integrator = description.m_Integrator;
+    if (integrator.m_Type == Integrator::INTEGRATOR_WAVEFRONT || g_RuntimeOptions.wavefront)
+    {
+        if (integrator.m_RadianceCacheCellSize > 0.0f)
+            exrWarningLine("The wavefront integrator does not support the radiance cache, tracing every path to its end");
+
+        job.m_Integrator = std::make_unique<WavefrontIntegrator>(job.m_Camera.get(), integrator.m_NumSamples, integrator.m_NumBounces, integrator.m_Regularization);
+    }
+    else
+    {
+        job.m_Integrator = std::make_unique<PathIntegrator>(job.m_Camera.get(), integrator.m_NumSamples, integrator.m_NumBounces,
+            integrator.m_Regularization, integrator.m_RadianceCacheCellSize);
+    }
+}
+
+void SceneBuilder::AddGeometry(const SceneDescription& description, RenderJob& job,
+    std::vector<std::shared_ptr<Scene::PrimitiveGroup>> groups)
+{
+    exrAssert(groups.size() == description.m_Meshes.size() + 1, "Expected one primitive group per mesh!");
+
+    if (groups[0] != nullptr)
+        job.m_Scene->AddInstance(groups[0]);
+
+    for (const InstanceDescription& instance : description.m_Instances)
+    {
+        const exrU32 meshMaterial = GetMeshMaterial(description, instance.m_Mesh);
+        const Material* material = instance.m_Material != meshMaterial ? job.m_Scene->GetMaterial(instance.m_Material) : nullptr;
+
+        if (instance.m_HasTransform)
+        {
+            const Transform transform = instance.m_Transform.ToTransform();
+            job.m_Scene->AddInstance(groups[instance.m_Mesh + 1], &transform, material);
+        }
+        else
+            job.m_Scene->AddInstance(groups[instance.m_Mesh + 1], nullptr, material);
+    }
+
+    job.m_PrimitiveGroups = std::move(groups);
+    job.m_Scene->InitAccelerator();
+}
+
+exrU32 SceneBuilder::GetMeshMaterial(const SceneDescription& description, exrU32 meshIndex)
+{
+    for (const InstanceDescription& instance : description.m_Instances)
+    {
+        if (instance.m_Mesh == meshIndex)
+            return instance.m_Material;
+    }
+
+    return 0;
+}
+
+exrEND_NAMESPACE
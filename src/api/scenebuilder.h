@@ -0,0 +1,63 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/scene/scene.h"
+
+exrBEGIN_NAMESPACE
+
+struct RenderJob;
+struct SceneDescription;
+struct ShapeDescription;
+
+//! @brief Builds the camera, scene and integrator of a render job from a scene description
+//!
+//! Building is split into two steps so that a scene snapshot can provide prebuilt geometry
+//! in between, instead of loading meshes and building accelerators again.
+class SceneBuilder
+{
+public:
+    //! @brief Builds everything, loading meshes and building accelerators from scratch
+    //! @param description      The scene to build
+    //! @param job              The render job to set up
+    static void Build(const SceneDescription& description, RenderJob& job);
+
+    //! @brief Builds the camera, integrator and an empty scene with all materials and lights
+    static void BuildWithoutGeometry(const SceneDescription& description, RenderJob& job);
+
+    //! @brief Places prebuilt geometry into a scene created by BuildWithoutGeometry()
+    //! @param description      The scene to build
+    //! @param job              The render job to set up
+    //! @param groups           The shapes in group 0 (or null), followed by one group per mesh file
+    static void AddGeometry(const SceneDescription& description, RenderJob& job,
+        std::vector<std::shared_ptr<Scene::PrimitiveGroup>> groups);
+
+    //! @brief Creates the primitive of a shape, using a material of the given scene
+    static std::unique_ptr<Primitive> CreateShape(const ShapeDescription& description, Scene& scene);
+
+    //! @brief Returns the material that the primitives of a mesh are created with
+    //!
+    //! This is the material of the first instance of the mesh. Other instances with a
+    //! different material override it.
+    static exrU32 GetMeshMaterial(const SceneDescription& description, exrU32 meshIndex);
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,153 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/elixir.h"
+#include "core/camera/camera.h"
+#include "core/integrator/integrator.h"
+#include "core/integrator/pathregularization.h"
+#include "core/primitive/displacedsurface.h"
+#include "core/primitive/transform.h"
+
+exrBEGIN_NAMESPACE
+
+// The records below describe a scene without building any of it. They contain no pointers,
+// so that they can be written to a scene snapshot and mapped back in as they are.
+
+struct TransformDescription
+{
+    exrVector3 m_Translation = exrVector3::Zero();
+    //! Euler angles in radians
+    exrVector3 m_Rotation = exrVector3::Zero();
+    exrFloat m_Scale = 1.0f;
+
+    Transform ToTransform() const
+    {
+        Transform transform;
+        transform.SetTranslation(m_Translation);
+        transform.SetRotation(m_Rotation);
+        transform.SetScale(m_Scale);
+        return transform;
+    }
+};
+
+struct CameraDescription
+{
+    exrPoint3 m_Position = exrPoint3(0.0f, 0.0f, 10.0f);
+    exrPoint3 m_LookAt = exrPoint3::Zero();
+    exrVector3 m_Up = exrVector3::Up();
+    exrFloat m_Fov = 40.0f;
+    exrFloat m_Aperture = 0.0f;
+    exrFloat m_FocusDistance = 10.0f;
+    exrU32 m_ResolutionX = WIDTH;
+    exrU32 m_ResolutionY = HEIGHT;
+};
+
+struct IntegratorDescription
+{
+    //! An Integrator::IntegratorType
+    exrU32 m_Type = Integrator::INTEGRATOR_PATHTRACER;
+    exrU32 m_NumSamples = 8;
+    exrU32 m_NumBounces = 8;
+    PathRegularization m_Regularization;
+    //! The cell size of the radiance cache in scene units, or 0 to render without it
+    exrFloat m_RadianceCacheCellSize = 0.0f;
+};
+
+struct MaterialDescription
+{
+    enum MaterialType
+    {
+        MATERIALTYPE_MATTE,
+        MATERIALTYPE_METAL,
+        MATERIALTYPE_DIELECTRIC
+    };
+
+    exrU32 m_Type;
+    //! The albedo of matte, the specular color of metal, or the diffuse color of dielectric materials
+    exrVector3 m_Color;
+    //! The roughness of matte, or the specular amount of dielectric materials
+    exrFloat m_Value;
+    //! The radiance that shapes with the material emit, which makes them area lights if it is not black
+    exrVector3 m_Emission = exrVector3::Zero();
+};
+
+struct ShapeDescription
+{
+    enum ShapeType
+    {
+        SHAPETYPE_SPHERE,
+        SHAPETYPE_QUAD
+    };
+
+    exrU32 m_Type;
+    exrU32 m_Material;
+    //! The size of quads, or the radius of spheres in x
+    exrVector2 m_Size;
+    TransformDescription m_Transform;
+};
+
+struct LightDescription
+{
+    enum LightType
+    {
+        LIGHTTYPE_POINT,
+        LIGHTTYPE_DIRECTIONAL
+    };
+
+    exrU32 m_Type;
+    exrVector3 m_Intensity;
+    //! Point lights use the translation, directional lights shine down the rotated -y axis
+    TransformDescription m_Transform;
+};
+
+struct MeshDescription
+{
+    exrString m_FileName;
+    DisplacementSettings m_Displacement;
+};
+
+struct InstanceDescription
+{
+    //! The index of the mesh in m_Meshes
+    exrU32 m_Mesh;
+    exrU32 m_Material;
+    //! Zero if the mesh is placed as is, which skips transforming rays into object space
+    exrU32 m_HasTransform;
+    TransformDescription m_Transform;
+};
+
+//! @brief Everything needed to build a render job
+//!
+//! Materials are referred to by their index in m_Materials, and meshes by their index in
+//! m_Meshes. Every mesh is loaded once, no matter how often it is instanced.
+struct SceneDescription
+{
+    CameraDescription m_Camera;
+    IntegratorDescription m_Integrator;
+    std::vector<MaterialDescription> m_Materials;
+    std::vector<ShapeDescription> m_Shapes;
+    std::vector<LightDescription> m_Lights;
+    std::vector<MeshDescription> m_Meshes;
+    std::vector<InstanceDescription> m_Instances;
+};
+
+exrEND_NAMESPACE
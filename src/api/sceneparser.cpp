@@ -0,0 +1,634 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sceneparser.h"
+#include "scenedescription.h"
+
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+
+exrBEGIN_NAMESPACE
+
+struct SceneToken
+{
+    enum TokenType
+    {
+        TOKENTYPE_END,
+        TOKENTYPE_WORD,
+        TOKENTYPE_STRING,
+        TOKENTYPE_NUMBER,
+        TOKENTYPE_LISTBEGIN,
+        TOKENTYPE_LISTEND
+    };
+
+    TokenType m_Type = TOKENTYPE_END;
+
+    //! A view into the source buffer. Strings do not include their quotes.
+    std::string_view m_Text;
+
+    exrU32 m_Line = 0;
+};
+
+//! Splits an in-memory scene file into tokens, with a single token of lookahead
+class SceneTokenizer
+{
+public:
+    SceneTokenizer(const exrString& filename, const exrString& source)
+        : m_FileName(filename)
+        , m_Cursor(source.data())
+        , m_End(source.data() + source.size()) {};
+
+    const SceneToken& Peek()
+    {
+        if (!m_HasPeeked)
+        {
+            m_Peeked = Read();
+            m_HasPeeked = true;
+        }
+
+        return m_Peeked;
+    }
+
+    SceneToken Next()
+    {
+        Peek();
+        m_HasPeeked = false;
+        return m_Peeked;
+    }
+
+    [[noreturn]] void Error(exrU32 line, const exrString& message) const
+    {
+        throw std::runtime_error(m_FileName + ":" + std::to_string(line) + ": " + message);
+    }
+
+private:
+    static exrBool IsWhitespace(exrChar c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+    static exrBool IsDelimiter(exrChar c) { return IsWhitespace(c) || c == '[' || c == ']' || c == '"' || c == '#'; }
+
+    SceneToken Read()
+    {
+        // Skip whitespace and comments
+        while (m_Cursor < m_End)
+        {
+            if (*m_Cursor == '#')
+            {
+                while (m_Cursor < m_End && *m_Cursor != '\n')
+                    ++m_Cursor;
+            }
+            else if (IsWhitespace(*m_Cursor))
+            {
+                if (*m_Cursor == '\n')
+                    ++m_Line;
+                ++m_Cursor;
+            }
+            else
+                break;
+        }
+
+        SceneToken token;
+        token.m_Line = m_Line;
+
+        if (m_Cursor == m_End)
+            return token;
+
+        const exrChar* begin = m_Cursor;
+
+        if (*m_Cursor == '[' || *m_Cursor == ']')
+        {
+            token.m_Type = *m_Cursor == '[' ? SceneToken::TOKENTYPE_LISTBEGIN : SceneToken::TOKENTYPE_LISTEND;
+            token.m_Text = std::string_view(m_Cursor++, 1);
+            return token;
+        }
+
+        if (*m_Cursor == '"')
+        {
+            ++begin;
+            do { ++m_Cursor; } while (m_Cursor < m_End && *m_Cursor != '"' && *m_Cursor != '\n');
+
+            if (m_Cursor == m_End || *m_Cursor != '"')
+                Error(m_Line, "Unterminated string");
+
+            token.m_Type = SceneToken::TOKENTYPE_STRING;
+            token.m_Text = std::string_view(begin, m_Cursor++ - begin);
+            return token;
+        }
+
+        while (m_Cursor < m_End && !IsDelimiter(*m_Cursor))
+            ++m_Cursor;
+
+        const exrBool isNumber = isdigit(*begin) || *begin == '-' || *begin == '+' || *begin == '.';
+        token.m_Type = isNumber ? SceneToken::TOKENTYPE_NUMBER : SceneToken::TOKENTYPE_WORD;
+        token.m_Text = std::string_view(begin, m_Cursor - begin);
+        return token;
+    }
+
+private:
+    const exrString& m_FileName;
+    const exrChar* m_Cursor;
+    const exrChar* m_End;
+    exrU32 m_Line = 1;
+
+    SceneToken m_Peeked;
+    exrBool m_HasPeeked = false;
+};
+
+//! Fills a scene description from the directives of a single scene file
+class SceneFileParser
+{
+public:
+    static constexpr exrU32 MaxArguments = 4;
+    static constexpr exrU32 MaxParameters = 16;
+
+    SceneFileParser(const exrString& filename, const exrString& source, SceneDescription& description)
+        : m_FileName(filename)
+        , m_Tokenizer(filename, source)
+        , m_Description(description)
+    {
+        // Mesh paths are relative to the scene file
+        const size_t separator = filename.find_last_of("/\\");
+        if (separator != exrString::npos)
+            m_Directory = filename.substr(0, separator + 1);
+    }
+
+    void Parse()
+    {
+        m_Description = SceneDescription();
+
+        while (m_Tokenizer.Peek().m_Type != SceneToken::TOKENTYPE_END)
+        {
+            const SceneToken directive = m_Tokenizer.Next();
+            if (directive.m_Type != SceneToken::TOKENTYPE_WORD || !isupper(directive.m_Text[0]))
+                m_Tokenizer.Error(directive.m_Line, "Expected a directive but found '" + exrString(directive.m_Text) + "'");
+
+            m_Directive = directive;
+            ReadArgumentsAndParameters();
+
+            if (directive.m_Text == "Camera")
+                ParseCamera();
+            else if (directive.m_Text == "Integrator")
+                ParseIntegrator();
+            else if (directive.m_Text == "Material")
+                ParseMaterial();
+            else if (directive.m_Text == "Shape")
+                ParseShape();
+            else if (directive.m_Text == "Mesh")
+                ParseMesh();
+            else if (directive.m_Text == "Instance")
+                ParseInstance();
+            else if (directive.m_Text == "Light")
+                ParseLight();
+            else
+                m_Tokenizer.Error(directive.m_Line, "Unknown directive '" + exrString(directive.m_Text) + "'");
+
+            for (exrU32 i = 0; i < m_NumParameters; ++i)
+            {
+                if (!m_Parameters[i].m_Used)
+                    exrWarningLine(m_FileName << ":" << m_Parameters[i].m_Line << ": Ignoring unknown parameter '"
+                        << m_Parameters[i].m_Name << "' of " << directive.m_Text);
+            }
+        }
+
+        if (!m_HasCamera)
+            m_Tokenizer.Error(m_Tokenizer.Peek().m_Line, "The scene does not define a Camera");
+    }
+
+private:
+    struct Parameter
+    {
+        std::string_view m_Name;
+        std::string_view m_String;
+        exrU32 m_FloatOffset;
+        exrU32 m_NumFloats;
+        exrU32 m_Line;
+        exrBool m_Used;
+    };
+
+    void ReadArgumentsAndParameters()
+    {
+        m_NumArguments = 0;
+        m_NumParameters = 0;
+        m_Floats.clear();
+
+        while (m_Tokenizer.Peek().m_Type == SceneToken::TOKENTYPE_STRING)
+        {
+            if (m_NumArguments == MaxArguments)
+                m_Tokenizer.Error(m_Tokenizer.Peek().m_Line, "Too many arguments");
+
+            m_Arguments[m_NumArguments++] = m_Tokenizer.Next().m_Text;
+        }
+
+        while (m_Tokenizer.Peek().m_Type == SceneToken::TOKENTYPE_WORD && !isupper(m_Tokenizer.Peek().m_Text[0]))
+        {
+            if (m_NumParameters == MaxParameters)
+                m_Tokenizer.Error(m_Tokenizer.Peek().m_Line, "Too many parameters");
+
+            const SceneToken name = m_Tokenizer.Next();
+            const SceneToken value = m_Tokenizer.Next();
+
+            Parameter& parameter = m_Parameters[m_NumParameters++];
+            parameter.m_Name = name.m_Text;
+            parameter.m_String = std::string_view();
+            parameter.m_FloatOffset = exrU32(m_Floats.size());
+            parameter.m_Line = name.m_Line;
+            parameter.m_Used = false;
+
+            switch (value.m_Type)
+            {
+            case SceneToken::TOKENTYPE_NUMBER:
+                m_Floats.push_back(ParseNumber(value));
+                break;
+            case SceneToken::TOKENTYPE_STRING:
+                parameter.m_String = value.m_Text;
+                break;
+            case SceneToken::TOKENTYPE_LISTBEGIN:
+                while (m_Tokenizer.Peek().m_Type == SceneToken::TOKENTYPE_NUMBER)
+                    m_Floats.push_back(ParseNumber(m_Tokenizer.Next()));
+
+                if (m_Tokenizer.Next().m_Type != SceneToken::TOKENTYPE_LISTEND)
+                    m_Tokenizer.Error(value.m_Line, "Expected ']' to close the list of '" + exrString(name.m_Text) + "'");
+                break;
+            default:
+                m_Tokenizer.Error(name.m_Line, "Expected a value for '" + exrString(name.m_Text) + "'");
+            }
+
+            parameter.m_NumFloats = exrU32(m_Floats.size()) - parameter.m_FloatOffset;
+        }
+    }
+
+    exrFloat ParseNumber(const SceneToken& token) const
+    {
+        // from_chars does not accept a leading plus sign
+        const exrChar* begin = token.m_Text.data() + (token.m_Text[0] == '+' ? 1 : 0);
+        const exrChar* end = token.m_Text.data() + token.m_Text.size();
+
+        exrFloat value = 0;
+        std::from_chars_result result = std::from_chars(begin, end, value);
+        if (result.ec != std::errc() || result.ptr != end)
+            m_Tokenizer.Error(token.m_Line, "Invalid number '" + exrString(token.m_Text) + "'");
+
+        return value;
+    }
+
+    std::string_view GetArgument(exrU32 index, const exrChar* description) const
+    {
+        if (index >= m_NumArguments)
+            m_Tokenizer.Error(m_Directive.m_Line, exrString(m_Directive.m_Text) + " is missing its " + description);
+
+        return m_Arguments[index];
+    }
+
+    const Parameter* FindParameter(std::string_view name)
+    {
+        for (exrU32 i = 0; i < m_NumParameters; ++i)
+        {
+            if (m_Parameters[i].m_Name == name)
+            {
+                m_Parameters[i].m_Used = true;
+                return &m_Parameters[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    //! Returns the numbers of a parameter, which must have one of the two given counts
+    const exrFloat* GetFloats(std::string_view name, exrU32 count, exrU32 alternativeCount, exrU32& numFloats)
+    {
+        const Parameter* parameter = FindParameter(name);
+        if (parameter == nullptr)
+            return nullptr;
+
+        if (parameter->m_NumFloats != count && parameter->m_NumFloats != alternativeCount)
+        {
+            m_Tokenizer.Error(parameter->m_Line, "'" + exrString(name) + "' expects " + std::to_string(count) +
+                (count != alternativeCount ? " or " + std::to_string(alternativeCount) : exrString()) + " number(s)");
+        }
+
+        numFloats = parameter->m_NumFloats;
+        return m_Floats.data() + parameter->m_FloatOffset;
+    }
+
+    exrFloat GetFloat(std::string_view name, exrFloat defaultValue)
+    {
+        exrU32 count;
+        const exrFloat* values = GetFloats(name, 1, 1, count);
+        return values != nullptr ? values[0] : defaultValue;
+    }
+
+    exrVector2 GetVector2(std::string_view name, const exrVector2& defaultValue)
+    {
+        exrU32 count;
+        const exrFloat* values = GetFloats(name, 2, 1, count);
+        if (values == nullptr)
+            return defaultValue;
+
+        return count == 2 ? exrVector2(values[0], values[1]) : exrVector2(values[0]);
+    }
+
+    exrVector3 GetVector3(std::string_view name, const exrVector3& defaultValue)
+    {
+        exrU32 count;
+        const exrFloat* values = GetFloats(name, 3, 3, count);
+        return values != nullptr ? exrVector3(values[0], values[1], values[2]) : defaultValue;
+    }
+
+    exrPoint3 GetPoint3(std::string_view name, const exrPoint3& defaultValue)
+    {
+        return exrPoint3(GetVector3(name, exrVector3(defaultValue)));
+    }
+
+    //! Colors are given either as RGB or as a single grey value
+    exrVector3 GetColor(std::string_view name, const exrVector3& defaultValue)
+    {
+        exrU32 count;
+        const exrFloat* values = GetFloats(name, 3, 1, count);
+        if (values == nullptr)
+            return defaultValue;
+
+        return count == 3 ? exrVector3(values[0], values[1], values[2]) : exrVector3(values[0]);
+    }
+
+    std::string_view GetString(std::string_view name, std::string_view defaultValue)
+    {
+        const Parameter* parameter = FindParameter(name);
+        if (parameter == nullptr)
+            return defaultValue;
+
+        if (parameter->m_NumFloats != 0 || parameter->m_String.data() == nullptr)
+            m_Tokenizer.Error(parameter->m_Line, "'" + exrString(name) + "' expects a string");
+
+        return parameter->m_String;
+    }
+
+    //! Rotations are given in degrees and applied in the order y, x, z
+    TransformDescription GetTransform()
+    {
+        TransformDescription transform;
+        transform.m_Translation = GetVector3("translate", exrVector3::Zero());
+        const exrVector3 rotation = GetVector3("rotate", exrVector3::Zero());
+        transform.m_Rotation = exrVector3(exrDegToRad(rotation.x), exrDegToRad(rotation.y), exrDegToRad(rotation.z));
+        transform.m_Scale = GetFloat("scale", 1.0f);
+        if (!(transform.m_Scale > 0.0f))
+            m_Tokenizer.Error(FindParameter("scale")->m_Line, "'scale' must be positive");
+
+        return transform;
+    }
+
+    exrBool HasTransform() const
+    {
+        for (exrU32 i = 0; i < m_NumParameters; ++i)
+        {
+            const std::string_view& name = m_Parameters[i].m_Name;
+            if (name == "translate" || name == "rotate" || name == "scale")
+                return true;
+        }
+
+        return false;
+    }
+
+    exrU32 GetMaterial()
+    {
+        const std::string_view name = GetString("material", std::string_view());
+        if (name.data() == nullptr)
+            m_Tokenizer.Error(m_Directive.m_Line, exrString(m_Directive.m_Text) + " requires a material");
+
+        auto it = m_Materials.find(name);
+        if (it == m_Materials.end())
+            m_Tokenizer.Error(m_Directive.m_Line, "Unknown material '" + exrString(name) + "'");
+
+        return it->second;
+    }
+
+    void ParseCamera()
+    {
+        const std::string_view type = m_NumArguments > 0 ? m_Arguments[0] : "perspective";
+        if (type != "perspective")
+            m_Tokenizer.Error(m_Directive.m_Line, "Unknown camera type '" + exrString(type) + "'");
+
+        CameraDescription& camera = m_Description.m_Camera;
+        camera.m_Position = GetPoint3("position", exrPoint3(0.0f, 0.0f, 10.0f));
+        camera.m_LookAt = GetPoint3("lookat", exrPoint3::Zero());
+        camera.m_Up = GetVector3("up", exrVector3::Up());
+        camera.m_Fov = GetFloat("fov", 40.0f);
+        camera.m_Aperture = GetFloat("aperture", 0.0f);
+        camera.m_FocusDistance = GetFloat("focusdistance", (camera.m_Position - camera.m_LookAt).Magnitude());
+
+        const exrVector2 resolution = GetVector2("resolution", exrVector2(exrFloat(WIDTH), exrFloat(HEIGHT)));
+        if (resolution.x < 1 || resolution.y < 1)
+            m_Tokenizer.Error(m_Directive.m_Line, "Camera resolution must be at least one pixel");
+
+        camera.m_ResolutionX = exrU32(resolution.x);
+        camera.m_ResolutionY = exrU32(resolution.y);
+        m_HasCamera = true;
+    }
+
+    void ParseIntegrator()
+    {
+        const std::string_view type = GetArgument(0, "type");
+        IntegratorDescription& integrator = m_Description.m_Integrator;
+
+        if (type == "path")
+            integrator.m_Type = Integrator::INTEGRATOR_PATHTRACER;
+        else if (type == "wavefront")
+            integrator.m_Type = Integrator::INTEGRATOR_WAVEFRONT;
+        else
+            m_Tokenizer.Error(m_Directive.m_Line, "Unknown integrator type '" + exrString(type) + "'");
+
+        integrator.m_NumSamples = exrU32(exrMax(GetFloat("samples", exrFloat(integrator.m_NumSamples)), 1.0f));
+        integrator.m_NumBounces = exrU32(exrMax(GetFloat("bounces", exrFloat(integrator.m_NumBounces)), 1.0f));
+
+        // All of these are off at 0
+        PathRegularization& regularization = integrator.m_Regularization;
+        regularization.m_MaxDirectRadiance = exrMax(GetFloat("clampdirect", 0.0f), 0.0f);
+        regularization.m_MaxIndirectRadiance = exrMax(GetFloat("clampindirect", 0.0f), 0.0f);
+        regularization.m_MinRoughness = exrClamp(GetFloat("regularize", 0.0f), 0.0f, 1.0f);
+        integrator.m_RadianceCacheCellSize = exrMax(GetFloat("radiancecache", 0.0f), 0.0f);
+    }
+
+    void ParseMaterial()
+    {
+        const std::string_view name = GetArgument(0, "name");
+        const std::string_view type = GetArgument(1, "type");
+
+        MaterialDescription material;
+
+        if (type == "matte")
+        {
+            material.m_Type = MaterialDescription::MATERIALTYPE_MATTE;
+            material.m_Color = GetColor("albedo", exrVector3(1.0f));
+            material.m_Value = GetFloat("roughness", 0.0f);
+        }
+        else if (type == "metal")
+        {
+            material.m_Type = MaterialDescription::MATERIALTYPE_METAL;
+            material.m_Color = GetColor("specular", exrVector3(1.0f));
+            material.m_Value = 0.0f;
+        }
+        else if (type == "dielectric")
+        {
+            material.m_Type = MaterialDescription::MATERIALTYPE_DIELECTRIC;
+            material.m_Color = GetColor("diffuse", exrVector3(1.0f));
+            material.m_Value = GetFloat("specular", 0.5f);
+        }
+        else
+            m_Tokenizer.Error(m_Directive.m_Line, "Unknown material type '" + exrString(type) + "'");
+
+        material.m_Emission = GetColor("emission", exrVector3::Zero());
+
+        if (!m_Materials.emplace(name, exrU32(m_Description.m_Materials.size())).second)
+            m_Tokenizer.Error(m_Directive.m_Line, "Material '" + exrString(name) + "' is already defined");
+
+        m_Description.m_Materials.push_back(material);
+    }
+
+    void ParseShape()
+    {
+        const std::string_view type = GetArgument(0, "type");
+
+        ShapeDescription shape;
+
+        if (type == "sphere")
+        {
+            shape.m_Type = ShapeDescription::SHAPETYPE_SPHERE;
+            shape.m_Size = exrVector2(GetFloat("radius", 1.0f));
+        }
+        else if (type == "quad")
+        {
+            shape.m_Type = ShapeDescription::SHAPETYPE_QUAD;
+            shape.m_Size = GetVector2("size", exrVector2(1.0f));
+        }
+        else
+            m_Tokenizer.Error(m_Directive.m_Line, "Unknown shape type '" + exrString(type) + "'");
+
+        shape.m_Material = GetMaterial();
+        shape.m_Transform = GetTransform();
+        m_Description.m_Shapes.push_back(shape);
+    }
+
+    void ParseMesh()
+    {
+        const std::string_view name = GetArgument(0, "name");
+        const std::string_view file = GetArgument(1, "file name");
+
+        const exrBool isAbsolute = file[0] == '/' || file[0] == '\\' || (file.size() > 1 && file[1] == ':');
+        const exrString path = isAbsolute ? exrString(file) : m_Directory + exrString(file);
+
+        if (!std::ifstream(path))
+            m_Tokenizer.Error(m_Directive.m_Line, "Unable to open mesh file " + path);
+
+        if (!m_Meshes.emplace(name, exrU32(m_Description.m_Meshes.size())).second)
+            m_Tokenizer.Error(m_Directive.m_Line, "Mesh '" + exrString(name) + "' is already defined");
+
+        MeshDescription mesh;
+        mesh.m_FileName = path;
+
+        const exrFloat level = GetFloat("subdivisions", 0.0f);
+        if (level < 0 || level > DisplacementSettings::MaxLevel)
+            m_Tokenizer.Error(m_Directive.m_Line, "Mesh subdivisions must be between 0 and " + std::to_string(DisplacementSettings::MaxLevel));
+
+        mesh.m_Displacement.m_Level = exrU32(level);
+        mesh.m_Displacement.m_Smoothing = exrClamp(GetFloat("smoothing", mesh.m_Displacement.m_Smoothing), 0.0f, 1.0f);
+        mesh.m_Displacement.m_Amplitude = abs(GetFloat("displacement", 0.0f));
+        mesh.m_Displacement.m_Frequency = GetFloat("frequency", mesh.m_Displacement.m_Frequency);
+        m_Description.m_Meshes.push_back(mesh);
+    }
+
+    void ParseInstance()
+    {
+        const std::string_view name = GetArgument(0, "mesh name");
+
+        auto it = m_Meshes.find(name);
+        if (it == m_Meshes.end())
+            m_Tokenizer.Error(m_Directive.m_Line, "Unknown mesh '" + exrString(name) + "'");
+
+        InstanceDescription instance;
+        instance.m_Mesh = it->second;
+        instance.m_Material = GetMaterial();
+        instance.m_HasTransform = HasTransform() ? 1 : 0;
+        instance.m_Transform = GetTransform();
+        m_Description.m_Instances.push_back(instance);
+    }
+
+    void ParseLight()
+    {
+        const std::string_view type = GetArgument(0, "type");
+
+        LightDescription light;
+        light.m_Intensity = GetColor("intensity", exrVector3(1.0f));
+
+        if (type == "point")
+        {
+            light.m_Type = LightDescription::LIGHTTYPE_POINT;
+            light.m_Transform.m_Translation = GetVector3("position", exrVector3::Zero());
+        }
+        else if (type == "directional")
+        {
+            light.m_Type = LightDescription::LIGHTTYPE_DIRECTIONAL;
+            light.m_Transform = GetTransform();
+        }
+        else
+            m_Tokenizer.Error(m_Directive.m_Line, "Unknown light type '" + exrString(type) + "'");
+
+        m_Description.m_Lights.push_back(light);
+    }
+
+private:
+    const exrString& m_FileName;
+    exrString m_Directory;
+    SceneTokenizer m_Tokenizer;
+    SceneDescription& m_Description;
+    exrBool m_HasCamera = false;
+
+    //! The directive that is currently being parsed, along with its arguments and parameters
+    SceneToken m_Directive;
+    std::array<std::string_view, MaxArguments> m_Arguments;
+    exrU32 m_NumArguments = 0;
+    std::array<Parameter, MaxParameters> m_Parameters;
+    exrU32 m_NumParameters = 0;
+
+    //! The numbers of all parameters of the current directive, reused between directives
+    std::vector<exrFloat> m_Floats;
+
+    // Names are views into the source buffer, which outlives the parser
+    std::unordered_map<std::string_view, exrU32> m_Materials;
+    std::unordered_map<std::string_view, exrU32> m_Meshes;
+};
+
+void SceneParser::ParseFile(const exrString& filename, SceneDescription& description)
+{
+    exrProfile("Parsing " + filename);
+
+    std::ifstream file(filename, std::ifstream::ate | std::ifstream::binary);
+    if (!file)
+        throw std::runtime_error("Unable to open scene file " + filename);
+
+    exrString source(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(&source[0], source.size());
+
+    // The profile ends when the function returns, or is reported as failed if the parser throws
+    SceneFileParser parser(filename, source, description);
+    parser.Parse();
+}
+
+exrEND_NAMESPACE
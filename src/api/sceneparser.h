@@ -0,0 +1,59 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/elixir.h"
+
+exrBEGIN_NAMESPACE
+
+struct SceneDescription;
+
+//! @brief Reads a scene file into a scene description
+//!
+//! Scene files follow the spirit of pbrt's format. Each directive is a capitalized word,
+//! followed by quoted arguments and then named parameters. Parameter values are numbers,
+//! quoted strings or bracketed lists of numbers. Anything after a # is a comment.
+//!
+//!     Camera position [0 2.75 10] lookat [0 2.75 0] fov 40 resolution [500 500]
+//!     Integrator "path" samples 64 bounces 8         (or "wavefront")
+//!         clampdirect 0 clampindirect 10 regularize 0.3 radiancecache 0.1
+//!     Material "white" "matte" albedo [1 1 1] roughness 20
+//!     Shape "sphere" material "white" radius 1 translate [0 1 0]
+//!     Mesh "bunny" "models/bunny.obj"
+//!     Instance "bunny" material "white" rotate [0 45 0] scale 2
+//!     Light "point" position [0 5 0] intensity 3
+//!
+//! The whole file is read into memory and tokenized in a single pass. Tokens are views into
+//! that buffer and parameter values go into scratch storage that is reused by every
+//! directive, so nothing is allocated per token.
+class SceneParser
+{
+public:
+    //! @brief Parses a scene file into a scene description
+    //!
+    //! Throws a std::runtime_error naming the file and line of the first error encountered.
+    //!
+    //! @param filename         The path of the scene file
+    //! @param description      Output description of the scene
+    static void ParseFile(const exrString& filename, SceneDescription& description);
+};
+
+exrEND_NAMESPACE
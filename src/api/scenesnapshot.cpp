@@ -0,0 +1,387 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scenesnapshot.h"
+#include "renderjob.h"
+#include "scenebuilder.h"
+
+#include "core/primitive/mesh.h"
+#include "core/primitive/shape/displacedpatch.h"
+#include "core/primitive/shape/triangle.h"
+#include "core/spatial/accelerator/bvh.h"
+
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+exrBEGIN_NAMESPACE
+
+static constexpr exrChar SnapshotMagic[8] = { 'E', 'X', 'R', 'S', 'N', 'A', 'P', '\0' };
+static constexpr exrU32 SnapshotVersion = 6;
+
+//! Every array in the file starts at a multiple of this
+static constexpr exrU64 SnapshotAlignment = 16;
+
+struct SnapshotArray
+{
+    exrU64 m_Offset;
+    exrU64 m_Count;
+};
+
+//! A primitive group. Group 0 holds the shapes of the scene and all others hold one mesh each.
+struct SnapshotGroup
+{
+    exrU32 m_IsPresent;
+    exrU32 m_NumPrimitives;
+
+    //! Three vertices per face. Empty for the shape group.
+    SnapshotArray m_Faces;
+
+    SnapshotArray m_Nodes;
+
+    //! For every primitive in BVH order, the index of the shape or face it was created from
+    SnapshotArray m_PrimitiveIndices;
+
+    //! Displaced meshes store their base faces, which are tessellated lazily as usual
+    DisplacementSettings m_Displacement;
+};
+
+struct SnapshotHeader
+{
+    exrChar m_Magic[8];
+    exrU32 m_Version;
+
+    //! The sizes of all record types, so that snapshots written by incompatible builds are rejected
+    exrU32 m_RecordSizes[9];
+
+    CameraDescription m_Camera;
+    IntegratorDescription m_Integrator;
+
+    SnapshotArray m_Materials;
+    SnapshotArray m_Shapes;
+    SnapshotArray m_Lights;
+    SnapshotArray m_Instances;
+    SnapshotArray m_Groups;
+};
+
+static void GetRecordSizes(exrU32 (&sizes)[9])
+{
+    sizes[0] = sizeof(CameraDescription);
+    sizes[1] = sizeof(IntegratorDescription);
+    sizes[2] = sizeof(MaterialDescription);
+    sizes[3] = sizeof(ShapeDescription);
+    sizes[4] = sizeof(LightDescription);
+    sizes[5] = sizeof(InstanceDescription);
+    sizes[6] = sizeof(SnapshotGroup);
+    sizes[7] = sizeof(LinearBVHNode);
+    sizes[8] = sizeof(Vertex);
+}
+
+//! Appends aligned arrays of records to the snapshot file
+class SnapshotWriter
+{
+public:
+    SnapshotWriter(const exrString& filename)
+        : m_FileName(filename)
+        , m_File(filename, std::ofstream::binary | std::ofstream::trunc)
+    {
+        if (!m_File)
+            throw std::runtime_error("Unable to create snapshot file " + filename);
+    }
+
+    template <typename T>
+    SnapshotArray Write(const T* data, exrU64 count)
+    {
+        static const exrByte padding[SnapshotAlignment] = {};
+        const exrU64 paddingSize = (SnapshotAlignment - m_Size % SnapshotAlignment) % SnapshotAlignment;
+        m_File.write(reinterpret_cast<const exrChar*>(padding), paddingSize);
+        m_Size += paddingSize;
+
+        SnapshotArray array = { m_Size, count };
+        m_File.write(reinterpret_cast<const exrChar*>(data), count * sizeof(T));
+        m_Size += count * sizeof(T);
+        return array;
+    }
+
+    template <typename T>
+    SnapshotArray Write(const std::vector<T>& data)
+    {
+        return Write(data.data(), data.size());
+    }
+
+    void WriteHeader(const SnapshotHeader& header)
+    {
+        m_File.seekp(0);
+        m_File.write(reinterpret_cast<const exrChar*>(&header), sizeof(header));
+        m_File.flush();
+
+        if (!m_File)
+            throw std::runtime_error("Unable to write snapshot file " + m_FileName);
+    }
+
+private:
+    const exrString& m_FileName;
+    std::ofstream m_File;
+    exrU64 m_Size = 0;
+};
+
+static SnapshotGroup WriteGroup(SnapshotWriter& writer, const Scene::PrimitiveGroup& group, const DisplacementSettings& displacement)
+{
+    const BVHAccelerator* bvh = dynamic_cast<const BVHAccelerator*>(group.m_Accelerator.get());
+    if (bvh == nullptr)
+        throw std::runtime_error("Only BVH accelerators can be written to a snapshot");
+
+    // The primitives of a group are created in the order of their shapes or faces
+    std::unordered_map<const Primitive*, exrU32> primitiveIndices;
+    for (exrU32 i = 0; i < group.m_Primitives.size(); ++i)
+        primitiveIndices[group.m_Primitives[i].get()] = i;
+
+    std::vector<exrU32> orderedIndices;
+    orderedIndices.reserve(bvh->GetOrderedPrimitives().size());
+    for (const Primitive* primitive : bvh->GetOrderedPrimitives())
+        orderedIndices.push_back(primitiveIndices.at(primitive));
+
+    SnapshotGroup record = {};
+    record.m_IsPresent = 1;
+    record.m_NumPrimitives = static_cast<exrU32>(group.m_Primitives.size());
+    record.m_Displacement = displacement;
+
+    if (group.m_Mesh != nullptr)
+    {
+        std::vector<Vertex> faces(group.m_Mesh->m_NumFaces * 3);
+        for (exrU32 i = 0; i < group.m_Mesh->m_NumFaces; ++i)
+            group.m_Mesh->GetVertexAtIndex(i, faces[i * 3], faces[i * 3 + 1], faces[i * 3 + 2]);
+
+        record.m_Faces = writer.Write(faces);
+    }
+
+    record.m_Nodes = writer.Write(bvh->GetNodes(), bvh->GetNumNodes());
+    record.m_PrimitiveIndices = writer.Write(orderedIndices);
+    return record;
+}
+
+void SceneSnapshot::Write(const exrString& filename, const RenderJob& job)
+{
+    exrProfile("Writing Scene Snapshot " + filename);
+
+    const SceneDescription& description = job.m_Description;
+    SnapshotWriter writer(filename);
+
+    // Reserve space for the header, which is only complete once everything else is written
+    SnapshotHeader header = {};
+    writer.Write(&header, 1);
+
+    memcpy(header.m_Magic, SnapshotMagic, sizeof(SnapshotMagic));
+    header.m_Version = SnapshotVersion;
+    GetRecordSizes(header.m_RecordSizes);
+    header.m_Camera = description.m_Camera;
+    header.m_Integrator = description.m_Integrator;
+    header.m_Materials = writer.Write(description.m_Materials);
+    header.m_Shapes = writer.Write(description.m_Shapes);
+    header.m_Lights = writer.Write(description.m_Lights);
+    header.m_Instances = writer.Write(description.m_Instances);
+
+    std::vector<SnapshotGroup> groups;
+    for (exrU32 i = 0; i < job.m_PrimitiveGroups.size(); ++i)
+    {
+        const Scene::PrimitiveGroup* group = job.m_PrimitiveGroups[i].get();
+        const DisplacementSettings displacement = i > 0 ? description.m_Meshes[i - 1].m_Displacement : DisplacementSettings();
+        groups.push_back(group != nullptr ? WriteGroup(writer, *group, displacement) : SnapshotGroup{});
+    }
+
+    header.m_Groups = writer.Write(groups);
+    writer.WriteHeader(header);
+
+    exrEndProfile();
+}
+
+//! Reads arrays out of a mapped snapshot, checking that they lie within the file
+class SnapshotReader
+{
+public:
+    SnapshotReader(const exrString& filename, const MappedRegion& region)
+        : m_FileName(filename)
+        , m_Region(region) {};
+
+    template <typename T>
+    const T* Get(const SnapshotArray& array) const
+    {
+        const exrU64 size = m_Region.GetSize();
+        if (array.m_Offset % alignof(T) != 0 || array.m_Offset > size || array.m_Count > (size - array.m_Offset) / sizeof(T))
+            Error("an array lies outside of the file");
+
+        return reinterpret_cast<const T*>(m_Region.GetData() + array.m_Offset);
+    }
+
+    template <typename T>
+    std::vector<T> Copy(const SnapshotArray& array) const
+    {
+        const T* data = Get<T>(array);
+        return std::vector<T>(data, data + array.m_Count);
+    }
+
+    [[noreturn]] void Error(const exrString& message) const
+    {
+        throw std::runtime_error("Invalid scene snapshot " + m_FileName + ": " + message);
+    }
+
+private:
+    const exrString& m_FileName;
+    const MappedRegion& m_Region;
+};
+
+static void ValidateDescription(const SnapshotReader& reader, const SceneDescription& description)
+{
+    const exrU64 numMaterials = description.m_Materials.size();
+
+    for (const ShapeDescription& shape : description.m_Shapes)
+    {
+        if (shape.m_Material >= numMaterials)
+            reader.Error("a shape refers to a material that does not exist");
+    }
+
+    for (const InstanceDescription& instance : description.m_Instances)
+    {
+        if (instance.m_Material >= numMaterials || instance.m_Mesh >= description.m_Meshes.size())
+            reader.Error("an instance refers to a material or mesh that does not exist");
+    }
+}
+
+static std::shared_ptr<Scene::PrimitiveGroup> LoadGroup(const SnapshotReader& reader, const SnapshotGroup& record,
+    const SceneDescription& description, exrU32 groupIndex, Scene& scene, const TessellationCache& tessellationCache)
+{
+    if (!record.m_IsPresent)
+        return nullptr;
+
+    std::shared_ptr<Scene::PrimitiveGroup> group = std::make_shared<Scene::PrimitiveGroup>();
+    group->m_Primitives.reserve(record.m_NumPrimitives);
+
+    if (groupIndex == 0)
+    {
+        if (record.m_NumPrimitives != description.m_Shapes.size())
+            reader.Error("the number of shapes does not match");
+
+        for (const ShapeDescription& shape : description.m_Shapes)
+            group->m_Primitives.push_back(SceneBuilder::CreateShape(shape, scene));
+    }
+    else
+    {
+        if (record.m_Faces.m_Count != exrU64(record.m_NumPrimitives) * 3)
+            reader.Error("the number of faces does not match");
+
+        // The faces are read straight from the mapped file
+        group->m_Mesh = std::make_shared<Mesh>(Mesh::FromFaceRecords(reader.Get<Vertex>(record.m_Faces), record.m_NumPrimitives));
+        const Material* material = scene.GetMaterial(SceneBuilder::GetMeshMaterial(description, groupIndex - 1));
+
+        std::shared_ptr<DisplacedSurface> surface;
+        if (record.m_Displacement.m_Level > 0)
+            surface = std::make_shared<DisplacedSurface>(group->m_Mesh, record.m_Displacement, tessellationCache);
+
+        for (exrU32 i = 0; i < record.m_NumPrimitives; ++i)
+        {
+            std::unique_ptr<Primitive> primitive = std::make_unique<Primitive>();
+            if (surface != nullptr)
+                primitive->SetShape(std::make_unique<DisplacedPatch>(surface, i));
+            else
+                primitive->SetShape(std::make_unique<Triangle>(group->m_Mesh, i));
+            primitive->SetMaterial(material);
+            group->m_Primitives.push_back(std::move(primitive));
+        }
+    }
+
+    // Fix up the primitive pointers that the leaves refer to
+    const exrU32* primitiveIndices = reader.Get<exrU32>(record.m_PrimitiveIndices);
+    std::vector<Primitive*> orderedPrimitives(record.m_PrimitiveIndices.m_Count);
+
+    for (exrU64 i = 0; i < record.m_PrimitiveIndices.m_Count; ++i)
+    {
+        if (primitiveIndices[i] >= record.m_NumPrimitives)
+            reader.Error("a BVH leaf refers to a primitive that does not exist");
+
+        orderedPrimitives[i] = group->m_Primitives[primitiveIndices[i]].get();
+    }
+
+    const LinearBVHNode* nodes = reader.Get<LinearBVHNode>(record.m_Nodes);
+    const exrU64 numNodes = record.m_Nodes.m_Count;
+
+    // Traversal relies on the tree being well formed and no deeper than its fixed size stack allows
+    if (numNodes > std::numeric_limits<exrU32>::max() ||
+        !BVHAccelerator::IsValidTree(nodes, static_cast<exrU32>(numNodes), orderedPrimitives.size()))
+    {
+        reader.Error("the BVH is malformed");
+    }
+
+    group->m_Accelerator = std::make_unique<BVHAccelerator>(nodes, static_cast<exrU32>(numNodes), std::move(orderedPrimitives));
+    return group;
+}
+
+void SceneSnapshot::Load(const exrString& filename, RenderJob& job)
+{
+    exrProfile("Loading Scene Snapshot " + filename);
+
+    std::shared_ptr<MappedRegion> region = MappedFile::MapReadOnly(filename);
+    if (region == nullptr)
+        throw std::runtime_error("Unable to open scene snapshot " + filename);
+
+    SnapshotReader reader(filename, *region);
+    const SnapshotHeader* header = reader.Get<SnapshotHeader>({ 0, 1 });
+
+    exrU32 recordSizes[9];
+    GetRecordSizes(recordSizes);
+
+    if (memcmp(header->m_Magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+        reader.Error("the file is not a scene snapshot");
+    if (header->m_Version != SnapshotVersion || memcmp(header->m_RecordSizes, recordSizes, sizeof(recordSizes)) != 0)
+        reader.Error("the snapshot was written by an incompatible version of Elixir");
+
+    SceneDescription description;
+    description.m_Camera = header->m_Camera;
+    description.m_Integrator = header->m_Integrator;
+    description.m_Materials = reader.Copy<MaterialDescription>(header->m_Materials);
+    description.m_Shapes = reader.Copy<ShapeDescription>(header->m_Shapes);
+    description.m_Lights = reader.Copy<LightDescription>(header->m_Lights);
+    description.m_Instances = reader.Copy<InstanceDescription>(header->m_Instances);
+
+    const SnapshotGroup* groups = reader.Get<SnapshotGroup>(header->m_Groups);
+    const exrU64 numGroups = header->m_Groups.m_Count;
+    if (numGroups == 0)
+        reader.Error("the shape group is missing");
+
+    // The meshes are embedded in the snapshot, so their original files are not needed
+    description.m_Meshes.resize(numGroups - 1, { filename, DisplacementSettings() });
+    for (exrU32 i = 1; i < numGroups; ++i)
+        description.m_Meshes[i - 1].m_Displacement = groups[i].m_Displacement;
+
+    ValidateDescription(reader, description);
+
+    job.m_Snapshot = region;
+    SceneBuilder::BuildWithoutGeometry(description, job);
+
+    std::vector<std::shared_ptr<Scene::PrimitiveGroup>> primitiveGroups;
+    for (exrU32 i = 0; i < numGroups; ++i)
+        primitiveGroups.push_back(LoadGroup(reader, groups[i], description, i, *job.m_Scene, *job.m_TessellationCache));
+
+    SceneBuilder::AddGeometry(description, job, std::move(primitiveGroups));
+    job.m_Description = std::move(description);
+
+    exrEndProfile();
+}
+
+exrEND_NAMESPACE
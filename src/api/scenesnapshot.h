@@ -0,0 +1,55 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/elixir.h"
+
+exrBEGIN_NAMESPACE
+
+struct RenderJob;
+
+//! @brief A binary image of a fully prepared scene
+//!
+//! A snapshot holds the scene description, the faces of every mesh and the flattened
+//! accelerators, all as plain records. Loading a snapshot maps the file into memory and
+//! only creates the primitive objects around the mapped data, skipping mesh parsing and
+//! accelerator builds entirely. Mesh faces and accelerator nodes are read straight from
+//! the mapping, so they are paged in by the OS as they are needed.
+//!
+//! Snapshots are only meant to be loaded by the same build that wrote them.
+class SceneSnapshot
+{
+public:
+    //! @brief Writes a snapshot of a render job that has been built from a scene description
+    //! @param filename         The path of the snapshot file
+    //! @param job              The render job to write
+    static void Write(const exrString& filename, const RenderJob& job);
+
+    //! @brief Maps a snapshot and sets up the camera, scene and integrator of a render job
+    //!
+    //! Throws a std::runtime_error if the file is not a valid snapshot.
+    //!
+    //! @param filename         The path of the snapshot file
+    //! @param job              The render job to set up
+    static void Load(const exrString& filename, RenderJob& job);
+};
+
+exrEND_NAMESPACE
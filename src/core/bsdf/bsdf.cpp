@@ -26,9 +26,9 @@ exrBEGIN_NAMESPACE
 
 BSDF::BSDF(const SurfaceInteraction& si)
     : m_Normal(si.m_Normal)
-    , m_Tangent(Cross(m_Normal, UniformSampleSphere().Normalized()))
-    , m_Bitangent(Cross(m_Normal, m_Tangent).Normalized())
 {
+    // All BxDFs are isotropic, so any orthonormal frame around the normal will do
+    CoordinateSystem(m_Normal, &m_Tangent, &m_Bitangent);
 }
 
 void BSDF::AddComponent(BxDF* bxdf)
@@ -46,6 +46,12 @@ exrU32 BSDF::GetNumComponents(BxDF::BxDFType flags) const
     return res;
 }
 
+exrBool BSDF::IsDiffuse() const
+{
+    const BxDF::BxDFType diffuseFlags = BxDF::BxDFType(BxDF::BXDFTYPE_ALL & ~(BxDF::BXDFTYPE_GLOSSY | BxDF::BXDFTYPE_SPECULAR));
+    return m_NumBxDF > 0 && GetNumComponents(diffuseFlags) == m_NumBxDF;
+}
+
 exrSpectrum BSDF::f(const exrVector3& worldWo, const exrVector3& worldWi, BxDF::BxDFType flags) const
 {
     exrVector3 wi = WorldToLocal(worldWi);
@@ -71,12 +77,13 @@ exrSpectrum BSDF::f(const exrVector3& worldWo, const exrVector3& worldWi, BxDF::
     return res;
 }
 
-exrSpectrum BSDF::Sample_f(const exrVector3& worldWo, exrVector3* worldWi, exrFloat* pdf, BxDF::BxDFType flags)
+exrSpectrum BSDF::Sample_f(const exrVector3& worldWo, exrVector3* worldWi, exrFloat uComponent, const exrPoint2& u,
+    exrFloat* pdf, BxDF::BxDFType flags, BxDF::BxDFType* sampledType)
 {
     // We can only sample one bxdf at a time, but since we may have more than one bxdf we will randomly select
     // one that matches the criteria.
 
-    BxDF* sampledBxDF = GetRandomBxDF(flags);
+    BxDF* sampledBxDF = ChooseBxDF(uComponent, flags);
 
     if (sampledBxDF == nullptr)
     {
@@ -84,11 +91,14 @@ exrSpectrum BSDF::Sample_f(const exrVector3& worldWo, exrVector3* worldWi, exrFl
         return exrSpectrum(0.0f);
     }
 
+    if (sampledType != nullptr)
+        *sampledType = sampledBxDF->GetType();
+
     exrU32 numMatchingBxdfs = GetNumComponents(flags);
 
     exrVector3 wo = WorldToLocal(worldWo);
     exrVector3 wi;
-    sampledBxDF->Sample_f(wo, &wi, pdf);
+    sampledBxDF->Sample_f(wo, &wi, u, pdf);
 
     if (pdf == 0)
         return exrSpectrum(0.0f);
@@ -113,6 +123,35 @@ exrSpectrum BSDF::Sample_f(const exrVector3& worldWo, exrVector3* worldWi, exrFl
     return f(worldWo, *worldWi, flags);
 }
 
+exrFloat BSDF::Pdf(const exrVector3& worldWo, const exrVector3& worldWi, BxDF::BxDFType flags) const
+{
+    exrU32 numMatchingBxdfs = GetNumComponents(flags);
+    if (numMatchingBxdfs == 0)
+        return 0.0f;
+
+    exrVector3 wo = WorldToLocal(worldWo);
+    exrVector3 wi = WorldToLocal(worldWi);
+    exrFloat pdf = 0.0f;
+
+    for (exrU32 i = 0; i < m_NumBxDF; ++i)
+    {
+        if (m_BxDFs[i]->MatchesFlags(flags))
+            pdf += m_BxDFs[i]->Pdf(wo, wi);
+    }
+
+    return pdf / numMatchingBxdfs;
+}
+
+void BSDF::Regularize(exrFloat roughness, MemoryArena& arena)
+{
+    for (exrU32 i = 0; i < m_NumBxDF; ++i)
+    {
+        BxDF* rougher = m_BxDFs[i]->Regularize(roughness, arena);
+        if (rougher != nullptr)
+            m_BxDFs[i] = rougher;
+    }
+}
+
 exrVector3 BSDF::WorldToLocal(const exrVector3& v) const
 {
     return exrVector3(Dot(v, m_Bitangent), Dot(v, m_Tangent), Dot(v, m_Normal));
@@ -125,11 +164,13 @@ exrVector3 BSDF::LocalToWorld(const exrVector3& v) const
                       m_Bitangent.z * v.x + m_Tangent.z * v.y + m_Normal.z * v.z);
 }
 
-BxDF* BSDF::GetRandomBxDF(BxDF::BxDFType type)
+BxDF* BSDF::ChooseBxDF(exrFloat u, BxDF::BxDFType type)
 {
     exrU32 numMatching = GetNumComponents(type);
+    if (numMatching == 0)
+        return nullptr;
 
-    exrU32 counter = Random::UniformUInt32(numMatching - 1);
+    exrU32 counter = exrMin(exrU32(u * numMatching), numMatching - 1);
 
     for (exrU32 i = 0; i < m_NumBxDF; ++i)
     {
@@ -34,18 +34,34 @@ public:
 
     void AddComponent(BxDF* b);
     exrU32 GetNumComponents(BxDF::BxDFType flags = BxDF::BxDFType::BXDFTYPE_ALL) const;
+
+    //! @brief Returns true if every component is diffuse, so that the surface looks the same from every direction
+    exrBool IsDiffuse() const;
     exrSpectrum f(const exrVector3& worldWo, const exrVector3& worldWi, BxDF::BxDFType flags = BxDF::BxDFType::BXDFTYPE_ALL) const;
-    exrSpectrum Sample_f(const exrVector3& worldWo, exrVector3* worldWi, exrFloat* pdf, BxDF::BxDFType flags);
+
+    //! @brief Samples an incoming direction from one of the components that match the flags
+    //! @param uComponent       A uniform 1D sample that picks the component
+    //! @param u                A uniform 2D sample that the direction is generated from
+    //! @param sampledType      Outputs the type of the component that was sampled, if not null
+    exrSpectrum Sample_f(const exrVector3& worldWo, exrVector3* worldWi, exrFloat uComponent, const exrPoint2& u,
+        exrFloat* pdf, BxDF::BxDFType flags, BxDF::BxDFType* sampledType = nullptr);
+
+    //! @brief Returns the pdf that Sample_f() samples worldWi with, given worldWo
+    exrFloat Pdf(const exrVector3& worldWo, const exrVector3& worldWi, BxDF::BxDFType flags = BxDF::BxDFType::BXDFTYPE_ALL) const;
+
+    //! @brief Replaces the components that are smoother than the roughness with rougher ones
+    //! @see BxDF::Regularize()
+    void Regularize(exrFloat roughness, MemoryArena& arena);
 
     inline exrVector3 WorldToLocal(const exrVector3& v) const;
     inline exrVector3 LocalToWorld(const exrVector3& v) const;
 
 private:
-    BxDF* GetRandomBxDF(BxDF::BxDFType type = BxDF::BxDFType::BXDFTYPE_ALL);
+    BxDF* ChooseBxDF(exrFloat u, BxDF::BxDFType type = BxDF::BxDFType::BXDFTYPE_ALL);
 
     const exrVector3 m_Normal;
-    const exrVector3 m_Tangent;
-    const exrVector3 m_Bitangent;
+    exrVector3 m_Tangent;
+    exrVector3 m_Bitangent;
 
     exrU32 m_NumBxDF = 0;
     BxDF* m_BxDFs[MaxBxDFs];
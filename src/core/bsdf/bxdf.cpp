@@ -24,9 +24,9 @@
 
 exrBEGIN_NAMESPACE
 
-exrSpectrum BxDF::Sample_f(const exrVector3& wo, exrVector3* wi, exrFloat* pdf) const
+exrSpectrum BxDF::Sample_f(const exrVector3& wo, exrVector3* wi, const exrPoint2& u, exrFloat* pdf) const
 {
-    *wi = CosineSampleHemisphere();
+    *wi = CosineSampleHemisphere(u);
     if (wo.z < 0)
         wi->z *= -1;
 
@@ -61,6 +61,8 @@ public:
     //!                         False otherwise.
     exrBool HasFlags(BxDFType t) const { return (m_BxDFType & t) == t; }
 
+    BxDFType GetType() const { return m_BxDFType; }
+
     //! @brief Computes the value of the distribution given a pair of directions
     //!
     //! Given two input directions, determine the color based on the BxDF. This is
@@ -81,9 +83,10 @@ public:
     //!
     //! @param wo               The outgoing direction of the BxDF
     //! @param wi               Outputs a possible incoming direction given wo
+    //! @param u                A uniform 2D sample that the direction is generated from
     //! @param pdf              Outputs the pdf associated with wi->wo
     //! @return                 The output value of the BxDF
-    virtual exrSpectrum Sample_f(const exrVector3& wo, exrVector3* wi, exrFloat* pdf) const;
+    virtual exrSpectrum Sample_f(const exrVector3& wo, exrVector3* wi, const exrPoint2& u, exrFloat* pdf) const;
 
     //! @brief Computes the hemispherical-directional reflectance of a outgoing direction.
     //! 
@@ -104,6 +107,15 @@ public:
     //! @return                 The pdf associated with wi->wo
     virtual exrFloat Pdf(const exrVector3& wo, const exrVector3& wi) const;
 
+    //! @brief Returns a rougher copy of a near-specular BxDF, allocated from the arena
+    //!
+    //! Path regularization replaces sharp lobes with rougher ones after the first bounce, which
+    //! trades a little blur in reflections of reflections for far fewer fireflies.
+    //!
+    //! @param roughness        The roughness that the lobe should have at least
+    //! @return                 The rougher BxDF, or nullptr if this BxDF is rough enough already
+    virtual BxDF* Regularize(exrFloat roughness, MemoryArena& arena) const { return nullptr; }
+
 protected:
 
     //! @brief Checks if a pair of directions is in the same hemisphere
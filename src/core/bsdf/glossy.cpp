@@ -0,0 +1,76 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "glossy.h"
+#include "core/bsdf/fresnel.h"
+
+exrBEGIN_NAMESPACE
+
+GlossyReflection::GlossyReflection(const exrSpectrum& r, exrFloat roughness)
+    : BxDF(BxDFType(BXDFTYPE_HAS_REFLECTANCE | BXDFTYPE_GLOSSY))
+    , m_Specular(r)
+{
+    // The Phong exponent that matches the width of a Beckmann distribution of this roughness
+    const exrFloat alpha = exrClamp(roughness, 0.01f, 1.0f);
+    m_Exponent = 2.0f / (alpha * alpha) - 2.0f;
+}
+
+exrSpectrum GlossyReflection::f(const exrVector3& wo, const exrVector3& wi) const
+{
+    const exrFloat pdf = Pdf(wo, wi);
+    if (pdf == 0.0f)
+        return 0;
+
+    // Same fresnel term as a mirror
+    exrFloat vDotH = Dot(wi, exrVector3::Forward());
+    return Fresnel::FrSchlick(m_Specular, vDotH) * pdf;
+}
+
+exrSpectrum GlossyReflection::Sample_f(const exrVector3& wo, exrVector3* wi, const exrPoint2& u, exrFloat* pdf) const
+{
+    // Sample the angle to the mirror direction in proportion to the lobe, in a frame around the mirror direction
+    const exrVector3 reflectDir = Reflect(-wo, exrVector3::Forward()).Normalized();
+    exrVector3 tangent, bitangent;
+    CoordinateSystem(reflectDir, &tangent, &bitangent);
+
+    const exrFloat cosAlpha = pow(u.x, 1.0f / (m_Exponent + 1.0f));
+    const exrFloat sinAlpha = sqrt(exrMax(0.0f, 1.0f - cosAlpha * cosAlpha));
+    const exrFloat phi = 2 * EXR_M_PI * u.y;
+
+    *wi = sinAlpha * cos(phi) * tangent + sinAlpha * sin(phi) * bitangent + cosAlpha * reflectDir;
+    *pdf = Pdf(wo, *wi);
+
+    return f(wo, *wi);
+}
+
+exrFloat GlossyReflection::Pdf(const exrVector3& wo, const exrVector3& wi) const
+{
+    if (!IsSameHemisphere(wo, wi))
+        return 0.0f;
+
+    const exrFloat cosAlpha = Dot(Reflect(-wo, exrVector3::Forward()).Normalized(), wi.Normalized());
+    if (cosAlpha <= 0.0f)
+        return 0.0f;
+
+    return (m_Exponent + 1.0f) * EXR_M_INV2PI * pow(cosAlpha, m_Exponent);
+}
+
+exrEND_NAMESPACE
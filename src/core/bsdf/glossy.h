@@ -0,0 +1,49 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "bxdf.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A glossy reflection lobe around the mirror direction
+//!
+//! The lobe is a normalized Phong lobe that is sampled exactly, so its weight f * cos / pdf
+//! equals that of a perfect mirror. Integrators use it in place of a mirror to regularize
+//! paths, since unlike a mirror it can be reached by light samples.
+class GlossyReflection : public BxDF
+{
+public:
+    //! @param r                The specular color at normal incidence
+    //! @param roughness        The width of the lobe, from 0 (a mirror) to 1
+    GlossyReflection(const exrSpectrum& r, exrFloat roughness);
+
+    exrSpectrum f(const exrVector3& wo, const exrVector3& wi) const override;
+    exrSpectrum Sample_f(const exrVector3& wo, exrVector3* wi, const exrPoint2& u, exrFloat* pdf) const override;
+    exrSpectrum rho(const exrVector3& wo, exrU32 numSamples) const override { return m_Specular; }
+    exrFloat Pdf(const exrVector3& wo, const exrVector3& wi) const override;
+
+private:
+    exrSpectrum m_Specular;
+    exrFloat m_Exponent;
+};
+exrEND_NAMESPACE
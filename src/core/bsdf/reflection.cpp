@@ -22,6 +22,7 @@
 
 #include "reflection.h"
 #include "core/bsdf/fresnel.h"
+#include "core/bsdf/glossy.h"
 
 exrBEGIN_NAMESPACE
 
@@ -37,7 +38,7 @@ exrSpectrum Reflection::f(const exrVector3& wo, const exrVector3& wi) const
     return Fresnel::FrSchlick(m_Specular, vDotH);
 }
 
-exrSpectrum Reflection::Sample_f(const exrVector3& wo, exrVector3* wi, exrFloat* pdf) const
+exrSpectrum Reflection::Sample_f(const exrVector3& wo, exrVector3* wi, const exrPoint2& u, exrFloat* pdf) const
 {
     // local space normal is always z forward
     *wi = Reflect(-wo, exrVector3::Forward());
@@ -51,5 +52,10 @@ exrSpectrum Reflection::rho(const exrVector3& wo, exrU32 numSamples) const
     return m_Specular * EXR_M_INVPI;
 }
 
+BxDF* Reflection::Regularize(exrFloat roughness, MemoryArena& arena) const
+{
+    return EXR_ARENA_ALLOC(arena, GlossyReflection)(m_Specular, roughness);
+}
+
 exrEND_NAMESPACE
 
@@ -32,8 +32,9 @@ public:
         , m_Specular(r) {};
 
     exrSpectrum f(const exrVector3& wo, const exrVector3& wi) const override;
-    exrSpectrum Sample_f(const exrVector3& wo, exrVector3* wi, exrFloat* pdf) const override;
+    exrSpectrum Sample_f(const exrVector3& wo, exrVector3* wi, const exrPoint2& u, exrFloat* pdf) const override;
     exrSpectrum rho(const exrVector3& wo, exrU32 numSamples) const override;
+    BxDF* Regularize(exrFloat roughness, MemoryArena& arena) const override;
 
 protected:
     exrSpectrum m_Specular;
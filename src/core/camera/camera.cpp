@@ -24,13 +24,14 @@
 
 exrBEGIN_NAMESPACE
 
-Camera::Camera(exrPoint3 position, exrPoint3 lookat, exrVector3 up, exrFloat vfov, exrFloat aperture, exrFloat focusDist) {
+Camera::Camera(exrPoint3 position, exrPoint3 lookat, exrVector3 up, exrFloat vfov, exrFloat aperture, exrFloat focusDist,
+    const Point2<exrU32>& resolution) {
     // virtual lens to simulate defocus blur
     lensRadius = aperture / 2.0f;
             
     exrFloat theta = vfov * exrFloat(EXR_M_PI) / 180.f;
     exrFloat halfHeight = tan(theta / 2.0f);
-    exrFloat aspect = WIDTH / (exrFloat)HEIGHT;
+    exrFloat aspect = resolution.x / (exrFloat)resolution.y;
     exrFloat halfWidth = aspect * halfHeight;
 
     m_Position = position;
@@ -42,12 +43,12 @@ Camera::Camera(exrPoint3 position, exrPoint3 lookat, exrVector3 up, exrFloat vfo
     m_HorizontalStep = 2.0f * halfWidth * focusDist * u;
     m_VerticalStep = 2.0f * halfHeight * focusDist * v;
 
-    m_Exporter = std::make_unique<Exporter>(Point2<exrU32>(WIDTH, HEIGHT), g_RuntimeOptions.outputFile, g_RuntimeOptions.stampFile);
+    m_Exporter = std::make_unique<Exporter>(resolution, g_RuntimeOptions.outputFile, g_RuntimeOptions.stampFile);
 }
 
-Ray Camera::GetViewRay(exrFloat s, exrFloat t) 
+Ray Camera::GetViewRay(exrFloat s, exrFloat t, const exrPoint2& lensSample) 
 { 
-    exrPoint2 randomDiscOffset = RejectionSampleDisk();
+    exrPoint2 randomDiscOffset = ConcentricSampleDisk(lensSample);
     exrVector3 rd = lensRadius * exrVector3(randomDiscOffset.x, randomDiscOffset.y, 0);
     exrVector3 offset = u * rd.x + v * rd.y;
     return Ray(m_Position + offset, m_Min + s * m_HorizontalStep + t * m_VerticalStep - m_Position - offset); 
@@ -45,13 +45,16 @@ public:
     //! @param aspect            The aspect ratio of the expected output
     //! @param aperture          The aperture of the camera
     //! @param focusDist         The distance away from the camera's focus plane
-    Camera(exrPoint3 position, exrPoint3 lookat, exrVector3 up, exrFloat vfov, exrFloat aperture, exrFloat focusDist);
+    //! @param resolution        The resolution of the output image in pixels
+    Camera(exrPoint3 position, exrPoint3 lookat, exrVector3 up, exrFloat vfov, exrFloat aperture, exrFloat focusDist,
+        const Point2<exrU32>& resolution = Point2<exrU32>(WIDTH, HEIGHT));
 
     //! @brief Creates a view ray based from a uv coordinate
     //!
     //! @param s                The u coordinate of the ray in screen space
     //! @param t                The v coordinate of the ray in screen space
-    Ray GetViewRay(exrFloat s, exrFloat t);
+    //! @param lensSample       A uniform 2D sample that picks the point on the lens
+    Ray GetViewRay(exrFloat s, exrFloat t, const exrPoint2& lensSample);
 
 public:
     std::unique_ptr<Exporter> m_Exporter;
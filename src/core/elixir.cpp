@@ -20,10 +20,12 @@
 
 #include "core/elixir.h"
 #include "api/api.h"
+#include <csignal>
 
 using namespace elixir;
 
 static ElixirOptions g_RuntimeOptions;
+static volatile std::sig_atomic_t g_IsInterrupted = 0;
 
 void PrintTitle()
 {
@@ -38,14 +40,28 @@ void PrintUsage(const exrChar* msg = nullptr)
         fprintf(stderr, "elixir: %s\n\n", msg);
 
     using namespace std;
-    cout << "Usage: elixir [options] <One or more scene files>" << endl << endl;
+    cout << "Usage: elixir [options] <One or more .scene, .snapshot or .obj files>" << endl << endl;
     cout << "Rendering Options: " << endl;
     cout << "   -h, --help              Display this help page" << endl;
     cout << "   -t, --numthreads        Specify the number of rendering threads to use" << endl;
+    cout << "   --pin                   Pin threads to processors and keep scene data local to each NUMA node" << endl;
+    cout << "   --tileorder <order>     Render tiles in hilbert (default), morton, spiral or scanline order" << endl;
+    cout << "   --tilesize <pixels>     Use square tiles of this size instead of choosing one automatically" << endl;
+    cout << "   --sampler <type>        Take samples from a sobol (default), halton, stratified or independent sampler" << endl;
+    cout << "   --lightsampler <type>   Choose lights for direct lighting with a bvh (default), power or uniform light sampler" << endl;
+    cout << "   --wavefront             Trace paths in stages with the wavefront integrator" << endl;
+    cout << "   --progressive <spp>     Render in passes of <spp> samples, writing the image after every pass" << endl;
+    cout << "   --adaptive <error>      Stop sampling pixels once their relative error is below <error>, e.g. 0.01" << endl;
     cout << "   -o, --out <fname>       Write the output image to a specified filename" << endl;
     cout << "   -s, --stamp             Stamp output filename with metadata" << endl;
     cout << "   -q, --quick             Reduce output quality for quick render" << endl;
     cout << "   -d, --debug             Render debug scene defined in code. To be deprecated." << endl;
+    cout << "   --outofcore <MB>        Page mesh data from a cache file, keeping at most <MB> resident" << endl;
+    cout << "   --cachedir <dir>        Write the --outofcore cache file to <dir> instead of the temp directory" << endl;
+    cout << "   --tesscache <MB>        Keep at most <MB> of lazily tessellated geometry resident" << endl;
+    cout << "   -c, --compile           Write a precompiled .snapshot of the scene instead of rendering it" << endl;
+    cout << "   --timelimit <seconds>   Stop rendering each job after <seconds> and write the partial image" << endl;
+    cout << "   --pathstats             Log the energy that paths find at every depth, and how much clamping removes" << endl;
     cout << "Logging Options: " << endl;
     cout << "   --quiet                 Suppress all non-error messages" << endl;
     cout << "For documentations, please refer to <http://docs.elixir.moe/>" << endl;
@@ -55,6 +71,60 @@ void PrintUsage(const exrChar* msg = nullptr)
     #endif
 }
 
+exrBool IsSceneFile(const exrString& filename)
+{
+    return HasExtension(filename, ".scene") || HasExtension(filename, ".snapshot");
+}
+
+// Returns the file name without its directory and extension
+exrString GetFileStem(const exrString& filename)
+{
+    const size_t begin = filename.find_last_of("/\\") + 1;
+    const size_t end = filename.find_last_of('.');
+    return filename.substr(begin, end != exrString::npos && end > begin ? end - begin : exrString::npos);
+}
+
+// Stops the current render on SIGINT or SIGTERM, still writing the pixels rendered so far.
+// A second signal terminates the process as usual.
+void HandleInterrupt(int signal)
+{
+    g_IsInterrupted = 1;
+    ElixirCancelRender();
+    std::signal(signal, SIG_DFL);
+}
+
+// Renders a single job, returning false if it could not be set up
+exrBool RenderScene(const ElixirOptions& options, const std::vector<exrString>& filenames)
+{
+    exrBool success = true;
+
+    try
+    {
+        ElixirBeginRenderJob(options);
+
+        if (filenames.size() == 1)
+            ElixirParseFile(filenames[0]);
+        else
+            ElixirParseFiles(filenames);
+
+        if (options.compileSnapshot)
+            ElixirCompileScene(options.outputFile + ".snapshot");
+        else
+        {
+            exrInfoLine("Running Elixir with " << options.numThreads << " thread(s)");
+            ElixirRender();
+        }
+    }
+    catch (const std::exception& e)
+    {
+        exrError(e.what());
+        success = false;
+    }
+
+    ElixirEndRenderJob();
+    return success;
+}
+
 int main(int argc, exrChar *argv[])
 {
     ElixirOptions options;
@@ -72,6 +142,40 @@ int main(int argc, exrChar *argv[])
         }
         else if (!strcmp(argv[i], "--numthreads") || !strcmp(argv[i], "-t"))
             options.numThreads = exrMax(options.numThreads, exrU32(atoi(argv[++i])));
+        else if (!strcmp(argv[i], "--pin"))
+            options.pinThreads = true;
+        else if (!strcmp(argv[i], "--tileorder"))
+        {
+            if (i + 1 >= argc || !TileOrdering::ParseTileOrder(argv[++i], options.tileOrder))
+            {
+                PrintUsage("unknown tile order");
+                return -1;
+            }
+        }
+        else if (!strcmp(argv[i], "--sampler"))
+        {
+            if (i + 1 >= argc || !Sampler::ParseSamplerType(argv[++i], options.samplerType))
+            {
+                PrintUsage("unknown sampler");
+                return -1;
+            }
+        }
+        else if (!strcmp(argv[i], "--lightsampler"))
+        {
+            if (i + 1 >= argc || !LightSampler::ParseLightSamplerType(argv[++i], options.lightSamplerType))
+            {
+                PrintUsage("unknown light sampler");
+                return -1;
+            }
+        }
+        else if (!strcmp(argv[i], "--wavefront"))
+            options.wavefront = true;
+        else if (!strcmp(argv[i], "--tilesize"))
+            options.tileSize = exrMax(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--progressive"))
+            options.samplesPerPass = exrMax(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--adaptive"))
+            options.adaptiveThreshold = exrMax(0.0f, exrFloat(atof(argv[++i])));
         else if (!strcmp(argv[i], "--out") || !strcmp(argv[i], "-o"))
             options.outputFile = argv[++i];
         else if (!strcmp(argv[i], "--stamp") || !strcmp(argv[i], "-s"))
@@ -82,41 +186,78 @@ int main(int argc, exrChar *argv[])
             options.quiet = true;
         else if (!strcmp(argv[i], "--debug") || !strcmp(argv[i], "-d"))
             options.debug = true;
+        else if (!strcmp(argv[i], "--tesscache"))
+            options.tessellationCacheBudget = exrMax(exrU64(1), exrU64(atoi(argv[++i])));
+        else if (!strcmp(argv[i], "--compile") || !strcmp(argv[i], "-c"))
+            options.compileSnapshot = true;
+        else if (!strcmp(argv[i], "--timelimit"))
+            options.timeBudget = exrMax(0.0f, exrFloat(atof(argv[++i])));
+        else if (!strcmp(argv[i], "--pathstats"))
+            options.pathStatistics = true;
+        else if (!strcmp(argv[i], "--outofcore"))
+        {
+            options.outOfCore = true;
+            options.geometryCacheBudget = exrMax(exrU64(1), exrU64(atoi(argv[++i])));
+        }
+        else if (!strcmp(argv[i], "--cachedir"))
+            options.cacheDirectory = argv[++i];
         else 
             filenames.push_back(argv[i]);
     }
 
-    ElixirInit(options);
-
     // Process scene description
     if (filenames.size() == 0)
     {
-        if (options.debug)
-            ElixirParseFile("-");
-        else
+        if (!options.debug)
         {
             PrintUsage();
             return -1;
         }
+
+        filenames.push_back("-");
     }
-    else
+
+    // Every scene file is its own render job. All other input meshes are loaded into a single scene.
+    std::vector<exrString> sceneFiles;
+    std::vector<exrString> meshFiles;
+    for (const exrString& filename : filenames)
+        (IsSceneFile(filename) ? sceneFiles : meshFiles).push_back(filename);
+
+    ElixirInit(options);
+    std::signal(SIGINT, HandleInterrupt);
+    std::signal(SIGTERM, HandleInterrupt);
+
+    const exrBool isBatch = sceneFiles.size() + (meshFiles.empty() ? 0 : 1) > 1;
+    exrU32 numFailed = 0;
+
+    for (const exrString& sceneFile : sceneFiles)
     {
-        for (const exrString& f : filenames)
-        {
-            ElixirParseFile(f);
-            break; // Only render the first file. This is a temp solution until the command
-                   // args have been designed to make sense for multiple files (filename, etc.)
-        }
+        if (g_IsInterrupted)
+            break;
+
+        // Keep the output of different jobs apart
+        ElixirOptions sceneOptions = options;
+        if (isBatch)
+            sceneOptions.outputFile += "_" + GetFileStem(sceneFile);
+
+        if (!RenderScene(sceneOptions, { sceneFile }))
+            numFailed++;
     }
 
-    exrInfoLine("Running Elixir with " << options.numThreads << " thread(s)");
+    if (!meshFiles.empty() && !g_IsInterrupted && !RenderScene(options, meshFiles))
+        numFailed++;
+
+    if (g_IsInterrupted)
+        exrWarningLine("Interrupted, remaining render jobs were skipped");
 
-    ElixirRender();
     ElixirCleanup();
 
+    if (numFailed > 0)
+        exrError(numFailed << " render job(s) failed");
+
 #ifdef EXR_PLATFORM_WIN
     system("Pause");
 #endif
    
-    return 0;
+    return numFailed > 0 ? -1 : 0;
 }
@@ -25,6 +25,9 @@
 #include "math/math.h"
 #include "math/conversionutils.h"
 
+#include "core/integrator/tileordering.h"
+#include "core/light/lightsampler.h"
+#include "core/sampling/sampler.h"
 #include "core/interaction/surfaceinteraction.h"
 #include "core/sampling/random.h"
 #include "core/sampling/sampling.h"
@@ -35,11 +38,26 @@ exrBEGIN_NAMESPACE
 struct ElixirOptions
 {
     exrU32          numThreads = 1;
+    exrBool         pinThreads = false;             // Pin every thread to its own processor, spread over NUMA nodes
+    TileOrder       tileOrder = TILEORDER_HILBERT;
+    exrU32          tileSize = 0;                   // In pixels, or 0 to choose from the resolution and thread count
+    SamplerType     samplerType = SAMPLERTYPE_SOBOL;
+    LightSamplerType lightSamplerType = LIGHTSAMPLERTYPE_BVH;
+    exrBool         wavefront = false;              // Render with the wavefront integrator, whatever the scene asks for
+    exrU32          samplesPerPass = 0;             // Render progressively, writing the image after every pass of this many samples (0 = off)
+    exrFloat        adaptiveThreshold = 0.0f;       // Stop sampling pixels whose relative standard error is below this (0 = off)
     exrString       outputFile = "elixir_output";
     exrBool         stampFile = false;
     exrBool         quickRender = false;
     exrBool         quiet = false;
     exrBool         debug = false;
+    exrBool         outOfCore = false;
+    exrU64          geometryCacheBudget = 512;      // In megabytes, only used when outOfCore is set
+    exrString       cacheDirectory;                 // Where outOfCore writes its cache file, or empty for the system temp directory
+    exrU64          tessellationCacheBudget = 256;  // In megabytes, the most tessellated geometry to keep resident
+    exrBool         compileSnapshot = false;        // Write a scene snapshot to <outputFile>.snapshot instead of rendering
+    exrFloat        timeBudget = 0.0f;              // In seconds of rendering per job, or 0 for no limit
+    exrBool         pathStatistics = false;         // Log the energy that paths contribute at every depth, and how much of it is clamped
 };
 
 // Global Varibles / Settings
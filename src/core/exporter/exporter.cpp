@@ -24,9 +24,38 @@
 #include "exporter.h"
 #include "stb/stb_image.h"
 #include "stb/stbi_image_write.h"
+#include <queue>
 
 exrBEGIN_NAMESPACE
 
+ExporterTile::ExporterTile(const Point2<exrU32>& tileMin, const Point2<exrU32>& tileMax)
+    : m_TileMin(tileMin)
+    , m_TileMax(tileMax)
+    , m_Pixels((tileMax.x - tileMin.x) * (tileMax.y - tileMin.y), exrVector3(0.0f))
+    , m_Statistics(m_Pixels.size())
+{
+}
+
+void ExporterTile::WritePixel(const Point2<exrU32>& point, const exrSpectrum& value)
+{
+    const exrU32 index = GetPixelIndex(point);
+    m_Pixels[index] += value.ToRGB();
+    m_Statistics[index].AddSample(value.GetLuminance());
+}
+
+void ExporterTile::WriteErrorPixel(const Point2<exrU32>& point)
+{
+    m_Statistics[GetPixelIndex(point)].m_IsError = true;
+}
+
+exrU32 ExporterTile::GetPixelIndex(const Point2<exrU32>& point) const
+{
+    exrAssert(point.x >= m_TileMin.x && point.x < m_TileMax.x, "Attempting to write to outside tile bounds!");
+    exrAssert(point.y >= m_TileMin.y && point.y < m_TileMax.y, "Attempting to write to outside tile bounds!");
+
+    return (point.y - m_TileMin.y) * (m_TileMax.x - m_TileMin.x) + (point.x - m_TileMin.x);
+}
+
 Exporter::Exporter(const Point2<exrU32>& resolution, const exrString& filename, exrBool stampFile)
     : m_Resolution(resolution)
     , m_FileName(filename)
@@ -35,6 +64,37 @@ Exporter::Exporter(const Point2<exrU32>& resolution, const exrString& filename,
     m_Pixels = std::make_unique<Pixel[]>(m_Resolution.x * m_Resolution.y);
 }
 
+ExporterTile Exporter::CreateTile(const Point2<exrU32>& tileMin, const Point2<exrU32>& tileMax) const
+{
+    const Point2<exrU32> clampedMin(exrMin(tileMin.x, m_Resolution.x), exrMin(tileMin.y, m_Resolution.y));
+    const Point2<exrU32> clampedMax(exrMin(tileMax.x, m_Resolution.x), exrMin(tileMax.y, m_Resolution.y));
+    return ExporterTile(clampedMin, Point2<exrU32>(exrMax(clampedMin.x, clampedMax.x), exrMax(clampedMin.y, clampedMax.y)));
+}
+
+void Exporter::MergeTile(const ExporterTile& tile)
+{
+    const exrU32 tileWidth = tile.m_TileMax.x - tile.m_TileMin.x;
+
+    for (exrU32 y = tile.m_TileMin.y; y < tile.m_TileMax.y; ++y)
+    {
+        for (exrU32 x = tile.m_TileMin.x; x < tile.m_TileMax.x; ++x)
+        {
+            Pixel& pixel = GetPixel(Point2<exrU32>(x, y));
+            const exrU32 index = (y - tile.m_TileMin.y) * tileWidth + (x - tile.m_TileMin.x);
+            const exrVector3& rgb = tile.m_Pixels[index];
+
+            for (exrU32 i = 0; i < 3; ++i)
+                pixel.m_RGB[i] += rgb[i];
+            pixel.m_Statistics.Merge(tile.m_Statistics[index]);
+        }
+    }
+}
+
+const PixelStatistics& Exporter::GetPixelStatistics(const Point2<exrU32>& point) const
+{
+    return GetPixel(point).m_Statistics;
+}
+
 void Exporter::WritePixel(const Point2<exrU32>& point, const exrSpectrum& value)
 {
     exrAssert(point.x >= 0 && point.x <= m_Resolution.x, "Attempting to write to outside image bounds!");
@@ -44,7 +104,8 @@ void Exporter::WritePixel(const Point2<exrU32>& point, const exrSpectrum& value)
     exrVector3 rgb = value.ToRGB();
     
     for (exrU32 i = 0; i < 3; ++i)
-        pixel.m_RGB[i].Add(rgb[i]);
+        pixel.m_RGB[i] += rgb[i];
+    pixel.m_Statistics.AddSample(value.GetLuminance());
 }
 
 void Exporter::WriteErrorPixel(const Point2<exrU32>& point)
@@ -52,13 +113,10 @@ void Exporter::WriteErrorPixel(const Point2<exrU32>& point)
     exrAssert(point.x >= 0 && point.x <= m_Resolution.x, "Attempting to write to outside image bounds!");
     exrAssert(point.y >= 0 && point.y <= m_Resolution.y, "Attempting to write to outside image bounds!");
 
-    Pixel& pixel = GetPixel(point);
-    pixel.m_RGB[0] = 1;
-    pixel.m_RGB[1] = 0;
-    pixel.m_RGB[2] = 1;
+    GetPixel(point).m_Statistics.m_IsError = true;
 }
 
-void Exporter::WriteImage(exrFloat splatScale)
+void Exporter::WriteImage(exrBool isIntermediate)
 {
     exrProfile("Image File Export");
     // PPM Headers
@@ -70,12 +128,18 @@ void Exporter::WriteImage(exrFloat splatScale)
     buffer.resize(buffer.size() + m_Resolution.x * m_Resolution.y * sizeof(exrByte) * 3);
     memcpy(buffer.data(), header.c_str(), strlen(header.c_str()));
 
-    for (exrU32 y = 0; y < m_Resolution.y; ++y)
+    ParallelFor(0, m_Resolution.y, 16, [&](exrU64 y)
     {
         for (exrU32 x = 0; x < m_Resolution.x; ++x)
         {
-            Pixel& pixel = GetPixel(Point2<exrU32>(x, y));
+            Pixel& pixel = GetPixel(Point2<exrU32>(x, exrU32(y)));
             exrVector3 rgb(pixel.m_RGB[0], pixel.m_RGB[1], pixel.m_RGB[2]);
+            exrFloat splatScale = pixel.m_Statistics.m_NumSamples > 0 ? 1.0f / pixel.m_Statistics.m_NumSamples : 0.0f;
+            if (pixel.m_Statistics.m_IsError)
+            {
+                rgb = exrVector3(1, 0, 1);
+                splatScale = 1.0f;
+            }
 
             exrFloat r = exrSaturate(rgb.r * splatScale);
             exrFloat g = exrSaturate(rgb.g * splatScale);
@@ -92,20 +156,23 @@ void Exporter::WriteImage(exrFloat splatScale)
             buffer[offset + 1] = static_cast<exrByte>(g);
             buffer[offset + 2] = static_cast<exrByte>(b);
         }
-    }
+    });
 
     // hard-coded write to PNG for now
     // TODO: template this
     exrS32 x, y, n;
     stbi_uc* ppmOut = stbi_load_from_memory(buffer.data(), static_cast<int>(buffer.size()), &x, &y, &n, 0);
     exrString filename = m_FileName;
-    if (m_StampFile)
+    if (m_StampFile && !isIntermediate)
         filename += "_" + std::to_string(Timer::TimeSinceEpochMillisec());
     filename += ".png";
 
     stbi_write_png(filename.c_str(), m_Resolution.x, m_Resolution.y, 3, ppmOut, m_Resolution.x * 3);
     stbi_image_free(ppmOut);
 
+    if (isIntermediate)
+        return;
+
 #ifdef EXR_PLATFORM_WIN
     system(filename.c_str());
 #elif defined EXR_PLATFORM_MAC
@@ -122,70 +189,63 @@ void Exporter::FilterImage(exrU32 numIteration, exrU32 kernelRadius)
         const int size = m_Resolution.x * m_Resolution.y;
         std::vector<exrVector3> copy(size);
 
-        for (exrU32 y = 0; y < m_Resolution.y; ++y)
+        ParallelFor(0, size, 4096, [&](exrU64 offset)
         {
-            for (exrU32 x = 0; x < m_Resolution.x; ++x)
-            {
-                exrU32 offset = x + y * m_Resolution.x;
-                copy[offset].r = m_Pixels[offset].m_RGB[0];
-                copy[offset].g = m_Pixels[offset].m_RGB[1];
-                copy[offset].b = m_Pixels[offset].m_RGB[2];
-            }
-        }
+            copy[offset].r = m_Pixels[offset].m_RGB[0];
+            copy[offset].g = m_Pixels[offset].m_RGB[1];
+            copy[offset].b = m_Pixels[offset].m_RGB[2];
+        });
 
-        for (exrU32 y = 0; y < m_Resolution.y; ++y)
+        ParallelFor2D(m_Resolution.x, m_Resolution.y, 32, [&](exrU32 x, exrU32 y)
         {
-            for (exrU32 x = 0; x < m_Resolution.x; ++x)
-            {
-                std::priority_queue<exrFloat> rChannel;
-                std::priority_queue<exrFloat> gChannel;
-                std::priority_queue<exrFloat> bChannel;
+            std::priority_queue<exrFloat> rChannel;
+            std::priority_queue<exrFloat> gChannel;
+            std::priority_queue<exrFloat> bChannel;
 
-                for (exrS32 i = -((exrS32)kernelRadius); i <= (exrS32)kernelRadius; ++i)
+            for (exrS32 i = -((exrS32)kernelRadius); i <= (exrS32)kernelRadius; ++i)
+            {
+                for (exrS32 j = -((exrS32)kernelRadius); j <= (exrS32)kernelRadius; ++j)
                 {
-                    for (exrS32 j = -((exrS32)kernelRadius); j <= (exrS32)kernelRadius; ++j)
-                    {
-                        exrU32 samplePosX = static_cast<exrU32>(x + i);
-                        exrU32 samplePosY = static_cast<exrU32>(y + j);
-
-                        if (samplePosX < 0 || samplePosX >= m_Resolution.x || samplePosY < 0 || samplePosY >= m_Resolution.y)
-                            continue;
-
-                        exrU32 index = samplePosX + samplePosY * m_Resolution.x;
-                        exrVector3 pixel = copy[index];
-                        rChannel.push(pixel[0]);
-                        gChannel.push(pixel[1]);
-                        bChannel.push(pixel[2]);
-                    }
-                }
+                    exrU32 samplePosX = static_cast<exrU32>(x + i);
+                    exrU32 samplePosY = static_cast<exrU32>(y + j);
 
-                exrFloat medianR, medianG, medianB;
-                exrBool isEven = rChannel.size() % 2 == 0;
+                    if (samplePosX < 0 || samplePosX >= m_Resolution.x || samplePosY < 0 || samplePosY >= m_Resolution.y)
+                        continue;
 
-                for (exrU32 i = 0; i < rChannel.size() / 2; ++i)
-                {
-                    rChannel.pop();
-                    gChannel.pop();
-                    bChannel.pop();
+                    exrU32 index = samplePosX + samplePosY * m_Resolution.x;
+                    exrVector3 pixel = copy[index];
+                    rChannel.push(pixel[0]);
+                    gChannel.push(pixel[1]);
+                    bChannel.push(pixel[2]);
                 }
+            }
 
-                medianR = rChannel.top(); rChannel.pop();
-                medianG = gChannel.top(); gChannel.pop();
-                medianB = bChannel.top(); bChannel.pop();
+            exrFloat medianR, medianG, medianB;
+            exrBool isEven = rChannel.size() % 2 == 0;
 
-                if (isEven)
-                {
-                    medianR = (medianR + rChannel.top()) / 2;
-                    medianG = (medianG + gChannel.top()) / 2;
-                    medianB = (medianB + bChannel.top()) / 2;
-                }
+            for (exrU32 i = 0; i < rChannel.size() / 2; ++i)
+            {
+                rChannel.pop();
+                gChannel.pop();
+                bChannel.pop();
+            }
+
+            medianR = rChannel.top(); rChannel.pop();
+            medianG = gChannel.top(); gChannel.pop();
+            medianB = bChannel.top(); bChannel.pop();
 
-                Pixel& currentPixel = GetPixel(Point2<exrU32>(x, y));
-                currentPixel.m_RGB[0] = medianR;
-                currentPixel.m_RGB[1] = medianG;
-                currentPixel.m_RGB[2] = medianB;
+            if (isEven)
+            {
+                medianR = (medianR + rChannel.top()) / 2;
+                medianG = (medianG + gChannel.top()) / 2;
+                medianB = (medianB + bChannel.top()) / 2;
             }
-        }
+
+            Pixel& currentPixel = GetPixel(Point2<exrU32>(x, y));
+            currentPixel.m_RGB[0] = medianR;
+            currentPixel.m_RGB[1] = medianG;
+            currentPixel.m_RGB[2] = medianB;
+        });
     }
 }
 
@@ -195,4 +255,10 @@ Exporter::Pixel& Exporter::GetPixel(const Point2<exrU32>& point)
     return m_Pixels[offset];
 }
 
+const Exporter::Pixel& Exporter::GetPixel(const Point2<exrU32>& point) const
+{
+    exrU32 offset = point.x + (point.y * m_Resolution.x);
+    return m_Pixels[offset];
+}
+
 exrEND_NAMESPACE
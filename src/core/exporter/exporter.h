@@ -24,16 +24,115 @@
 
 exrBEGIN_NAMESPACE
 
+//! @brief The number of samples of a pixel, and the running mean and variance of their luminance
+//!
+//! Samples are added one at a time with Welford's algorithm, and statistics of disjoint sets of
+//! samples (e.g. the passes of a progressive render) are combined with Chan's formula.
+//! A pixel that returned an invalid sample is flagged as an error, and stays flagged through merges.
+struct PixelStatistics
+{
+    exrU32 m_NumSamples = 0;
+    exrFloat m_Mean = 0.0f;
+    exrFloat m_M2 = 0.0f;
+    exrBool m_IsError = false;
+
+    void AddSample(exrFloat luminance)
+    {
+        m_NumSamples++;
+        const exrFloat delta = luminance - m_Mean;
+        m_Mean += delta / m_NumSamples;
+        m_M2 += delta * (luminance - m_Mean);
+    }
+
+    void Merge(const PixelStatistics& other)
+    {
+        m_IsError |= other.m_IsError;
+        if (other.m_NumSamples == 0)
+            return;
+
+        const exrU32 numSamples = m_NumSamples + other.m_NumSamples;
+        const exrFloat delta = other.m_Mean - m_Mean;
+        m_Mean += delta * other.m_NumSamples / numSamples;
+        m_M2 += other.m_M2 + delta * delta * (exrFloat(m_NumSamples) * other.m_NumSamples / numSamples);
+        m_NumSamples = numSamples;
+    }
+
+    //! @brief Returns the standard error of the mean relative to the mean itself
+    //!
+    //! Dark pixels are measured against a floor instead, so that they do not take forever to converge.
+    exrFloat GetRelativeError() const
+    {
+        if (m_NumSamples < 2)
+            return MaxFloat;
+
+        const exrFloat variance = m_M2 / (m_NumSamples - 1);
+        return sqrt(variance / m_NumSamples) / exrMax(m_Mean, 0.01f);
+    }
+};
+
+//! @brief A private block of the image that a single render thread accumulates samples into
+//!
+//! Writing to a tile needs no synchronization. Once all samples are in, the tile is merged into
+//! the exporter in a single pass with Exporter::MergeTile().
+class ExporterTile
+{
+public:
+    //! @brief Creates an empty tile covering [tileMin, tileMax) in image coordinates
+    ExporterTile(const Point2<exrU32>& tileMin, const Point2<exrU32>& tileMax);
+
+    // Warning: WritePixel is an ADDITIVE operation! 
+    void WritePixel(const Point2<exrU32>& point, const exrSpectrum& value);
+
+    //! @brief Flags the pixel as an error, it is written magenta whatever its other samples are
+    void WriteErrorPixel(const Point2<exrU32>& point);
+
+private:
+    friend class Exporter;
+
+    exrU32 GetPixelIndex(const Point2<exrU32>& point) const;
+
+private:
+    Point2<exrU32> m_TileMin;
+    Point2<exrU32> m_TileMax;
+    std::vector<exrVector3> m_Pixels;
+    std::vector<PixelStatistics> m_Statistics;
+};
+
 //! @brief A class writes the final image output of the renderer to a file
 class Exporter
 {
 public:
     Exporter(const Point2<exrU32>& resolution, const exrString& filename, exrBool stampFile = true);
 
-    // Warning: WritePixel is an ADDITIVE operation! 
+    //! @brief Creates an empty tile for the part of [tileMin, tileMax) that lies inside the image
+    ExporterTile CreateTile(const Point2<exrU32>& tileMin, const Point2<exrU32>& tileMax) const;
+
+    //! @brief Adds the samples of a tile to the image
+    //!
+    //! Tiles that do not overlap can be merged from multiple threads at once.
+    void MergeTile(const ExporterTile& tile);
+
+    //! @brief Returns the sample count and luminance statistics of a pixel
+    //!
+    //! Only safe while no other thread merges a tile that covers the pixel.
+    const PixelStatistics& GetPixelStatistics(const Point2<exrU32>& point) const;
+
+    // Warning: WritePixel is an ADDITIVE operation, and is not thread safe.
+    // Render threads should write to an ExporterTile instead.
     void WritePixel(const Point2<exrU32>& point, const exrSpectrum& value);
+
+    //! @brief Flags the pixel as an error, it is written magenta whatever its other samples are
     void WriteErrorPixel(const Point2<exrU32>& point);
-    void WriteImage(exrFloat splatScale);
+
+    //! @brief Writes the average of the samples of every pixel to the output file
+    //!
+    //! Pixels are normalized by their own sample count, so an image that was stopped early
+    //! is as bright as a finished one. Pixels without any samples are written black, and error
+    //! pixels magenta.
+    //! Intermediate images of a progressive render always overwrite the same unstamped file,
+    //! and are never opened in a viewer.
+    void WriteImage(exrBool isIntermediate = false);
+
     void FilterImage(exrU32 numIteration, exrU32 kernelRadius);
 
 public:
@@ -43,10 +142,12 @@ public:
 private:
     struct Pixel
     {
-        AtomicFloat m_RGB[3];
+        exrFloat m_RGB[3];
+        PixelStatistics m_Statistics;
     };
 
     Pixel& GetPixel(const Point2<exrU32>& point);
+    const Pixel& GetPixel(const Point2<exrU32>& point) const;
 
 private:
     std::unique_ptr<Pixel[]> m_Pixels;
@@ -34,9 +34,13 @@ public:
     {
         INTEGRATOR_WITTED, // Deprecated TODO: Remove or re-implement
         INTEGRATOR_PATHTRACER,
+        INTEGRATOR_WAVEFRONT,
     };
 
-    virtual void Render(const Scene& scene) = 0;
+    //! @brief Renders the scene and writes the image, stopping early if the token is cancelled
+    //!
+    //! An early stop still writes the image, with every pixel averaged over the samples it got.
+    virtual void Render(const Scene& scene, const CancellationToken& cancellationToken) = 0;
 };
 
 exrEND_NAMESPACE
\ No newline at end of file
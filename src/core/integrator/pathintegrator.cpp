@@ -24,22 +24,65 @@
 #include "core/scene/scene.h"
 exrBEGIN_NAMESPACE
 
-exrSpectrum PathIntegrator::Li(const Ray& r, const Scene& scene, MemoryArena& arena, exrU32 depth) const
+void PathIntegrator::Render(const Scene& scene, const CancellationToken& cancellationToken)
+{
+    // The cache starts out empty for every render, and fills up as paths finish
+    if (m_RadianceCacheCellSize > 0.0f)
+        m_RadianceCache = std::make_unique<RadianceCache>(m_RadianceCacheCellSize, scene.GetBoundingVolume());
+
+    SamplerIntegrator::Render(scene, cancellationToken);
+
+    if (m_RadianceCache != nullptr)
+        m_RadianceCache->PrintStatistics();
+}
+
+exrSpectrum PathIntegrator::Li(const Ray& r, const Scene& scene, Sampler& sampler, MemoryArena& arena, exrU32 depth) const
+{
+    SurfaceInteraction primaryHit;
+    const exrBool hasHit = scene.Intersect(r, &primaryHit);
+    return Li(r, hasHit ? &primaryHit : nullptr, scene, sampler, arena, depth);
+}
+
+exrSpectrum PathIntegrator::Li(const Ray& r, const SurfaceInteraction* primaryHit, const Scene& scene,
+    Sampler& sampler, MemoryArena& arena, exrU32 depth) const
 {
     exrSpectrum Lo(0.0f);
     exrSpectrum beta(1.0f); // path throughput weight, the product of the BSDF values and cosine terms so far
     Ray ray(r); // Copies the original ray, we will be updating this value at every bounce.
+    exrBool specularBounce = false;
+    exrBool diffuseBounce = false;
+    exrBool isPrimaryRay = true;
+
+    // The diffuse vertices of the path, whose radiance goes into the cache once the path is done
+    RadianceCache::PathVertex cacheVertices[RadianceCache::MaxPathVertices];
+    exrU32 numCacheVertices = 0;
 
     for (exrU32 bounces = 0; bounces <= depth ; ++bounces)
     {
         SurfaceInteraction hitRec;
+        exrBool hasHit;
+
+        // The closest hit of the camera ray is given
+        if (isPrimaryRay)
+        {
+            hasHit = primaryHit != nullptr;
+            if (hasHit)
+                hitRec = *primaryHit;
 
-        if (!scene.Intersect(ray, &hitRec)) {
-            Lo += beta * scene.SampleSkyLight(ray);
+            isPrimaryRay = false;
+        }
+        else
+            hasHit = scene.Intersect(ray, &hitRec);
+
+        if (!hasHit) {
+            Lo += m_Regularization.Clamp(beta * scene.SampleSkyLight(ray), bounces);
             break;
         }
 
-        // TODO: Handle emission here
+        // Direct lighting already accounts for the emission that a diffuse or glossy bounce finds, so
+        // emission is only added for surfaces that the camera sees and after specular bounces
+        if (bounces == 0 || specularBounce)
+            Lo += m_Regularization.Clamp(beta * hitRec.Le(hitRec.m_Wo), bounces);
 
         hitRec.ComputeScatteringFunctions(ray, arena);
 
@@ -52,17 +95,45 @@ exrSpectrum PathIntegrator::Li(const Ray& r, const Scene& scene, MemoryArena& ar
             continue;
         }
 
+        // Sharp lobes past the first bounce mostly make fireflies, so they may be widened
+        if (m_Regularization.IsRegularized(bounces))
+            hitRec.m_BSDF->Regularize(m_Regularization.m_MinRoughness, arena);
+
+        if (m_RadianceCache != nullptr && hitRec.m_BSDF->IsDiffuse())
+        {
+            // Past the first diffuse bounce, the radiance that the rest of the path would find is
+            // blurred by the BSDF anyway, so a cached average is used instead
+            exrSpectrum cachedL;
+            if (diffuseBounce && (hitRec.m_Point - ray.m_Origin).Magnitude() > m_RadianceCache->GetMinDistance() &&
+                m_RadianceCache->Lookup(hitRec.m_Point, hitRec.m_Normal, cachedL))
+            {
+                Lo += m_Regularization.Clamp(beta * cachedL, bounces);
+                break;
+            }
+
+            // Only vertices that were reached the same way as the ones that look the cache up are
+            // added, since the radiance that leaves a rough diffuse surface still varies a little
+            // with the direction
+            if (diffuseBounce && numCacheVertices < RadianceCache::MaxPathVertices)
+                cacheVertices[numCacheVertices++] = { hitRec.m_Point, hitRec.m_Normal, beta, Lo };
+        }
+
         // Sample light sources
-        Lo += beta * UniformSampleOneLight(hitRec, scene, arena);
+        Lo += m_Regularization.Clamp(beta * SampleOneLight(hitRec, scene, sampler, arena), bounces);
 
         // Sample BSDF to get new path direction
         exrVector3 wi;
         exrFloat pdf;
-        exrSpectrum f = hitRec.m_BSDF->Sample_f(hitRec.m_Wo, &wi, &pdf, BxDF::BXDFTYPE_ALL);
+        const exrFloat uComponent = sampler.Get1D();
+        BxDF::BxDFType sampledType;
+        exrSpectrum f = hitRec.m_BSDF->Sample_f(hitRec.m_Wo, &wi, uComponent, sampler.Get2D(), &pdf, BxDF::BXDFTYPE_ALL, &sampledType);
 
         if (f.IsBlack() || pdf == 0.0f)
             break;
 
+        specularBounce = (sampledType & BxDF::BXDFTYPE_SPECULAR) != 0;
+        diffuseBounce = (sampledType & BxDF::BXDFTYPE_DIFFUSE) != 0;
+
         beta *= f * AbsDot(wi, hitRec.m_Normal) / pdf;
         ray = hitRec.SpawnRay(wi);
 
@@ -70,13 +141,16 @@ exrSpectrum PathIntegrator::Li(const Ray& r, const Scene& scene, MemoryArena& ar
         if (bounces > 3)
         {
             exrFloat q = exrMax(0.05f, 1 - beta.GetLuminance());
-            if (Random::UniformFloat() <= q)
+            if (sampler.Get1D() <= q)
                 break;
 
             beta /= 1 - q;
         }
     }
 
+    if (numCacheVertices > 0)
+        m_RadianceCache->AddPath(cacheVertices, numCacheVertices, Lo);
+
     return Lo;
 }
 
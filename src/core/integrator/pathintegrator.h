@@ -21,16 +21,30 @@
 #pragma once
 
 #include "samplerintegrator.h"
+#include "radiancecache.h"
 
 exrBEGIN_NAMESPACE
 
 class PathIntegrator : public SamplerIntegrator
 {
 public:
-    PathIntegrator(Camera* camera, exrU32 numSamplesPerPixel, exrU32 numBouncePerPixel)
-        : SamplerIntegrator(camera, numSamplesPerPixel, numBouncePerPixel) {};
+    //! @param radianceCacheCellSize    The cell size of the radiance cache in scene units, or 0 to trace every path to its end
+    PathIntegrator(Camera* camera, exrU32 numSamplesPerPixel, exrU32 numBouncePerPixel,
+        const PathRegularization& regularization = PathRegularization(), exrFloat radianceCacheCellSize = 0.0f)
+        : SamplerIntegrator(camera, numSamplesPerPixel, numBouncePerPixel, regularization)
+        , m_RadianceCacheCellSize(radianceCacheCellSize) {};
 
-    exrSpectrum Li(const Ray& ray, const Scene& scene, MemoryArena& arena, exrU32 depth = 0) const override;
+    void Render(const Scene& scene, const CancellationToken& cancellationToken) override;
+
+    exrSpectrum Li(const Ray& ray, const Scene& scene, Sampler& sampler, MemoryArena& arena, exrU32 depth = 0) const override;
+    exrSpectrum Li(const Ray& ray, const SurfaceInteraction* primaryHit, const Scene& scene,
+        Sampler& sampler, MemoryArena& arena, exrU32 depth) const override;
+
+private:
+    exrFloat m_RadianceCacheCellSize;
+
+    //! Paths end in the cache after their first diffuse bounce, once it knows the surface they reach
+    std::unique_ptr<RadianceCache> m_RadianceCache;
 };
 
 exrEND_NAMESPACE
\ No newline at end of file
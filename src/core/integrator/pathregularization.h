@@ -0,0 +1,76 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "core/elixir.h"
+#include "pathstatistics.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief Settings that bound the radiance of paths, at the cost of some bias
+//!
+//! Paths that reach a bright light through a chain of unlikely bounces leave fireflies that
+//! take many samples to average out. Clamping limits the radiance that a single contribution
+//! may add to a sample, and regularization widens sharp lobes after the first bounce, so that
+//! light sampling can find such paths instead.
+struct PathRegularization
+{
+    //! The highest luminance of a contribution at the surfaces seen by the camera, or 0 for no limit
+    exrFloat m_MaxDirectRadiance = 0.0f;
+    //! The highest luminance of a contribution after one or more bounces, or 0 for no limit
+    exrFloat m_MaxIndirectRadiance = 0.0f;
+    //! The roughness that specular lobes are widened to after the first bounce, or 0 to keep them sharp
+    exrFloat m_MinRoughness = 0.0f;
+
+    //! @brief Returns true if any clamping or regularization is applied
+    inline exrBool IsEnabled() const { return m_MaxDirectRadiance > 0.0f || m_MaxIndirectRadiance > 0.0f || m_MinRoughness > 0.0f; }
+
+    //! @brief Clamps radiance that a path adds to its sample
+    //!
+    //! While path statistics are enabled, the contribution is also recorded in the statistics of
+    //! the calling thread, whether or not it is clamped.
+    //!
+    //! @param depth            The number of bounces before the contribution, 0 for surfaces seen by the camera
+    exrSpectrum Clamp(const exrSpectrum& L, exrU32 depth) const
+    {
+        const exrFloat maxLuminance = depth == 0 ? m_MaxDirectRadiance : m_MaxIndirectRadiance;
+        const exrBool recordStatistics = PathStatistics::IsEnabled();
+        if ((maxLuminance <= 0.0f && !recordStatistics) || L.IsBlack())
+            return L;
+
+        const exrFloat luminance = L.GetLuminance();
+        const exrBool isClamped = maxLuminance > 0.0f && luminance > maxLuminance;
+
+        if (recordStatistics)
+            PathStatistics::GetThreadStatistics().AddContribution(depth, luminance, isClamped ? maxLuminance : luminance);
+
+        if (!isClamped)
+            return L;
+
+        return L * (maxLuminance / luminance);
+    }
+
+    //! @brief Returns true if the BSDFs of a path should be regularized at a depth
+    inline exrBool IsRegularized(exrU32 depth) const { return m_MinRoughness > 0.0f && depth > 0; }
+};
+
+exrEND_NAMESPACE
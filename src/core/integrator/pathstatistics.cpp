@@ -0,0 +1,84 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "pathstatistics.h"
+
+exrBEGIN_NAMESPACE
+
+PathStatistics::Statistics PathStatistics::GetStatistics()
+{
+    Statistics stats;
+    ForEach([&](const PathStatistics& statistics)
+    {
+        for (exrU32 depth = 0; depth < MaxDepth; ++depth)
+        {
+            stats.m_Energy[depth] += statistics.m_Energy[depth].Get();
+            stats.m_ClampedEnergy[depth] += statistics.m_ClampedEnergy[depth].Get();
+            stats.m_NumContributions[depth] += statistics.m_NumContributions[depth].Get();
+            stats.m_NumClamped[depth] += statistics.m_NumClamped[depth].Get();
+        }
+    });
+
+    return stats;
+}
+
+void PathStatistics::ResetStatistics()
+{
+    ForEach([](PathStatistics& statistics)
+    {
+        for (exrU32 depth = 0; depth < MaxDepth; ++depth)
+        {
+            statistics.m_Energy[depth].Reset();
+            statistics.m_ClampedEnergy[depth].Reset();
+            statistics.m_NumContributions[depth].Reset();
+            statistics.m_NumClamped[depth].Reset();
+        }
+    });
+}
+
+void PathStatistics::PrintStatistics()
+{
+    Statistics stats = GetStatistics();
+
+    exrF64 totalEnergy = 0.0;
+    exrU32 numDepths = 0;
+    for (exrU32 depth = 0; depth < MaxDepth; ++depth)
+    {
+        totalEnergy += stats.m_Energy[depth];
+        if (stats.m_NumContributions[depth] > 0)
+            numDepths = depth + 1;
+    }
+
+    if (numDepths == 0)
+        return;
+
+    exrInfoLine("Path contributions by depth (share of the energy found, share of it clamped):");
+    for (exrU32 depth = 0; depth < numDepths; ++depth)
+    {
+        const exrF64 energy = stats.m_Energy[depth];
+        exrInfoLine("\t   " << depth << (depth + 1 == MaxDepth ? "+" : "") << ": "
+            << (totalEnergy > 0.0 ? 100.0 * energy / totalEnergy : 0.0) << "%, "
+            << (energy > 0.0 ? 100.0 * stats.m_ClampedEnergy[depth] / energy : 0.0) << "% clamped ("
+            << stats.m_NumContributions[depth] << " contributions, " << stats.m_NumClamped[depth] << " clamped)");
+    }
+}
+
+exrEND_NAMESPACE
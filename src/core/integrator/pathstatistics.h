@@ -0,0 +1,93 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "core/elixir.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief Counts the radiance that the bounces of paths contribute to the image
+//!
+//! Every render thread adds to its own counters, so samples never contend on shared memory.
+//! The counters of all threads are combined once the render is done, which shows how deep
+//! paths need to go and how much energy clamping takes away. Contributions are only counted
+//! when the statistics are enabled, with or without clamping.
+class PathStatistics : public ThreadStatistics<PathStatistics>
+{
+public:
+    //! Contributions from deeper bounces are counted with the last depth
+    static constexpr exrU32 MaxDepth = 16;
+
+    struct Statistics
+    {
+        //! The luminance that was found at every depth, before clamping
+        exrF64 m_Energy[MaxDepth] = {};
+        //! The luminance that clamping removed at every depth
+        exrF64 m_ClampedEnergy[MaxDepth] = {};
+        exrU64 m_NumContributions[MaxDepth] = {};
+        exrU64 m_NumClamped[MaxDepth] = {};
+    };
+
+    //! @brief Records radiance that a path added to its sample
+    //! @param depth            The number of bounces before the contribution, 0 for surfaces seen by the camera
+    //! @param luminance        The luminance of the contribution before clamping
+    //! @param clampedLuminance The luminance of the contribution that was kept
+    void AddContribution(exrU32 depth, exrFloat luminance, exrFloat clampedLuminance)
+    {
+        depth = exrMin(depth, MaxDepth - 1);
+        m_Energy[depth].Add(luminance);
+        m_NumContributions[depth].Add(1);
+
+        if (clampedLuminance < luminance)
+        {
+            m_ClampedEnergy[depth].Add(luminance - clampedLuminance);
+            m_NumClamped[depth].Add(1);
+        }
+    }
+
+    //! @brief Returns true if contributions should be recorded, which costs a little per contribution
+    static inline exrBool IsEnabled() { return g_RuntimeOptions.pathStatistics; }
+
+    //! @brief Returns the statistics of the calling thread
+    static PathStatistics& GetThreadStatistics()
+    {
+        static thread_local PathStatistics threadStatistics;
+        return threadStatistics;
+    }
+
+    //! @brief Returns the counters of all threads combined
+    static Statistics GetStatistics();
+
+    //! @brief Clears the counters of all threads
+    static void ResetStatistics();
+
+    //! @brief Logs the share of the energy that every depth contributed, and how much of it was clamped
+    static void PrintStatistics();
+
+private:
+    ThreadCounter<exrF64> m_Energy[MaxDepth];
+    ThreadCounter<exrF64> m_ClampedEnergy[MaxDepth];
+    ThreadCounter<exrU64> m_NumContributions[MaxDepth];
+    ThreadCounter<exrU64> m_NumClamped[MaxDepth];
+};
+
+exrEND_NAMESPACE
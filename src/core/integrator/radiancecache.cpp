@@ -0,0 +1,225 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "radiancecache.h"
+#include "core/sampling/lowdiscrepancy.h"
+
+exrBEGIN_NAMESPACE
+
+// The bounds of the number of cells in the hash table. A cell takes 24 bytes.
+static constexpr exrU64 MinCells = 1 << 12;
+static constexpr exrU64 MaxCells = 1 << 24;
+
+// The cells that the table has room for, per cell that the faces of the scene bounds cover. This
+// leaves room for the surfaces inside the bounds, and keeps the table at most half full for a
+// closed room.
+static constexpr exrFloat CellsPerBoundsCell = 4.0f;
+
+// The number of times that a lookup tries to read the sums of a cell while samples are added to it
+static constexpr exrU32 MaxLookupAttempts = 4;
+
+// The number of consecutive cells that a key may be stored in, before its samples are dropped
+static constexpr exrU32 MaxProbes = 16;
+
+// A cell is only looked up once it has averaged this many paths, so that it is not noisier
+// than the paths that would have been traced instead
+static constexpr exrU32 MinCellSamples = 32;
+
+// Converged cells stop taking samples, which keeps their sums precise and their cache lines unshared
+static constexpr exrU32 MaxCellSamples = 1 << 16;
+
+// Each axis of the grid wraps around after this many cells
+static constexpr exrU32 CellBits = 20;
+
+RadianceCache::RadianceCache(exrFloat cellSize, const AABB& sceneBounds)
+    : m_InvCellSize(1.0f / cellSize)
+    , m_MinDistance(2.0f * cellSize)
+    , m_NumDroppedSamples(0)
+{
+    const exrFloat numBoundsCells = sceneBounds.GetSurfaceArea() * m_InvCellSize * m_InvCellSize;
+    const exrF64 numCells = exrMin(exrF64(numBoundsCells) * CellsPerBoundsCell, exrF64(MaxCells));
+
+    m_NumCells = MinCells;
+    while (m_NumCells < numCells)
+        m_NumCells *= 2;
+
+    m_Cells.reset(new Cell[m_NumCells]);
+    for (exrU64 i = 0; i < m_NumCells; ++i)
+    {
+        m_Cells[i].m_Key = 0;
+        for (exrU32 c = 0; c < 3; ++c)
+            m_Cells[i].m_Radiance[c] = 0.0f;
+        m_Cells[i].m_Sequence = 0;
+    }
+}
+
+exrBool RadianceCache::Lookup(const exrPoint3& point, const exrVector3& normal, exrSpectrum& radiance) const
+{
+    const Cell* cell = FindCell(GetKey(point, normal), false);
+    if (cell == nullptr)
+        return false;
+
+    // The sums are only used if no sample was added while they were read. A cell that stays busy
+    // is skipped, and the path is traced further instead.
+    for (exrU32 attempt = 0; attempt < MaxLookupAttempts; ++attempt)
+    {
+        const exrU32 sequence = cell->m_Sequence.load(std::memory_order_acquire);
+        if (sequence / 2 < MinCellSamples)
+            return false;
+
+        if (sequence & 1)
+            continue;
+
+        exrFloat sums[3];
+        for (exrU32 i = 0; i < 3; ++i)
+            sums[i] = cell->m_Radiance[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (cell->m_Sequence.load(std::memory_order_relaxed) != sequence)
+            continue;
+
+        const exrU32 numSamples = sequence / 2;
+        for (exrU32 i = 0; i < 3; ++i)
+            radiance[i] = sums[i] / numSamples;
+
+        return true;
+    }
+
+    return false;
+}
+
+void RadianceCache::AddPath(const PathVertex* vertices, exrU32 numVertices, const exrSpectrum& L)
+{
+    for (exrU32 v = 0; v < numVertices; ++v)
+    {
+        // The radiance found beyond the vertex, divided by the throughput that it was found with.
+        // A path that lost a color channel, such as after a red wall, knows nothing about that
+        // channel beyond the vertex, so it is left out rather than counted as black.
+        exrSpectrum found = L - vertices[v].m_L;
+        exrSpectrum beta = vertices[v].m_Beta;
+        if (beta[0] <= 0.0f || beta[1] <= 0.0f || beta[2] <= 0.0f)
+            continue;
+
+        AddSample(vertices[v].m_Point, vertices[v].m_Normal, found / beta);
+    }
+}
+
+void RadianceCache::PrintStatistics() const
+{
+    exrU64 numUsedCells = 0;
+    exrU64 numConvergedCells = 0;
+
+    for (exrU64 i = 0; i < m_NumCells; ++i)
+    {
+        if (m_Cells[i].m_Key.load(std::memory_order_relaxed) == 0)
+            continue;
+
+        numUsedCells++;
+        if (m_Cells[i].m_Sequence.load(std::memory_order_relaxed) / 2 >= MinCellSamples)
+            numConvergedCells++;
+    }
+
+    exrInfoLine("Radiance cache: " << numUsedCells << " of " << m_NumCells << " cells used, "
+        << numConvergedCells << " with enough samples to look up");
+
+    if (m_NumDroppedSamples > 0)
+        exrWarningLine("The radiance cache is too full, " << m_NumDroppedSamples << " samples were dropped. Try a larger cell size.");
+}
+
+exrU64 RadianceCache::GetKey(const exrPoint3& point, const exrVector3& normal) const
+{
+    // Offset the cell coordinates so that the grid is centered on the origin
+    const exrU64 mask = (exrU64(1) << CellBits) - 1;
+    const exrU64 x = exrU64(exrS64(floor(point.x * m_InvCellSize)) + (exrS64(1) << (CellBits - 1))) & mask;
+    const exrU64 y = exrU64(exrS64(floor(point.y * m_InvCellSize)) + (exrS64(1) << (CellBits - 1))) & mask;
+    const exrU64 z = exrU64(exrS64(floor(point.z * m_InvCellSize)) + (exrS64(1) << (CellBits - 1))) & mask;
+
+    // One of six directions, the dominant axis of the normal and its sign
+    const exrVector3 absNormal(abs(normal.x), abs(normal.y), abs(normal.z));
+    const exrU32 axis = absNormal.x > absNormal.y ? (absNormal.x > absNormal.z ? 0 : 2) : (absNormal.y > absNormal.z ? 1 : 2);
+    const exrU64 direction = axis * 2 + (normal[axis] < 0.0f ? 1 : 0);
+
+    return (((x << CellBits | y) << CellBits | z) << 3) | direction;
+}
+
+RadianceCache::Cell* RadianceCache::FindCell(exrU64 key, exrBool insert) const
+{
+    // Keys are stored plus one, since a key of 0 marks a free cell
+    const exrU64 storedKey = key + 1;
+    exrU64 index = MixBits(key) & (m_NumCells - 1);
+
+    for (exrU32 probe = 0; probe < MaxProbes; ++probe, index = (index + 1) & (m_NumCells - 1))
+    {
+        Cell& cell = m_Cells[index];
+        exrU64 cellKey = cell.m_Key.load(std::memory_order_acquire);
+
+        if (cellKey == storedKey)
+            return &cell;
+
+        if (cellKey == 0)
+        {
+            if (!insert)
+                return nullptr;
+
+            // Another thread may claim the cell first, for this key or for another one
+            if (cell.m_Key.compare_exchange_strong(cellKey, storedKey, std::memory_order_acq_rel) || cellKey == storedKey)
+                return &cell;
+        }
+    }
+
+    return nullptr;
+}
+
+void RadianceCache::AddSample(const exrPoint3& point, const exrVector3& normal, const exrSpectrum& radiance)
+{
+    // A single bad path would spoil the cell for the rest of the render
+    if (radiance.HasNaNs())
+        return;
+
+    Cell* cell = FindCell(GetKey(point, normal), true);
+    if (cell == nullptr)
+    {
+        m_NumDroppedSamples.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Take the cell by making its sequence odd, once no other thread is adding to it
+    exrU32 sequence = cell->m_Sequence.load(std::memory_order_relaxed);
+    do
+    {
+        if (sequence / 2 >= MaxCellSamples)
+            return;
+
+        if (sequence & 1)
+            sequence = cell->m_Sequence.load(std::memory_order_relaxed) & ~1u;
+    } while (!cell->m_Sequence.compare_exchange_weak(sequence, sequence | 1, std::memory_order_acquire, std::memory_order_relaxed));
+
+    // Keeps the sums from being written before readers can see that the cell is busy
+    std::atomic_thread_fence(std::memory_order_release);
+
+    exrSpectrum sample = radiance;
+    for (exrU32 i = 0; i < 3; ++i)
+        cell->m_Radiance[i].store(cell->m_Radiance[i].load(std::memory_order_relaxed) + sample[i], std::memory_order_relaxed);
+
+    cell->m_Sequence.store(sequence + 2, std::memory_order_release);
+}
+
+exrEND_NAMESPACE
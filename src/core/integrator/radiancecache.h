@@ -0,0 +1,111 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "core/elixir.h"
+#include "core/spatial/utils/aabb.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A world-space cache of the radiance that leaves diffuse surfaces
+//!
+//! Space is divided into a grid of cells, each of which keeps the average radiance that paths
+//! found leaving the surfaces inside it. Cells are also split by the dominant axis of the
+//! surface normal, so that the two sides of a thin wall do not share a cell. Only the cells
+//! that are touched are stored, in a hash table that is sized for the surfaces that the scene
+//! bounds could hold.
+//!
+//! Render threads add to and read from the cache concurrently: a free cell is claimed with a
+//! compare-and-swap of its key, and its sums are guarded by a per-cell sequence lock, so that
+//! lookups never see the sums of one sample count with another. Lookups see whatever the other
+//! threads have added so far, so images that use the cache vary slightly with the number of threads.
+class RadianceCache
+{
+public:
+    //! The most diffuse vertices of a single path that are added to the cache
+    static constexpr exrU32 MaxPathVertices = 16;
+
+    //! @brief A diffuse vertex of a path, whose radiance is known once the path is done
+    struct PathVertex
+    {
+        exrPoint3 m_Point;
+        exrVector3 m_Normal;
+        //! The throughput of the path up to the vertex
+        exrSpectrum m_Beta;
+        //! The radiance of the path before anything beyond the vertex was found
+        exrSpectrum m_L;
+    };
+
+    //! @param cellSize         The width of a cell in scene units
+    //! @param sceneBounds      The bounds of the scene geometry, which the size of the table is chosen for
+    RadianceCache(exrFloat cellSize, const AABB& sceneBounds);
+
+    //! @brief Returns the radiance that leaves a diffuse surface, once its cell has seen enough paths
+    //! @param radiance         Outputs the average radiance of the cell
+    //! @return                 True if the cell can be used
+    exrBool Lookup(const exrPoint3& point, const exrVector3& normal, exrSpectrum& radiance) const;
+
+    //! @brief Adds the radiance that a finished path found beyond each of its diffuse vertices
+    //! @param vertices         The diffuse vertices of the path, in order
+    //! @param L                The total radiance of the path
+    void AddPath(const PathVertex* vertices, exrU32 numVertices, const exrSpectrum& L);
+
+    //! @brief Returns the shortest ray that may end in the cache
+    //!
+    //! Shorter rays connect surfaces that are close enough for the cells to show, such as where
+    //! two walls meet.
+    inline exrFloat GetMinDistance() const { return m_MinDistance; }
+
+    //! @brief Logs how many cells are in use and how many of them can be looked up
+    void PrintStatistics() const;
+
+private:
+    struct Cell
+    {
+        //! The key of the cell plus one, or 0 while the cell is free
+        std::atomic<exrU64> m_Key;
+        std::atomic<exrFloat> m_Radiance[3];
+        //! Twice the number of samples in the sums, plus one while a thread is adding a sample
+        std::atomic<exrU32> m_Sequence;
+    };
+
+    exrU64 GetKey(const exrPoint3& point, const exrVector3& normal) const;
+
+    //! @brief Returns the cell of a key, claiming a free cell for it if insert is set
+    //! @return                 The cell, or nullptr if it is not in the table (or the table is too full)
+    Cell* FindCell(exrU64 key, exrBool insert) const;
+
+    void AddSample(const exrPoint3& point, const exrVector3& normal, const exrSpectrum& radiance);
+
+private:
+    exrFloat m_InvCellSize;
+    exrFloat m_MinDistance;
+
+    //! A power of two
+    exrU64 m_NumCells;
+    std::unique_ptr<Cell[]> m_Cells;
+
+    //! Samples that were dropped because every cell that their key probes was taken
+    std::atomic<exrU64> m_NumDroppedSamples;
+};
+
+exrEND_NAMESPACE
@@ -21,106 +21,237 @@
 #include "samplerintegrator.h"
 #include "core/bsdf/bxdf.h"
 #include "core/bsdf/bsdf.h"
+#include "core/light/arealight.h"
 #include "core/scene/scene.h"
 #include "system/progress.h"
 
 exrBEGIN_NAMESPACE
 
-void SamplerIntegrator::Render(const Scene& scene)
+// Adaptive renders add this many samples per pass to every pixel that has not converged, unless
+// a progressive pass size is given
+static constexpr exrU32 AdaptiveSamplesPerPass = 8;
+
+// The most samples that an adaptive render may spend on a single pixel, in multiples of the
+// samples per pixel of the scene
+static constexpr exrU32 AdaptiveMaxSampleFactor = 4;
+
+void SamplerIntegrator::Render(const Scene& scene, const CancellationToken& cancellationToken)
 {
     Exporter* exporter = m_Camera->m_Exporter.get();
     
     // Compute number of tiles
     const Point2<exrU32> resolution = exporter->m_Resolution;
-    const Point2<exrU32> numTiles((resolution.x + TileSize - 1) / TileSize, (resolution.y + TileSize - 1) / TileSize);
-    const exrU32 totalNumTiles = numTiles.x * numTiles.y;
+    const exrU32 tileSize = g_RuntimeOptions.tileSize > 0 ? g_RuntimeOptions.tileSize :
+        TileOrdering::ChooseTileSize(resolution, g_RuntimeOptions.numThreads);
+    const Point2<exrU32> numTiles((resolution.x + tileSize - 1) / tileSize, (resolution.y + tileSize - 1) / tileSize);
+    const std::vector<Point2<exrU32>> tiles = TileOrdering::GetTiles(numTiles, g_RuntimeOptions.tileOrder);
+
+    // Adaptive renders spend the same total number of samples as a regular render, but stop
+    // sampling pixels once they have converged so that noisy pixels can take more samples
+    const exrBool isAdaptive = g_RuntimeOptions.adaptiveThreshold > 0.0f;
+    const exrU32 maxSamplesPerPixel = isAdaptive ? m_NumSamplesPerPixel * AdaptiveMaxSampleFactor : m_NumSamplesPerPixel;
+    const exrU64 sampleBudget = exrU64(m_NumSamplesPerPixel) * resolution.x * resolution.y;
+    std::atomic<exrU64> numSamplesTaken(0);
+
+    // Progressive renders add a few samples to the whole image per pass, and publish the image
+    // after every pass. Otherwise every tile takes all of its samples in a single pass.
+    const exrU32 samplesPerPass = g_RuntimeOptions.samplesPerPass > 0 ? exrMin(g_RuntimeOptions.samplesPerPass, m_NumSamplesPerPixel) :
+        isAdaptive ? exrMin(AdaptiveSamplesPerPass, m_NumSamplesPerPixel) : m_NumSamplesPerPixel;
+    const exrU32 numPasses = (maxSamplesPerPixel + samplesPerPass - 1) / samplesPerPass;
 
-    ProgressBar progressMonitor(totalNumTiles, 40);
+    m_LightSampler = LightSampler::Create(g_RuntimeOptions.lightSamplerType, scene.m_Lights);
+
+    ProgressBar progressMonitor(exrU32(tiles.size() * numPasses), 40);
 
     exrProfile("Rendering Scene");
-    { // let threadPool destructor join all threads
-        exrAssert(g_RuntimeOptions.numThreads > 0, "Unable to start elixir with 0 threads!");
-        ThreadPool threadPool(g_RuntimeOptions.numThreads);
+    for (exrU32 pass = 0; pass < numPasses && !cancellationToken.IsCancelled(); ++pass)
+    {
+        // The budget is only checked between passes, so the last pass may overshoot it
+        if (isAdaptive && numSamplesTaken >= sampleBudget)
+            break;
 
-        // Loop in terms of x,y tiles so this can become async in the future
-        for (exrU32 i = 0; i < totalNumTiles; ++i)
+        const exrU64 numSamplesBeforePass = numSamplesTaken;
+
+        // Loop in terms of x,y tiles, on the threads shared by the whole process. Tiles are started
+        // in order, so threads work on neighboring tiles.
+        ParallelFor(0, tiles.size(), 1, [&](exrU64 i)
         {
-            const exrU32 tx = i % numTiles.x;
-            const exrU32 ty = exrU32(i / exrFloat(numTiles.x));
-            
-            const exrFloat priority = abs(exrFloat(tx - numTiles.x / 2)) + abs(exrFloat(ty - numTiles.y / 2));
+            // Tiles that start after a stop are skipped entirely
+            if (cancellationToken.IsCancelled())
+                return;
+
+            const exrU32 tileX = tiles[i].x;
+            const exrU32 tileY = tiles[i].y;
 
-            threadPool.ScheduleTask(priority, [&](exrU32 tileX, exrU32 tileY)
+            // Arenas belong to the worker threads and outlive the tile, so blocks are not reallocated
+            MemoryArena& memoryArena = MemoryArena::GetThreadArena();
+            memoryArena.Release();
+
+            // Everything from this point must explicitly enforce thread safety!
+            // Compute bounds for tile
+            Point2<exrU32> tileMin(tileX * tileSize, tileY * tileSize);
+            Point2<exrU32> tileMax(tileX * tileSize + tileSize, tileY * tileSize + tileSize);
+
+            // Accumulate into a private tile, so that samples never contend on the shared image
+            ExporterTile exporterTile = exporter->CreateTile(tileMin, tileMax);
+            std::unique_ptr<Sampler> sampler = Sampler::Create(g_RuntimeOptions.samplerType, m_NumSamplesPerPixel);
+
+            // Foreach pixel, shade. A stop is checked between pixels, so pixels either have all
+            // samples of this pass or none of them.
+            exrBool isStopped = false;
+            exrU64 numTileSamples = 0;
+            for (exrU32 x = 0; x < tileSize && !isStopped; ++x)
             {
-                MemoryArena memoryArena;
-                // Everything from this point must explicitly enforce thread safety!
-                // Compute bounds for tile
-                Point2<exrU32> tileMin(tileX * TileSize, tileY * TileSize);
-                Point2<exrU32> tileMax(tileX * TileSize + TileSize, tileY * TileSize + TileSize);
-
-                // Foreach pixel, shade
-                for (exrU32 x = 0; x < TileSize; ++x)
+                for (exrU32 y = 0; y < tileSize; ++y)
                 {
-                    for (exrU32 y = 0; y < TileSize; ++y)
+                    if (tileMin.x + x >= resolution.x || tileMin.y + y >= resolution.y)
+                        break;
+
+                    if (cancellationToken.IsCancelled())
                     {
-                        if (tileMin.x + x >= resolution.x || tileMin.y + y >= resolution.y)
-                            break;
-                            
-                        // Foreach sample
-                        for (exrU32 n = 0; n < m_NumSamplesPerPixel; ++n)
+                        isStopped = true;
+                        break;
+                    }
+
+                    const Point2<exrU32> pixel(tileMin.x + x, tileMin.y + y);
+
+                    // Only this task merges into the pixels of this tile, so reading them here is safe.
+                    // Error pixels are written magenta whatever else they sample, so they are not sampled again.
+                    const PixelStatistics& statistics = exporter->GetPixelStatistics(pixel);
+                    if (statistics.m_IsError)
+                        continue;
+
+                    // Adaptive passes continue where the pixel left off, and skip it once it has converged
+                    exrU32 firstSample = pass * samplesPerPass;
+                    if (isAdaptive)
+                    {
+                        if (statistics.m_NumSamples >= samplesPerPass && statistics.GetRelativeError() <= g_RuntimeOptions.adaptiveThreshold)
+                            continue;
+
+                        firstSample = statistics.m_NumSamples;
+                    }
+
+                    const exrU32 lastSample = exrMin(firstSample + samplesPerPass, maxSamplesPerPixel);
+
+                    // Foreach packet of samples. The camera rays of a pixel are nearly identical, so
+                    // they find their closest hits together.
+                    exrBool hasNaN = false;
+                    for (exrU32 n = firstSample; n < lastSample && !hasNaN; n += RayPacketSize)
+                    {
+                        const exrU32 numRays = exrMin(lastSample - n, RayPacketSize);
+                        RayPacket viewRays;
+                        exrU32 dimensions[RayPacketSize];
+
+                        for (exrU32 lane = 0; lane < numRays; ++lane)
                         {
-                            exrPoint2 randomInDisc = RejectionSampleDisk();
+                            // Samples only depend on the pixel and the sample index, so the result depends
+                            // neither on scheduling nor on how the samples are split into passes
+                            sampler->StartPixelSample(pixel, n + lane);
+
+                            exrPoint2 randomInDisc = ConcentricSampleDisk(sampler->Get2D());
                             exrFloat u = exrFloat(tileMin.x + x + randomInDisc.x) / exrFloat(resolution.x);
                             exrFloat v = exrFloat(tileMin.y + y + randomInDisc.y) / exrFloat(resolution.y);
-                            Ray viewRay = m_Camera->GetViewRay(u, v);
+                            viewRays.SetRay(lane, m_Camera->GetViewRay(u, v, sampler->Get2D()));
+                            dimensions[lane] = sampler->GetDimension();
+                        }
+
+                        SurfaceInteraction primaryHits[RayPacketSize];
+                        const exrU32 hitMask = scene.Intersect(viewRays, (1u << numRays) - 1, primaryHits);
+
+                        for (exrU32 lane = 0; lane < numRays; ++lane)
+                        {
+                            // Continue the sample where its camera ray left off
+                            sampler->StartPixelSample(pixel, n + lane, dimensions[lane]);
+                            const SurfaceInteraction* primaryHit = (hitMask & (1u << lane)) != 0 ? &primaryHits[lane] : nullptr;
 
                             exrSpectrum L(0.0f);
-                            L += Li(viewRay, scene, memoryArena, m_NumBouncePerPixel);
+                            L += Li(viewRays.GetRay(lane), primaryHit, scene, *sampler, memoryArena, m_NumBouncePerPixel);
+                            numTileSamples++;
 
                             // Issue warnings if unexpected radiance is returned
                             if (L.HasNaNs())
                             {
                                 exrError("NaN radiance returned by integrator");
-                                exporter->WriteErrorPixel(Point2<exrU32>(tileMin.x + x, tileMin.y + y));
+                                exporterTile.WriteErrorPixel(pixel);
                                 memoryArena.Release();
+                                hasNaN = true;
                                 break;
                             } 
 
-                            exporter->WritePixel(Point2<exrU32>(tileMin.x + x, tileMin.y + y), L);
+                            exporterTile.WritePixel(pixel, L);
                             memoryArena.Release();
                         }
                     }
                 }
+            }
 
-                // Add 1 to the number of tiles completed
-                progressMonitor.Increment(1);
-                progressMonitor.Print();
+            // Keep the pixels of a stopped tile, they are complete
+            exporter->MergeTile(exporterTile);
+            numSamplesTaken += numTileSamples;
+            if (isStopped)
+                return;
 
-            }, tx, ty);
+            // Add 1 to the number of tiles completed
+            progressMonitor.Increment(1);
+            progressMonitor.Print();
+        });
+
+        // Every pixel has converged or reached the sample limit
+        if (numSamplesTaken == numSamplesBeforePass)
+            break;
+
+        // The last pass is written below, once the render is finished. Adaptive passes are only
+        // written when progressive output was asked for.
+        const exrBool isPublished = !isAdaptive || g_RuntimeOptions.samplesPerPass > 0;
+        if (pass + 1 < numPasses && isPublished && !cancellationToken.IsCancelled())
+        {
+            std::cout << std::endl;
+            exrInfoLine("Finished pass " << pass + 1 << " of " << numPasses << " (" << numSamplesTaken / (resolution.x * resolution.y) << " spp)");
+            exporter->WriteImage(true);
         }
     }
 
     std::cout << std::endl;
     exrEndProfile();
 
+    if (cancellationToken.IsCancelled())
+        exrWarningLine("Render stopped after " << numSamplesTaken << " of " << sampleBudget << " samples, writing the partial image");
+
+    if (isAdaptive)
+    {
+        exrU64 numConverged = 0;
+        for (exrU32 y = 0; y < resolution.y; ++y)
+        {
+            for (exrU32 x = 0; x < resolution.x; ++x)
+            {
+                if (exporter->GetPixelStatistics(Point2<exrU32>(x, y)).GetRelativeError() <= g_RuntimeOptions.adaptiveThreshold)
+                    numConverged++;
+            }
+        }
+
+        exrInfoLine("Adaptive sampling: " << exrFloat(numSamplesTaken) / (resolution.x * resolution.y) << " spp on average, "
+            << 100.0f * numConverged / (resolution.x * resolution.y) << "% of pixels converged");
+    }
+
     //exporter->FilterImage(1, 0);
-    exporter->WriteImage(1.0f / m_NumSamplesPerPixel);
+    exporter->WriteImage();
 }
 
 exrSpectrum SamplerIntegrator::SpecularReflect(const Ray& ray, const SurfaceInteraction& intersect,
-    const Scene& scene, MemoryArena& arena, exrU32 depth) const
+    const Scene& scene, Sampler& sampler, MemoryArena& arena, exrU32 depth) const
 {
     exrVector3 wo = intersect.m_Wo;
     exrVector3 wi;
     exrFloat pdf;
     BxDF::BxDFType type = BxDF::BxDFType(BxDF::BXDFTYPE_HAS_REFLECTANCE | BxDF::BXDFTYPE_SPECULAR);
-    exrSpectrum f = intersect.m_BSDF->Sample_f(wo, &wi, &pdf, type);
+    const exrFloat uComponent = sampler.Get1D();
+    exrSpectrum f = intersect.m_BSDF->Sample_f(wo, &wi, uComponent, sampler.Get2D(), &pdf, type);
 
     const exrVector3& normal = intersect.m_Normal;
     if (depth > 0 && pdf > 0 && !f.IsBlack() && Dot(wi, normal) > 0)
     {
         Ray reflRay = intersect.SpawnRay(wi);
-        return f * Li(reflRay, scene, arena, depth - 1) * AbsDot(wi, normal) / pdf;
+        return f * Li(reflRay, scene, sampler, arena, depth - 1) * AbsDot(wi, normal) / pdf;
     }
     else
     {
@@ -129,35 +260,92 @@ exrSpectrum SamplerIntegrator::SpecularReflect(const Ray& ray, const SurfaceInte
 }
 
 exrSpectrum SamplerIntegrator::SpecularRefract(const Ray& ray, const SurfaceInteraction& intersect,
-    const Scene& scene, MemoryArena& arena, exrU32 depth) const
+    const Scene& scene, Sampler& sampler, MemoryArena& arena, exrU32 depth) const
 {
     throw "Not yet implemented!";
 }
 
-exrSpectrum SamplerIntegrator::UniformSampleOneLight(const Interaction& it, const Scene& scene,
-    MemoryArena& arena) const
+exrSpectrum SamplerIntegrator::SampleOneLight(const Interaction& it, const Scene& scene,
+    Sampler& sampler, MemoryArena& arena) const
 {
     exrU32 numLights = static_cast<exrU32>(scene.m_Lights.size());
     if (numLights <= 0)
         return 0;
 
-    exrVector3 wi;
-    VisibilityTester visibility;
     const SurfaceInteraction& hitRec = (const SurfaceInteraction&)it;
 
-    exrFloat pdf;
-    exrSpectrum Li = scene.m_Lights[Random::UniformUInt32(numLights - 1)]->Sample_Li(hitRec, wi, pdf, &visibility);
-    exrSpectrum f = hitRec.m_BSDF->f(hitRec.m_Wo, wi);
+    // Always take the same dimensions, so that the sample pattern does not depend on the light
+    const exrFloat uLightSelect = sampler.Get1D();
+    const exrPoint2 uLight = sampler.Get2D();
+    const exrFloat uComponent = sampler.Get1D();
+    const exrPoint2 uScattering = sampler.Get2D();
+
+    exrFloat lightPmf;
+    const Light* light = m_LightSampler->Sample(hitRec, uLightSelect, lightPmf);
+    if (light == nullptr || lightPmf == 0.0f)
+        return 0;
+
+    return EstimateDirect(hitRec, uScattering, uComponent, *light, uLight, scene) / lightPmf;
+}
 
-    if (!f.IsBlack())
+exrSpectrum SamplerIntegrator::EstimateDirect(const SurfaceInteraction& it, const exrPoint2& uScattering, exrFloat uComponent,
+    const Light& light, const exrPoint2& uLight, const Scene& scene) const
+{
+    const BxDF::BxDFType bsdfFlags = BxDF::BxDFType(BxDF::BXDFTYPE_ALL & ~BxDF::BXDFTYPE_SPECULAR);
+    exrSpectrum Ld(0.0f);
+
+    // Sample the light, weighted against the chance of the BSDF sampling the same direction
+    exrVector3 wi;
+    exrFloat lightPdf = 0.0f;
+    exrFloat scatteringPdf = 0.0f;
+    VisibilityTester visibility;
+    exrSpectrum Li = light.Sample_Li(it, uLight, wi, lightPdf, &visibility);
+
+    if (lightPdf > 0.0f && !Li.IsBlack())
     {
-        if (!visibility.IsOccluded(scene))
+        const exrSpectrum f = it.m_BSDF->f(it.m_Wo, wi, bsdfFlags) * AbsDot(wi, it.m_Normal);
+
+        if (!f.IsBlack() && !visibility.IsOccluded(scene))
         {
-            return Li * f * AbsDot(hitRec.m_Normal, wi);
+            if (light.IsDeltaLight())
+                Ld += f * Li / lightPdf;
+            else
+            {
+                scatteringPdf = it.m_BSDF->Pdf(it.m_Wo, wi, bsdfFlags);
+                Ld += f * Li * PowerHeuristic(1, lightPdf, 1, scatteringPdf) / lightPdf;
+            }
         }
     }
 
-    return 0;
+    if (light.IsDeltaLight())
+        return Ld;
+
+    // Sample the BSDF, weighted against the chance of the light sampling the same direction
+    BxDF::BxDFType sampledType;
+    exrSpectrum f = it.m_BSDF->Sample_f(it.m_Wo, &wi, uComponent, uScattering, &scatteringPdf, bsdfFlags, &sampledType);
+    f *= AbsDot(wi, it.m_Normal);
+
+    if (f.IsBlack() || scatteringPdf <= 0.0f)
+        return Ld;
+
+    lightPdf = light.Pdf_Li(it, wi);
+    if (lightPdf <= 0.0f)
+        return Ld;
+
+    // The sample only counts if the first surface that it hits belongs to the light, or if it
+    // escapes towards an infinite light
+    Ray ray = it.SpawnRay(wi);
+    SurfaceInteraction lightIsect;
+
+    if (scene.Intersect(ray, &lightIsect))
+        Li = lightIsect.m_AreaLight == &light ? lightIsect.Le(-wi) : exrSpectrum(0.0f);
+    else
+        Li = light.Le(ray);
+
+    if (!Li.IsBlack())
+        Ld += f * Li * PowerHeuristic(1, scatteringPdf, 1, lightPdf) / scatteringPdf;
+
+    return Ld;
 }
 
 exrEND_NAMESPACE
@@ -21,39 +21,69 @@
 #pragma once
 
 #include "integrator.h"
+#include "pathregularization.h"
 #include "core/camera/camera.h"
+#include "core/light/lightsampler.h"
+#include "core/sampling/sampler.h"
 
 exrBEGIN_NAMESPACE
 
-constexpr exrU32 TileSize = 16;
+class Light;
 
 class SamplerIntegrator : public Integrator
 {
 public:
-    SamplerIntegrator(Camera* camera, exrU32 numSamplesPerPixel, exrU32 numBouncePerPixel)
+    SamplerIntegrator(Camera* camera, exrU32 numSamplesPerPixel, exrU32 numBouncePerPixel,
+        const PathRegularization& regularization = PathRegularization())
         : m_Camera(camera)
         , m_NumSamplesPerPixel(numSamplesPerPixel)
-        , m_NumBouncePerPixel(numBouncePerPixel) {};
+        , m_NumBouncePerPixel(numBouncePerPixel)
+        , m_Regularization(regularization) {};
 
-    virtual exrSpectrum Li(const Ray& ray, const Scene& scene, MemoryArena& arena, exrU32 depth = 0) const = 0;
+    virtual exrSpectrum Li(const Ray& ray, const Scene& scene, Sampler& sampler, MemoryArena& arena, exrU32 depth = 0) const = 0;
 
-    void Render(const Scene& scene) override;
+    //! @brief Returns the radiance along a camera ray whose closest hit has already been found
+    //!
+    //! Render() intersects the camera rays of a pixel together in a ray packet. The default
+    //! ignores the hit and traces the ray again.
+    //!
+    //! @param primaryHit       The closest hit of the ray, or nullptr if it escapes the scene
+    virtual exrSpectrum Li(const Ray& ray, const SurfaceInteraction* primaryHit, const Scene& scene,
+        Sampler& sampler, MemoryArena& arena, exrU32 depth) const { return Li(ray, scene, sampler, arena, depth); }
+
+    void Render(const Scene& scene, const CancellationToken& cancellationToken) override;
 
 protected:
     virtual exrSpectrum SpecularReflect(const Ray& ray, const SurfaceInteraction& intersect,
-        const Scene& scene, MemoryArena& arena, exrU32 depth) const;
+        const Scene& scene, Sampler& sampler, MemoryArena& arena, exrU32 depth) const;
 
     virtual exrSpectrum SpecularRefract(const Ray& ray, const SurfaceInteraction& intersect,
-        const Scene& scene, MemoryArena& arena, exrU32 depth) const;
+        const Scene& scene, Sampler& sampler, MemoryArena& arena, exrU32 depth) const;
+
+    //! @brief Estimates the direct lighting at a surface from one light, chosen by the light sampler
+    exrSpectrum SampleOneLight(const Interaction& it, const Scene& scene,
+        Sampler& sampler, MemoryArena& arena) const;
 
-    exrSpectrum UniformSampleOneLight(const Interaction& it, const Scene& scene,
-        MemoryArena& arena) const;
+    //! @brief Estimates the direct lighting at a surface from a single light
+    //!
+    //! Samples both the light and the BSDF, and combines them with multiple importance sampling
+    //! (power heuristic). Delta lights can only be sampled through the light.
+    //!
+    //! The shadow ray is traced on its own, even towards point lights. Paths are followed one
+    //! sample at a time, so there are no other shadow rays at hand to fill a packet with; the
+    //! wavefront integrator queues them and traces them in packets instead.
+    exrSpectrum EstimateDirect(const SurfaceInteraction& it, const exrPoint2& uScattering, exrFloat uComponent,
+        const Light& light, const exrPoint2& uLight, const Scene& scene) const;
 
 
 protected:
     Camera* m_Camera;
     exrU32 m_NumSamplesPerPixel;
     exrU32 m_NumBouncePerPixel;
+    PathRegularization m_Regularization;
+
+    //! Chooses the light for direct lighting, built over the scene's lights at the start of Render()
+    std::unique_ptr<LightSampler> m_LightSampler;
 };
 
 exrEND_NAMESPACE
\ No newline at end of file
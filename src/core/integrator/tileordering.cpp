@@ -0,0 +1,183 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tileordering.h"
+
+exrBEGIN_NAMESPACE
+
+//! The smallest and largest automatically chosen tile sizes
+static constexpr exrU32 MinTileSize = 8;
+static constexpr exrU32 MaxTileSize = 64;
+
+//! The number of tiles that every thread should have for the load to balance well
+static constexpr exrU32 MinTilesPerThread = 16;
+
+// Returns the smallest power of two that is at least n
+static exrU32 RoundUpToPowerOfTwo(exrU32 n)
+{
+    exrU32 powerOfTwo = 1;
+    while (powerOfTwo < n)
+        powerOfTwo *= 2;
+
+    return powerOfTwo;
+}
+
+// Maps a distance along a Hilbert curve to a point, for a curve that fills a size x size square
+static Point2<exrU32> HilbertToPoint(exrU32 size, exrU32 distance)
+{
+    Point2<exrU32> point(0, 0);
+
+    for (exrU32 s = 1; s < size; s *= 2)
+    {
+        const exrU32 rx = 1 & (distance / 2);
+        const exrU32 ry = 1 & (distance ^ rx);
+
+        // Rotate the quadrant
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                point.x = s - 1 - point.x;
+                point.y = s - 1 - point.y;
+            }
+
+            std::swap(point.x, point.y);
+        }
+
+        point.x += s * rx;
+        point.y += s * ry;
+        distance /= 4;
+    }
+
+    return point;
+}
+
+// Maps a distance along a Z-order curve to a point by deinterleaving its bits
+static Point2<exrU32> MortonToPoint(exrU32 distance)
+{
+    Point2<exrU32> point(0, 0);
+
+    for (exrU32 bit = 0; bit < 16; ++bit)
+    {
+        point.x |= ((distance >> (2 * bit)) & 1) << bit;
+        point.y |= ((distance >> (2 * bit + 1)) & 1) << bit;
+    }
+
+    return point;
+}
+
+std::vector<Point2<exrU32>> TileOrdering::GetTiles(const Point2<exrU32>& numTiles, TileOrder order)
+{
+    const exrU32 totalNumTiles = numTiles.x * numTiles.y;
+    std::vector<Point2<exrU32>> tiles;
+    tiles.reserve(totalNumTiles);
+
+    auto addTile = [&](exrU32 x, exrU32 y)
+    {
+        if (x < numTiles.x && y < numTiles.y)
+            tiles.emplace_back(x, y);
+    };
+
+    switch (order)
+    {
+    case TILEORDER_HILBERT:
+    case TILEORDER_MORTON:
+    {
+        // Both curves fill a power of two square, so skip the part outside the image
+        const exrU32 size = RoundUpToPowerOfTwo(exrMax(numTiles.x, numTiles.y));
+        for (exrU32 distance = 0; distance < size * size; ++distance)
+        {
+            const Point2<exrU32> tile = order == TILEORDER_HILBERT ? HilbertToPoint(size, distance) : MortonToPoint(distance);
+            addTile(tile.x, tile.y);
+        }
+        break;
+    }
+    case TILEORDER_SPIRAL:
+    {
+        // Walk a square spiral outwards from the center tile, with legs of length 1, 1, 2, 2, 3, 3...
+        static constexpr exrS32 directions[4][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+        exrS32 x = exrS32(numTiles.x - 1) / 2;
+        exrS32 y = exrS32(numTiles.y - 1) / 2;
+
+        for (exrU32 leg = 0; tiles.size() < totalNumTiles; ++leg)
+        {
+            for (exrU32 step = 0; step < leg / 2 + 1 && tiles.size() < totalNumTiles; ++step)
+            {
+                if (x >= 0 && y >= 0)
+                    addTile(exrU32(x), exrU32(y));
+
+                x += directions[leg % 4][0];
+                y += directions[leg % 4][1];
+            }
+        }
+        break;
+    }
+    case TILEORDER_SCANLINE:
+    default:
+        for (exrU32 y = 0; y < numTiles.y; ++y)
+        {
+            for (exrU32 x = 0; x < numTiles.x; ++x)
+                addTile(x, y);
+        }
+        break;
+    }
+
+    exrAssert(tiles.size() == totalNumTiles, "Tile ordering did not visit every tile exactly once!");
+    return tiles;
+}
+
+exrU32 TileOrdering::ChooseTileSize(const Point2<exrU32>& resolution, exrU32 numThreads)
+{
+    exrU32 tileSize = MaxTileSize;
+
+    while (tileSize > MinTileSize)
+    {
+        const exrU32 numTiles = ((resolution.x + tileSize - 1) / tileSize) * ((resolution.y + tileSize - 1) / tileSize);
+        if (numTiles >= MinTilesPerThread * exrMax(numThreads, 1u))
+            break;
+
+        tileSize /= 2;
+    }
+
+    return tileSize;
+}
+
+exrBool TileOrdering::ParseTileOrder(const exrString& name, TileOrder& order)
+{
+    static const std::pair<const exrChar*, TileOrder> names[] = {
+        { "hilbert", TILEORDER_HILBERT },
+        { "morton", TILEORDER_MORTON },
+        { "spiral", TILEORDER_SPIRAL },
+        { "scanline", TILEORDER_SCANLINE }
+    };
+
+    for (const auto& entry : names)
+    {
+        if (name == entry.first)
+        {
+            order = entry.second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,63 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "system/system.h"
+#include "math/math.h"
+
+exrBEGIN_NAMESPACE
+
+//! The orders in which the tiles of an image can be rendered
+enum TileOrder
+{
+    TILEORDER_HILBERT,      //!< Along a Hilbert curve, so that consecutive tiles are always neighbors
+    TILEORDER_MORTON,       //!< Along a Z-order curve, which keeps groups of tiles together
+    TILEORDER_SPIRAL,       //!< Outwards from the center of the image, which is usually the most interesting
+    TILEORDER_SCANLINE      //!< Row by row, from the top left
+};
+
+//! @brief Decides how an image is split into tiles, and in which order the tiles are rendered
+//!
+//! Tiles are started in order, so threads that start around the same time work on tiles that
+//! are close together and see largely the same geometry.
+class TileOrdering
+{
+public:
+    //! @brief Returns the coordinates of all tiles in the order that they should be rendered
+    //! @param numTiles         The number of tiles along each axis
+    //! @param order            The order to render them in
+    static std::vector<Point2<exrU32>> GetTiles(const Point2<exrU32>& numTiles, TileOrder order);
+
+    //! @brief Picks a tile size that leaves every thread enough tiles to balance the load
+    //!
+    //! Tiles are kept as large as possible for coherence, while the last tiles that finish
+    //! are small enough not to leave other threads idle for long.
+    //!
+    //! @param resolution       The resolution of the image in pixels
+    //! @param numThreads       The number of threads that render the image
+    static exrU32 ChooseTileSize(const Point2<exrU32>& resolution, exrU32 numThreads);
+
+    //! @brief Parses the name of a tile order (hilbert, morton, spiral or scanline)
+    //! @return                 False if the name is unknown
+    static exrBool ParseTileOrder(const exrString& name, TileOrder& order);
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,453 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "wavefrontintegrator.h"
+#include "core/bsdf/bsdf.h"
+#include "core/light/arealight.h"
+#include "core/scene/scene.h"
+#include "system/progress.h"
+
+exrBEGIN_NAMESPACE
+
+// The most pixel samples that are in flight at once. The state of a path takes a few hundred
+// bytes, so this keeps a wave at a few tens of megabytes.
+static constexpr exrU32 MaxWaveSize = 1 << 17;
+
+// The number of consecutive queue entries that a single task of a stage processes
+static constexpr exrU32 WorkChunkSize = 256;
+
+void WavefrontIntegrator::PathStates::Resize(exrU32 size)
+{
+    m_RayOrigin.resize(size);
+    m_RayDirection.resize(size);
+    m_Beta.resize(size);
+    m_L.resize(size);
+    m_Pixel.resize(size);
+    m_SampleIndex.resize(size);
+    m_Dimension.resize(size);
+    m_Depth.resize(size);
+    m_SpecularBounce.resize(size);
+    m_PrevPoint.resize(size);
+    m_PrevNormal.resize(size);
+    m_ScatteringPdf.resize(size);
+    m_Interaction.resize(size);
+}
+
+void WavefrontIntegrator::ShadowQueue::Resize(exrU32 size)
+{
+    m_RayOrigin.resize(size);
+    m_RayDirection.resize(size);
+    m_TMax.resize(size);
+    m_Contribution.resize(size);
+    m_PathIndex.resize(size);
+    m_Depth.resize(size);
+    m_Light.resize(size);
+    m_Size = 0;
+}
+
+void WavefrontIntegrator::ShadowQueue::Push(const Ray& ray, const exrSpectrum& contribution, exrU32 path, exrU32 depth, exrU32 light)
+{
+    const exrU32 index = m_Size.fetch_add(1, std::memory_order_relaxed);
+    m_RayOrigin[index] = ray.m_Origin;
+    m_RayDirection[index] = ray.m_Direction;
+    m_TMax[index] = ray.m_TMax;
+    m_Contribution[index] = contribution;
+    m_PathIndex[index] = path;
+    m_Depth[index] = depth;
+    m_Light[index] = light;
+}
+
+void WavefrontIntegrator::Render(const Scene& scene, const CancellationToken& cancellationToken)
+{
+    Exporter* exporter = m_Camera->m_Exporter.get();
+    const Point2<exrU32> resolution = exporter->m_Resolution;
+
+    if (g_RuntimeOptions.samplesPerPass > 0 || g_RuntimeOptions.adaptiveThreshold > 0.0f)
+        exrWarningLine("The wavefront integrator does not support progressive or adaptive rendering, taking all samples in one pass");
+
+    // The samples are numbered sample-major: the first sample of every pixel in scanline order, then
+    // the second, and so on. Waves take the next range of samples, so neighboring camera rays are
+    // coherent, and a render that is stopped early has its samples spread over the whole image.
+    const exrU64 numSamples = exrU64(resolution.x) * resolution.y * m_NumSamplesPerPixel;
+    const exrU32 waveSize = exrU32(exrMin(numSamples, exrU64(MaxWaveSize)));
+    const exrU64 numWaves = (numSamples + waveSize - 1) / waveSize;
+
+    m_LightSampler = LightSampler::Create(g_RuntimeOptions.lightSamplerType, scene.m_Lights);
+    m_Paths.Resize(waveSize);
+    m_ShadowRays.Resize(waveSize);
+    m_RayQueue.Resize(waveSize);
+    m_HitQueue.Resize(waveSize);
+    m_ShadeQueue.resize(waveSize);
+    m_ShadowOrder.resize(waveSize);
+
+    m_LightIndices.clear();
+    for (const Light* light : scene.m_Lights)
+        m_LightIndices.emplace(light, exrU32(m_LightIndices.size()));
+    m_LightCounts.resize(m_LightIndices.size());
+
+    ProgressBar progressMonitor(exrU32(numWaves), 40);
+    exrU64 numSamplesTaken = 0;
+
+    exrProfile("Rendering Scene");
+    for (exrU64 firstSample = 0; firstSample < numSamples && !cancellationToken.IsCancelled(); firstSample += waveSize)
+    {
+        const exrU32 numPaths = exrU32(exrMin(numSamples - firstSample, exrU64(waveSize)));
+        GeneratePaths(firstSample, numPaths);
+
+        // Every iteration advances all live paths by one bounce. A stop only takes effect between
+        // waves, so that the paths in flight are finished and kept.
+        while (m_RayQueue.m_Size > 0)
+        {
+            IntersectPaths(scene);
+            SortByMaterial();
+            ShadePaths(scene);
+            SortByLight();
+            TraceShadowRays(scene);
+        }
+
+        WritePaths(numPaths);
+        numSamplesTaken += numPaths;
+
+        progressMonitor.Increment(1);
+        progressMonitor.Print();
+    }
+
+    std::cout << std::endl;
+    exrEndProfile();
+
+    if (cancellationToken.IsCancelled())
+        exrWarningLine("Render stopped after " << numSamplesTaken << " of " << numSamples << " samples, writing the partial image");
+
+    exporter->WriteImage();
+}
+
+void WavefrontIntegrator::GeneratePaths(exrU64 firstSample, exrU32 numPaths)
+{
+    const Point2<exrU32> resolution = m_Camera->m_Exporter->m_Resolution;
+
+    ParallelForChunks((numPaths + WorkChunkSize - 1) / WorkChunkSize, [&](exrU64 chunk)
+    {
+        std::unique_ptr<Sampler> sampler = Sampler::Create(g_RuntimeOptions.samplerType, m_NumSamplesPerPixel);
+        const exrU32 chunkEnd = exrMin(exrU32(chunk + 1) * WorkChunkSize, numPaths);
+
+        for (exrU32 path = exrU32(chunk) * WorkChunkSize; path < chunkEnd; ++path)
+        {
+            const exrU64 sample = firstSample + path;
+            const exrU64 numPixels = exrU64(resolution.x) * resolution.y;
+            const exrU64 pixelIndex = sample % numPixels;
+            const Point2<exrU32> pixel(exrU32(pixelIndex % resolution.x), exrU32(pixelIndex / resolution.x));
+            const exrU32 sampleIndex = exrU32(sample / numPixels);
+
+            // Takes the same dimensions as SamplerIntegrator::Render()
+            sampler->StartPixelSample(pixel, sampleIndex);
+            exrPoint2 randomInDisc = ConcentricSampleDisk(sampler->Get2D());
+            exrFloat u = exrFloat(pixel.x + randomInDisc.x) / exrFloat(resolution.x);
+            exrFloat v = exrFloat(pixel.y + randomInDisc.y) / exrFloat(resolution.y);
+            Ray viewRay = m_Camera->GetViewRay(u, v, sampler->Get2D());
+
+            m_Paths.m_RayOrigin[path] = viewRay.m_Origin;
+            m_Paths.m_RayDirection[path] = viewRay.m_Direction;
+            m_Paths.m_Beta[path] = exrSpectrum(1.0f);
+            m_Paths.m_L[path] = exrSpectrum(0.0f);
+            m_Paths.m_Pixel[path] = pixel;
+            m_Paths.m_SampleIndex[path] = sampleIndex;
+            m_Paths.m_Dimension[path] = sampler->GetDimension();
+            m_Paths.m_Depth[path] = 0;
+            m_Paths.m_SpecularBounce[path] = false;
+
+            // Paths start in order, which keeps neighboring camera rays together in the first intersection
+            m_RayQueue.m_Paths[path] = path;
+        }
+    });
+
+    m_RayQueue.m_Size = numPaths;
+}
+
+void WavefrontIntegrator::IntersectPaths(const Scene& scene)
+{
+    const exrU32 numRays = m_RayQueue.m_Size;
+    m_HitQueue.m_Size = 0;
+
+    ParallelFor(0, numRays, WorkChunkSize, [&](exrU64 i)
+    {
+        const exrU32 path = m_RayQueue.m_Paths[i];
+        const Ray ray(m_Paths.m_RayOrigin[path], m_Paths.m_RayDirection[path]);
+
+        SurfaceInteraction& hitRec = m_Paths.m_Interaction[path];
+        hitRec = SurfaceInteraction();
+
+        if (scene.Intersect(ray, &hitRec))
+            m_HitQueue.Push(path);
+        else if (m_Paths.m_Depth[path] <= m_NumBouncePerPixel)
+            m_Paths.m_L[path] += m_Regularization.Clamp(m_Paths.m_Beta[path] * scene.SampleSkyLight(ray), m_Paths.m_Depth[path]);
+    });
+
+    m_RayQueue.m_Size = 0;
+}
+
+void WavefrontIntegrator::SortByMaterial()
+{
+    const exrU32 numHits = m_HitQueue.m_Size;
+
+    // A counting sort over the materials, which are numbered in the order that they are first seen.
+    // Consecutive hits usually share a material, so the last lookup is remembered.
+    std::fill(m_MaterialCounts.begin(), m_MaterialCounts.end(), 0);
+    const Material* lastMaterial = nullptr;
+    exrU32 lastIndex = 0;
+
+    for (exrU32 i = 0; i < numHits; ++i)
+    {
+        const Material* material = m_Paths.m_Interaction[m_HitQueue.m_Paths[i]].m_Material;
+        if (material != lastMaterial || i == 0)
+        {
+            auto it = m_MaterialIndices.emplace(material, exrU32(m_MaterialIndices.size())).first;
+            lastMaterial = material;
+            lastIndex = it->second;
+
+            if (lastIndex >= m_MaterialCounts.size())
+                m_MaterialCounts.resize(lastIndex + 1, 0);
+        }
+
+        m_MaterialCounts[lastIndex]++;
+    }
+
+    exrU32 offset = 0;
+    for (exrU32& count : m_MaterialCounts)
+    {
+        const exrU32 numMaterialHits = count;
+        count = offset;
+        offset += numMaterialHits;
+    }
+
+    for (exrU32 i = 0; i < numHits; ++i)
+    {
+        const exrU32 path = m_HitQueue.m_Paths[i];
+        const exrU32 index = m_MaterialIndices[m_Paths.m_Interaction[path].m_Material];
+        m_ShadeQueue[m_MaterialCounts[index]++] = path;
+    }
+}
+
+void WavefrontIntegrator::ShadePaths(const Scene& scene)
+{
+    const exrU32 numHits = m_HitQueue.m_Size;
+    m_ShadowRays.m_Size = 0;
+
+    ParallelForChunks((numHits + WorkChunkSize - 1) / WorkChunkSize, [&](exrU64 chunk)
+    {
+        std::unique_ptr<Sampler> sampler = Sampler::Create(g_RuntimeOptions.samplerType, m_NumSamplesPerPixel);
+        MemoryArena& memoryArena = MemoryArena::GetThreadArena();
+        const exrU32 chunkEnd = exrMin(exrU32(chunk + 1) * WorkChunkSize, numHits);
+
+        for (exrU32 i = exrU32(chunk) * WorkChunkSize; i < chunkEnd; ++i)
+        {
+            const exrU32 path = m_ShadeQueue[i];
+            SurfaceInteraction& hitRec = m_Paths.m_Interaction[path];
+            const exrVector3 rayDirection = m_Paths.m_RayDirection[path];
+            const exrU32 depth = m_Paths.m_Depth[path];
+            exrSpectrum& beta = m_Paths.m_Beta[path];
+            exrSpectrum& L = m_Paths.m_L[path];
+
+            // Emission that the camera sees or that a specular bounce finds can only be found this way.
+            // Otherwise the light sample of the last bounce could have found it too, so it is weighted.
+            const exrSpectrum Le = hitRec.Le(hitRec.m_Wo);
+            if (!Le.IsBlack())
+            {
+                if (depth == 0 || m_Paths.m_SpecularBounce[path])
+                    L += m_Regularization.Clamp(beta * Le, depth);
+                else
+                {
+                    const Interaction prev(m_Paths.m_PrevPoint[path], m_Paths.m_PrevNormal[path], -rayDirection);
+                    const exrFloat lightPdf = m_LightSampler->Pmf(prev, hitRec.m_AreaLight) * hitRec.m_AreaLight->Pdf_Li(prev, rayDirection);
+
+                    // This is the BSDF half of the direct lighting at the previous vertex, so it is
+                    // clamped at that depth, like its shadow ray and like PathIntegrator does
+                    L += m_Regularization.Clamp(beta * Le * PowerHeuristic(1, m_Paths.m_ScatteringPdf[path], 1, lightPdf), depth - 1);
+                }
+            }
+
+            // Paths past the last bounce were only continued to find the emission above
+            if (depth > m_NumBouncePerPixel)
+                continue;
+
+            const Ray ray(m_Paths.m_RayOrigin[path], rayDirection);
+            hitRec.ComputeScatteringFunctions(ray, memoryArena);
+
+            // Surface hit a surface without BSDF, pass through it without counting a bounce
+            if (hitRec.m_BSDF == nullptr)
+            {
+                exrWarningLine("Intersected a surface that has an uninitialized BSDF! Was this intended?");
+                m_Paths.m_RayOrigin[path] = hitRec.SpawnRay(rayDirection).m_Origin;
+                m_RayQueue.Push(path);
+                continue;
+            }
+
+            // Sharp lobes past the first bounce mostly make fireflies, so they may be widened
+            if (m_Regularization.IsRegularized(depth))
+                hitRec.m_BSDF->Regularize(m_Regularization.m_MinRoughness, memoryArena);
+
+            // Every bounce takes the same dimensions, whether or not it uses all of them
+            sampler->StartPixelSample(m_Paths.m_Pixel[path], m_Paths.m_SampleIndex[path], m_Paths.m_Dimension[path]);
+            const exrFloat uLightSelect = sampler->Get1D();
+            const exrPoint2 uLight = sampler->Get2D();
+            const exrFloat uComponent = sampler->Get1D();
+            const exrPoint2 uScattering = sampler->Get2D();
+            const exrFloat uRoulette = sampler->Get1D();
+            m_Paths.m_Dimension[path] = sampler->GetDimension();
+
+            // Sample a light, and leave it to the shadow stage to find out whether it is visible
+            exrFloat lightPmf;
+            const Light* light = m_LightSampler->Sample(hitRec, uLightSelect, lightPmf);
+            if (light != nullptr && lightPmf > 0.0f)
+            {
+                exrVector3 wi;
+                exrFloat lightPdf = 0.0f;
+                VisibilityTester visibility;
+                const exrSpectrum Li = light->Sample_Li(hitRec, uLight, wi, lightPdf, &visibility);
+                const exrSpectrum f = lightPdf > 0.0f && !Li.IsBlack() ?
+                    hitRec.m_BSDF->f(hitRec.m_Wo, wi) * AbsDot(wi, hitRec.m_Normal) : exrSpectrum(0.0f);
+
+                if (!f.IsBlack())
+                {
+                    lightPdf *= lightPmf;
+                    const exrFloat weight = light->IsDeltaLight() ? 1.0f :
+                        PowerHeuristic(1, lightPdf, 1, hitRec.m_BSDF->Pdf(hitRec.m_Wo, wi));
+
+                    m_ShadowRays.Push(visibility.m_P0.SpawnRayTo(visibility.m_P1), beta * f * Li * weight / lightPdf,
+                        path, depth, m_LightIndices.at(light));
+                }
+            }
+
+            // Sample BSDF to get new path direction
+            exrVector3 wi;
+            exrFloat pdf;
+            BxDF::BxDFType sampledType;
+            exrSpectrum f = hitRec.m_BSDF->Sample_f(hitRec.m_Wo, &wi, uComponent, uScattering, &pdf, BxDF::BXDFTYPE_ALL, &sampledType);
+
+            if (f.IsBlack() || pdf == 0.0f)
+                continue;
+
+            // Past the last bounce, only emission that the light sample could have found matters
+            const exrBool specularBounce = (sampledType & BxDF::BXDFTYPE_SPECULAR) != 0;
+            if (depth == m_NumBouncePerPixel && specularBounce)
+                continue;
+
+            beta *= f * AbsDot(wi, hitRec.m_Normal) / pdf;
+
+            // Terminate path using Russian roulette
+            if (depth > 3)
+            {
+                exrFloat q = exrMax(0.05f, 1 - beta.GetLuminance());
+                if (uRoulette <= q)
+                    continue;
+
+                beta /= 1 - q;
+            }
+
+            const Ray nextRay = hitRec.SpawnRay(wi);
+            m_Paths.m_RayOrigin[path] = nextRay.m_Origin;
+            m_Paths.m_RayDirection[path] = nextRay.m_Direction;
+            m_Paths.m_PrevPoint[path] = hitRec.m_Point;
+            m_Paths.m_PrevNormal[path] = hitRec.m_Normal;
+            m_Paths.m_ScatteringPdf[path] = pdf;
+            m_Paths.m_SpecularBounce[path] = specularBounce;
+            m_Paths.m_Depth[path] = depth + 1;
+            m_RayQueue.Push(path);
+        }
+
+        memoryArena.Release();
+    });
+}
+
+void WavefrontIntegrator::SortByLight()
+{
+    const exrU32 numRays = m_ShadowRays.m_Size;
+
+    // A stable counting sort, so that the rays of a light keep the order that they were queued in
+    std::fill(m_LightCounts.begin(), m_LightCounts.end(), 0);
+    for (exrU32 i = 0; i < numRays; ++i)
+        m_LightCounts[m_ShadowRays.m_Light[i]]++;
+
+    exrU32 offset = 0;
+    for (exrU32& count : m_LightCounts)
+    {
+        const exrU32 numLightRays = count;
+        count = offset;
+        offset += numLightRays;
+    }
+
+    for (exrU32 i = 0; i < numRays; ++i)
+        m_ShadowOrder[m_LightCounts[m_ShadowRays.m_Light[i]]++] = i;
+}
+
+void WavefrontIntegrator::TraceShadowRays(const Scene& scene)
+{
+    // The rays of a light were queued by the chunks of the shading stage, which took the paths in
+    // material order, so the rays of a packet head towards the same light from surfaces of mostly
+    // the same material, but not necessarily from nearby pixels. A path queues at most one shadow
+    // ray per bounce, so no two rays add to the same path here.
+    const exrU64 numRays = m_ShadowRays.m_Size;
+    const exrU64 numPackets = (numRays + RayPacketSize - 1) / RayPacketSize;
+
+    ParallelFor(0, numPackets, WorkChunkSize / RayPacketSize, [&](exrU64 packetIndex)
+    {
+        const exrU64 first = packetIndex * RayPacketSize;
+        const exrU32 numLanes = exrU32(exrMin(numRays - first, exrU64(RayPacketSize)));
+
+        RayPacket packet;
+        for (exrU32 lane = 0; lane < numLanes; ++lane)
+        {
+            const exrU32 index = m_ShadowOrder[first + lane];
+            packet.SetRay(lane, Ray(m_ShadowRays.m_RayOrigin[index], m_ShadowRays.m_RayDirection[index], m_ShadowRays.m_TMax[index]));
+        }
+
+        const exrU32 laneMask = (1u << numLanes) - 1;
+        const exrU32 occludedMask = scene.HasIntersect(packet, laneMask);
+
+        for (exrU32 lane = 0; lane < numLanes; ++lane)
+        {
+            if ((occludedMask & (1u << lane)) == 0)
+            {
+                const exrU32 index = m_ShadowOrder[first + lane];
+                m_Paths.m_L[m_ShadowRays.m_PathIndex[index]] += m_Regularization.Clamp(m_ShadowRays.m_Contribution[index], m_ShadowRays.m_Depth[index]);
+            }
+        }
+    });
+}
+
+void WavefrontIntegrator::WritePaths(exrU32 numPaths)
+{
+    Exporter* exporter = m_Camera->m_Exporter.get();
+
+    for (exrU32 path = 0; path < numPaths; ++path)
+    {
+        // Issue warnings if unexpected radiance is returned
+        if (m_Paths.m_L[path].HasNaNs())
+        {
+            exrError("NaN radiance returned by integrator");
+            exporter->WriteErrorPixel(m_Paths.m_Pixel[path]);
+            continue;
+        }
+
+        exporter->WritePixel(m_Paths.m_Pixel[path], m_Paths.m_L[path]);
+    }
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,163 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "integrator.h"
+#include "pathregularization.h"
+#include "core/camera/camera.h"
+#include "core/light/lightsampler.h"
+#include <unordered_map>
+
+exrBEGIN_NAMESPACE
+
+class Material;
+
+//! @brief A path tracer that advances many paths at once, one stage at a time
+//!
+//! Instead of following every path to its end on a single thread (see PathIntegrator), the
+//! integrator keeps the state of a whole wave of pixel samples in flat arrays, and runs one
+//! stage of all paths before moving on to the next: camera rays are generated, intersected,
+//! sorted by material and shaded, and the shadow rays of the shading stage are sorted by light
+//! and traced last.
+//! Every stage is a short loop over a queue of path indices that does the same work for every
+//! entry, which keeps the code and data of a stage in cache.
+//!
+//! The estimator matches PathIntegrator: the light sample and the BSDF sample of each bounce are
+//! combined with multiple importance sampling, except that the BSDF sample doubles as the next
+//! bounce of the path instead of being traced separately.
+class WavefrontIntegrator : public Integrator
+{
+public:
+    WavefrontIntegrator(Camera* camera, exrU32 numSamplesPerPixel, exrU32 numBouncePerPixel,
+        const PathRegularization& regularization = PathRegularization())
+        : m_Camera(camera)
+        , m_NumSamplesPerPixel(numSamplesPerPixel)
+        , m_NumBouncePerPixel(numBouncePerPixel)
+        , m_Regularization(regularization) {};
+
+    void Render(const Scene& scene, const CancellationToken& cancellationToken) override;
+
+private:
+    //! The state of every path of a wave, indexed by the path's position in the wave
+    struct PathStates
+    {
+        void Resize(exrU32 size);
+
+        std::vector<exrPoint3> m_RayOrigin;
+        std::vector<exrVector3> m_RayDirection;
+        std::vector<exrSpectrum> m_Beta;
+        std::vector<exrSpectrum> m_L;
+        std::vector<Point2<exrU32>> m_Pixel;
+        std::vector<exrU32> m_SampleIndex;
+        //! The first sampler dimension that the next stage of the path takes
+        std::vector<exrU32> m_Dimension;
+        std::vector<exrU32> m_Depth;
+        std::vector<exrByte> m_SpecularBounce;
+
+        //! The surface that the last BSDF sample left from, and its pdf, to weight emission with
+        std::vector<exrPoint3> m_PrevPoint;
+        std::vector<exrVector3> m_PrevNormal;
+        std::vector<exrFloat> m_ScatteringPdf;
+
+        std::vector<SurfaceInteraction> m_Interaction;
+    };
+
+    //! A list of path indices that the threads of a stage can append to
+    struct PathQueue
+    {
+        void Resize(exrU32 size) { m_Paths.resize(size); m_Size = 0; }
+        inline void Push(exrU32 path) { m_Paths[m_Size.fetch_add(1, std::memory_order_relaxed)] = path; }
+
+        std::vector<exrU32> m_Paths;
+        std::atomic<exrU32> m_Size;
+    };
+
+    //! The shadow rays of a wave, each of which adds its contribution to a path if it is unoccluded
+    struct ShadowQueue
+    {
+        void Resize(exrU32 size);
+        void Push(const Ray& ray, const exrSpectrum& contribution, exrU32 path, exrU32 depth, exrU32 light);
+
+        std::vector<exrPoint3> m_RayOrigin;
+        std::vector<exrVector3> m_RayDirection;
+        std::vector<exrFloat> m_TMax;
+        std::vector<exrSpectrum> m_Contribution;
+        std::vector<exrU32> m_PathIndex;
+        //! The depth of the path when the ray was queued, which the contribution is clamped for
+        std::vector<exrU32> m_Depth;
+        //! The index in the scene's lights of the light that the ray heads towards
+        std::vector<exrU32> m_Light;
+        std::atomic<exrU32> m_Size;
+    };
+
+    //! @brief Starts the camera paths of the pixel samples [firstSample, firstSample + numPaths)
+    void GeneratePaths(exrU64 firstSample, exrU32 numPaths);
+
+    //! @brief Finds the closest hit of the ray of every queued path, and adds what escaped paths see
+    void IntersectPaths(const Scene& scene);
+
+    //! @brief Orders the hit paths by material, so that paths with the same material are shaded together
+    void SortByMaterial();
+
+    //! @brief Adds emission, queues a light sample, and continues or terminates every sorted path
+    void ShadePaths(const Scene& scene);
+
+    //! @brief Orders the queued shadow rays by light, so that the rays of a packet head the same way
+    void SortByLight();
+
+    //! @brief Traces the sorted shadow rays, and adds the contribution of those that are unoccluded
+    void TraceShadowRays(const Scene& scene);
+
+    //! @brief Writes the radiance of the paths of a wave to the image
+    void WritePaths(exrU32 numPaths);
+
+private:
+    Camera* m_Camera;
+    exrU32 m_NumSamplesPerPixel;
+    exrU32 m_NumBouncePerPixel;
+    PathRegularization m_Regularization;
+
+    std::unique_ptr<LightSampler> m_LightSampler;
+
+    PathStates m_Paths;
+    ShadowQueue m_ShadowRays;
+
+    //! The paths to intersect next, and the paths that hit a surface in the last intersection
+    PathQueue m_RayQueue;
+    PathQueue m_HitQueue;
+
+    //! The paths of m_HitQueue, ordered by material
+    std::vector<exrU32> m_ShadeQueue;
+
+    //! Dense indices of the materials seen so far, for the counting sort of SortByMaterial()
+    std::unordered_map<const Material*, exrU32> m_MaterialIndices;
+    std::vector<exrU32> m_MaterialCounts;
+
+    //! The entries of m_ShadowRays, ordered by light
+    std::vector<exrU32> m_ShadowOrder;
+
+    //! Indices of the scene's lights, for the counting sort of SortByLight()
+    std::unordered_map<const Light*, exrU32> m_LightIndices;
+    std::vector<exrU32> m_LightCounts;
+};
+
+exrEND_NAMESPACE
@@ -29,6 +29,10 @@ exrBEGIN_NAMESPACE
 class BSDF;
 class Primitive;
 
+//! Shadow rays stop this fraction of their length short of their target, so that they do not
+//! hit the surface that they are testing the visibility of
+static constexpr exrFloat ShadowEpsilon = 0.0001f;
+
 //! A struct that contains information about the local differential geometry
 //! at intersection points.
 struct Interaction
@@ -54,7 +58,7 @@ struct Interaction
     {
         exrPoint3 origin = m_Point + m_Normal * EXR_EPSILON;
         exrVector3 direction = to.m_Point - origin;
-        return Ray(origin, direction, direction.Magnitude());
+        return Ray(origin, direction, direction.Magnitude() * (1.0f - ShadowEpsilon));
     };
 
     //! The point of intersection
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "surfaceinteraction.h"
+#include "core/light/arealight.h"
 #include "core/primitive/primitive.h"
 
 exrBEGIN_NAMESPACE
@@ -32,7 +33,12 @@ SurfaceInteraction::SurfaceInteraction(const exrPoint3& point, const exrVector3&
 
 void SurfaceInteraction::ComputeScatteringFunctions(const Ray& ray, MemoryArena& arena)
 {
-    m_Primitive->GetMaterial()->ComputeScatteringFunctions(this, arena);
+    m_Material->ComputeScatteringFunctions(this, arena);
+}
+
+exrSpectrum SurfaceInteraction::Le(const exrVector3& w) const
+{
+    return m_AreaLight != nullptr ? m_AreaLight->L(*this, w) : exrSpectrum(0.0f);
 }
 
 exrEND_NAMESPACE
\ No newline at end of file
@@ -24,7 +24,9 @@
 
 exrBEGIN_NAMESPACE
 
+class AreaLight;
 class BSDF;
+class Material;
 class Shape;
 class Ray;
 
@@ -35,10 +37,22 @@ public:
     SurfaceInteraction(const exrPoint3& point, const exrVector3& wo, const exrVector3& normal, const Shape* shape);
     void ComputeScatteringFunctions(const Ray& ray, MemoryArena& arena);
 
+    //! @brief Returns the radiance that the surface emits in direction w, if it is an area light
+    exrSpectrum Le(const exrVector3& w) const;
+
 public:
     BSDF* m_BSDF = nullptr;
     const Primitive* m_Primitive = nullptr;
+
+    //! The material to shade with. Usually that of m_Primitive, unless overridden by an instance
+    const Material* m_Material = nullptr;
     const Shape* m_Shape = nullptr;
+
+    //! The surface parameterization at the point, interpolated from the texture coordinates of the mesh
+    exrPoint2 m_UV;
+
+    //! The light that the surface belongs to, if it is emissive
+    const AreaLight* m_AreaLight = nullptr;
 };
 
 exrEND_NAMESPACE
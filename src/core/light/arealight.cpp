@@ -0,0 +1,96 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "arealight.h"
+#include "core/primitive/shape/shape.h"
+
+exrBEGIN_NAMESPACE
+
+AreaLight::AreaLight(const Transform& transform, const Shape* shape, const exrSpectrum& emission)
+    : Light(transform, LightFlags::LIGHTFLAGS_AREA)
+    , m_Shape(shape)
+    , m_Emission(emission)
+    , m_Scale((transform.GetMatrix() * exrVector3(1, 0, 0)).Magnitude())
+{
+}
+
+exrSpectrum AreaLight::Sample_Li(const Interaction& interaction, const exrPoint2& u, exrVector3& wi, exrFloat& pdf,
+    VisibilityTester* vis) const
+{
+    // Solid angles do not change under rotations, translations and uniform scaling, so the pdf
+    // that the shape outputs in its own space holds in the world as well
+    Interaction it = m_Shape->Sample(ToShapeSpace(interaction), u, pdf);
+    it.m_Point = m_Transform.GetMatrix() * it.m_Point;
+    it.m_Normal = (m_Transform.GetMatrix() * it.m_Normal).Normalized();
+
+    wi = it.m_Point - interaction.m_Point;
+    if (pdf == 0.0f || wi.MagnitudeSquared() == 0.0f)
+    {
+        pdf = 0.0f;
+        return exrSpectrum(0.0f);
+    }
+
+    wi = wi.Normalized();
+    *vis = VisibilityTester(interaction, it);
+    return L(it, -wi);
+}
+
+exrFloat AreaLight::Pdf_Li(const Interaction& interaction, const exrVector3& wi) const
+{
+    return m_Shape->Pdf(ToShapeSpace(interaction), (m_Transform.GetInverseMatrix() * wi).Normalized());
+}
+
+exrSpectrum AreaLight::Power() const
+{
+    return m_Emission * (m_Shape->Area() * m_Scale * m_Scale * EXR_M_PI);
+}
+
+exrBool AreaLight::GetBounds(LightBounds& bounds) const
+{
+    // Bound the transformed corners of the shape's bounds
+    const AABB shapeBounds = m_Shape->ComputeBoundingVolume();
+    exrPoint3 min(Infinity), max(-Infinity);
+    for (exrU32 i = 0; i < 8; ++i)
+    {
+        const exrPoint3 corner((i & 1) ? shapeBounds.Max().x : shapeBounds.Min().x,
+                               (i & 2) ? shapeBounds.Max().y : shapeBounds.Min().y,
+                               (i & 4) ? shapeBounds.Max().z : shapeBounds.Min().z);
+        const exrPoint3 transformedCorner = m_Transform.GetMatrix() * corner;
+        min = Min(min, transformedCorner);
+        max = Max(max, transformedCorner);
+    }
+
+    exrVector3 axis;
+    exrFloat cosThetaO;
+    m_Shape->GetNormalBounds(axis, cosThetaO);
+
+    // Every point emits over the hemisphere around its normal
+    bounds = LightBounds(AABB(min, max), m_Transform.GetMatrix() * axis, Power().GetLuminance(), cosThetaO, 0.0f, false);
+    return true;
+}
+
+Interaction AreaLight::ToShapeSpace(const Interaction& interaction) const
+{
+    const Matrix4x4& worldToShape = m_Transform.GetInverseMatrix();
+    return Interaction(worldToShape * interaction.m_Point, (worldToShape * interaction.m_Normal).Normalized(), interaction.m_Wo);
+}
+
+exrEND_NAMESPACE
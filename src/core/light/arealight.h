@@ -0,0 +1,65 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "light.h"
+
+exrBEGIN_NAMESPACE
+
+class Shape;
+
+//! @brief A light that emits a constant radiance from the front of a shape
+//!
+//! Points are sampled on the shape in the space that the shape is intersected in, and are then
+//! placed in the world by the transform of the light, which is that of the shape's instance.
+class AreaLight : public Light
+{
+public:
+    //! @param transform        The object to world transform of the instance that the shape belongs to
+    //! @param shape            The shape that emits, which must have a non-zero area
+    //! @param emission         The radiance that the shape emits
+    AreaLight(const Transform& transform, const Shape* shape, const exrSpectrum& emission);
+
+    //! @brief Returns the radiance that a point on the light emits in direction w
+    inline exrSpectrum L(const Interaction& it, const exrVector3& w) const
+    {
+        return Dot(it.m_Normal, w) > 0.0f ? m_Emission : exrSpectrum(0.0f);
+    }
+
+    exrSpectrum Sample_Li(const Interaction& interaction, const exrPoint2& u, exrVector3& wi, exrFloat& pdf, VisibilityTester* vis) const override;
+    exrFloat Pdf_Li(const Interaction& interaction, const exrVector3& wi) const override;
+    exrSpectrum Power() const override;
+    exrBool GetBounds(LightBounds& bounds) const override;
+
+private:
+    //! @brief Transforms a reference point from world space into the space of the shape
+    Interaction ToShapeSpace(const Interaction& interaction) const;
+
+private:
+    const Shape* m_Shape;
+    const exrSpectrum m_Emission;
+
+    //! The scale of the instance transform, which only supports uniform scaling
+    const exrFloat m_Scale;
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,273 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "bvhlightsampler.h"
+#include "light.h"
+#include "core/sampling/lowdiscrepancy.h"
+
+exrBEGIN_NAMESPACE
+
+// The number of candidate split positions per axis that the build evaluates
+static constexpr exrU32 NumSplitBuckets = 12;
+
+// The bit trail of a light has one bit per level above it, so no leaf may be deeper than this
+static constexpr exrU32 MaxLeafDepth = 64;
+
+// Returns the depth of a tree that splits n lights in halves down to single lights
+static exrU32 MedianSplitDepth(exrU32 n)
+{
+    exrU32 depth = 0;
+    while ((exrU64(1) << depth) < n)
+        ++depth;
+    return depth;
+}
+
+// The cost of a node, in terms of the power, the solid angle that it may emit into and the
+// surface area of its bounds (the surface area orientation heuristic of Conty Estevez and Kulla
+// 2018). Long thin bounds are penalized when they are split along a short axis.
+static exrFloat EvaluateCost(const LightBounds& lb, const AABB& bounds, exrU32 dim)
+{
+    const exrFloat thetaO = exrSafeACos(lb.m_CosThetaO);
+    const exrFloat thetaE = exrSafeACos(lb.m_CosThetaE);
+    const exrFloat thetaW = exrMin(thetaO + thetaE, EXR_M_PI);
+    const exrFloat sinThetaO = exrSafeSqrt(1.0f - lb.m_CosThetaO * lb.m_CosThetaO);
+    const exrFloat solidAngle = 2 * EXR_M_PI * (1.0f - lb.m_CosThetaO) + EXR_M_PIOVER2 *
+        (2 * thetaW * sinThetaO - cos(thetaO - 2 * thetaW) - 2 * thetaO * sinThetaO + lb.m_CosThetaO);
+
+    const exrVector3 extents = bounds.GetExtents();
+    const exrFloat aspectRatio = exrMax(extents.x, exrMax(extents.y, extents.z)) / extents[dim];
+
+    return lb.m_Phi * solidAngle * aspectRatio * lb.m_Bounds.GetSurfaceArea();
+}
+
+BVHLightSampler::BVHLightSampler(const std::vector<Light*>& lights)
+{
+    std::vector<std::pair<exrU32, LightBounds>> boundedLights;
+
+    for (Light* light : lights)
+    {
+        LightBounds lightBounds;
+        if (!light->GetBounds(lightBounds))
+            m_InfiniteLights.push_back(light);
+        else if (lightBounds.m_Phi > 0.0f)
+        {
+            boundedLights.push_back(std::make_pair(static_cast<exrU32>(m_BoundedLights.size()), lightBounds));
+            m_BoundedLights.push_back(light);
+        }
+    }
+
+    if (!boundedLights.empty())
+    {
+        m_Nodes.reserve(2 * boundedLights.size() - 1);
+        BuildNode(boundedLights, 0, static_cast<exrU32>(boundedLights.size()), 0, 0);
+    }
+}
+
+exrU32 BVHLightSampler::BuildNode(std::vector<std::pair<exrU32, LightBounds>>& lights, exrU32 start, exrU32 end,
+    exrU64 bitTrail, exrU32 depth)
+{
+    const exrU32 nodeIndex = static_cast<exrU32>(m_Nodes.size());
+    exrAssert(depth + MedianSplitDepth(end - start) <= MaxLeafDepth, "Light BVH too deep for its bit trails!");
+
+    if (end - start == 1)
+    {
+        m_Nodes.push_back({ lights[start].second, lights[start].first, true });
+        m_LightToBitTrail[m_BoundedLights[lights[start].first]] = bitTrail;
+        return nodeIndex;
+    }
+
+    // Bound the lights and their centroids
+    AABB bounds = lights[start].second.m_Bounds;
+    exrPoint3 centroidMin = lights[start].second.GetCentroid();
+    exrPoint3 centroidMax = centroidMin;
+    for (exrU32 i = start + 1; i < end; ++i)
+    {
+        const exrPoint3 centroid = lights[i].second.GetCentroid();
+        bounds = AABB::Union(bounds, lights[i].second.m_Bounds);
+        centroidMin = Min(centroidMin, centroid);
+        centroidMax = Max(centroidMax, centroid);
+    }
+
+    // Find the cheapest split over the buckets of every axis. Once there are only just enough
+    // levels left to split the lights in halves, they are split by count instead.
+    exrFloat minCost = Infinity;
+    exrS32 minBucket = -1;
+    exrS32 minDim = -1;
+    const exrBool canSplitUnevenly = depth + MedianSplitDepth(end - start) < MaxLeafDepth;
+
+    for (exrU32 dim = 0; dim < 3 && canSplitUnevenly; ++dim)
+    {
+        const exrFloat centroidExtent = centroidMax[dim] - centroidMin[dim];
+        if (centroidExtent <= 0.0f)
+            continue;
+
+        LightBounds buckets[NumSplitBuckets];
+        for (exrU32 i = start; i < end; ++i)
+        {
+            const exrFloat offset = (lights[i].second.GetCentroid()[dim] - centroidMin[dim]) / centroidExtent;
+            const exrU32 bucket = exrMin(exrU32(offset * NumSplitBuckets), NumSplitBuckets - 1);
+            buckets[bucket] = LightBounds::Union(buckets[bucket], lights[i].second);
+        }
+
+        for (exrU32 split = 0; split < NumSplitBuckets - 1; ++split)
+        {
+            LightBounds below, above;
+            for (exrU32 i = 0; i <= split; ++i)
+                below = LightBounds::Union(below, buckets[i]);
+            for (exrU32 i = split + 1; i < NumSplitBuckets; ++i)
+                above = LightBounds::Union(above, buckets[i]);
+
+            const exrFloat cost = EvaluateCost(below, bounds, dim) + EvaluateCost(above, bounds, dim);
+            if (cost > 0.0f && cost < minCost)
+            {
+                minCost = cost;
+                minBucket = split;
+                minDim = dim;
+            }
+        }
+    }
+
+    exrU32 mid = (start + end) / 2;
+    if (minDim != -1)
+    {
+        const exrFloat centroidMinDim = centroidMin[minDim];
+        const exrFloat centroidExtent = centroidMax[minDim] - centroidMinDim;
+
+        auto midIter = std::partition(lights.begin() + start, lights.begin() + end, [&](const std::pair<exrU32, LightBounds>& light)
+        {
+            const exrFloat offset = (light.second.GetCentroid()[minDim] - centroidMinDim) / centroidExtent;
+            return exrS32(exrMin(exrU32(offset * NumSplitBuckets), NumSplitBuckets - 1)) <= minBucket;
+        });
+
+        // Both sides must still fit in the levels that remain below this node
+        mid = static_cast<exrU32>(midIter - lights.begin());
+        if (mid == start || mid == end ||
+            depth + 1 + MedianSplitDepth(exrMax(mid - start, end - mid)) > MaxLeafDepth)
+            mid = (start + end) / 2;
+    }
+
+    // The first child directly follows its parent, so only the second child's index is stored
+    m_Nodes.push_back({});
+    BuildNode(lights, start, mid, bitTrail, depth + 1);
+    const exrU32 secondChild = BuildNode(lights, mid, end, bitTrail | (exrU64(1) << depth), depth + 1);
+
+    m_Nodes[nodeIndex].m_Bounds = LightBounds::Union(m_Nodes[nodeIndex + 1].m_Bounds, m_Nodes[secondChild].m_Bounds);
+    m_Nodes[nodeIndex].m_ChildOrLightIndex = secondChild;
+    m_Nodes[nodeIndex].m_IsLeaf = false;
+    return nodeIndex;
+}
+
+const Light* BVHLightSampler::Sample(const Interaction& it, exrFloat u, exrFloat& pmf) const
+{
+    // Choose between the unbounded lights and the hierarchy as a whole
+    const exrFloat hierarchyProbability = GetHierarchyProbability();
+    const exrFloat infiniteProbability = 1.0f - hierarchyProbability;
+
+    if (u < infiniteProbability)
+    {
+        const exrU32 numInfiniteLights = static_cast<exrU32>(m_InfiniteLights.size());
+        const exrU32 index = exrMin(exrU32(u / infiniteProbability * numInfiniteLights), numInfiniteLights - 1);
+        pmf = infiniteProbability / numInfiniteLights;
+        return m_InfiniteLights[index];
+    }
+
+    if (m_Nodes.empty())
+        return nullptr;
+
+    // Descend the hierarchy, reusing the sample for every decision
+    u = exrMin((u - infiniteProbability) / hierarchyProbability, OneMinusFloatEpsilon);
+    pmf = hierarchyProbability;
+    exrU32 nodeIndex = 0;
+
+    while (!m_Nodes[nodeIndex].m_IsLeaf)
+    {
+        const Node& node = m_Nodes[nodeIndex];
+        const exrFloat importance0 = m_Nodes[nodeIndex + 1].m_Bounds.Importance(it.m_Point, it.m_Normal);
+        const exrFloat importance1 = m_Nodes[node.m_ChildOrLightIndex].m_Bounds.Importance(it.m_Point, it.m_Normal);
+
+        if (importance0 == 0.0f && importance1 == 0.0f)
+            return nullptr;
+
+        const exrFloat probability0 = importance0 / (importance0 + importance1);
+        if (u < probability0)
+        {
+            u = exrMin(u / probability0, OneMinusFloatEpsilon);
+            pmf *= probability0;
+            nodeIndex = nodeIndex + 1;
+        }
+        else
+        {
+            u = exrMin((u - probability0) / (1.0f - probability0), OneMinusFloatEpsilon);
+            pmf *= 1.0f - probability0;
+            nodeIndex = node.m_ChildOrLightIndex;
+        }
+    }
+
+    // A single light at the root is never compared against a sibling
+    if (nodeIndex == 0 && m_Nodes[0].m_Bounds.Importance(it.m_Point, it.m_Normal) == 0.0f)
+        return nullptr;
+
+    return m_BoundedLights[m_Nodes[nodeIndex].m_ChildOrLightIndex];
+}
+
+exrFloat BVHLightSampler::Pmf(const Interaction& it, const Light* light) const
+{
+    auto bitTrail = m_LightToBitTrail.find(light);
+    if (bitTrail == m_LightToBitTrail.end())
+    {
+        const exrFloat infiniteProbability = 1.0f - GetHierarchyProbability();
+        for (const Light* infiniteLight : m_InfiniteLights)
+        {
+            if (infiniteLight == light)
+                return infiniteProbability / m_InfiniteLights.size();
+        }
+
+        return 0.0f;
+    }
+
+    // Follow the path to the light, taking the same decisions as Sample()
+    exrU64 trail = bitTrail->second;
+    exrFloat pmf = GetHierarchyProbability();
+    exrU32 nodeIndex = 0;
+
+    while (!m_Nodes[nodeIndex].m_IsLeaf)
+    {
+        const Node& node = m_Nodes[nodeIndex];
+        const exrFloat importance0 = m_Nodes[nodeIndex + 1].m_Bounds.Importance(it.m_Point, it.m_Normal);
+        const exrFloat importance1 = m_Nodes[node.m_ChildOrLightIndex].m_Bounds.Importance(it.m_Point, it.m_Normal);
+
+        if (importance0 == 0.0f && importance1 == 0.0f)
+            return 0.0f;
+
+        const exrBool isSecondChild = trail & 1;
+        pmf *= (isSecondChild ? importance1 : importance0) / (importance0 + importance1);
+        nodeIndex = isSecondChild ? node.m_ChildOrLightIndex : nodeIndex + 1;
+        trail >>= 1;
+    }
+
+    // A single light at the root is never compared against a sibling
+    if (nodeIndex == 0 && m_Nodes[0].m_Bounds.Importance(it.m_Point, it.m_Normal) == 0.0f)
+        return 0.0f;
+
+    return pmf;
+}
+
+exrEND_NAMESPACE
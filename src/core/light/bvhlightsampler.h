@@ -0,0 +1,79 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "lightsampler.h"
+#include "lightbounds.h"
+#include <unordered_map>
+
+exrBEGIN_NAMESPACE
+
+//! @brief A light sampler that descends a hierarchy of light bounds towards the lights that
+//! contribute most to the shaded point
+//!
+//! Every interior node picks one of its two children in proportion to the importance of the
+//! child's bounds to the point, so the cost of choosing a light grows logarithmically with the
+//! number of lights, and lights that are far away or facing away are rarely chosen. Lights
+//! without bounds (directional and infinite lights) are chosen uniformly, with the same
+//! probability as the whole hierarchy.
+class BVHLightSampler : public LightSampler
+{
+public:
+    BVHLightSampler(const std::vector<Light*>& lights);
+
+    const Light* Sample(const Interaction& it, exrFloat u, exrFloat& pmf) const override;
+    exrFloat Pmf(const Interaction& it, const Light* light) const override;
+
+private:
+    struct Node
+    {
+        LightBounds m_Bounds;
+
+        //! The index of the second child for interior nodes (the first child directly follows
+        //! its parent), or of the light for leaves
+        exrU32 m_ChildOrLightIndex;
+        exrBool m_IsLeaf;
+    };
+
+    //! @brief Recursively builds the hierarchy over a range of lights
+    //! @param bitTrail         The path from the root to the node, one bit per level (1 = second child)
+    //! @return                 The index of the node
+    exrU32 BuildNode(std::vector<std::pair<exrU32, LightBounds>>& lights, exrU32 start, exrU32 end,
+        exrU64 bitTrail, exrU32 depth);
+
+    //! @brief Returns the probability that the hierarchy is descended instead of choosing an
+    //! unbounded light
+    inline exrFloat GetHierarchyProbability() const
+    {
+        return m_Nodes.empty() ? 0.0f : 1.0f / (m_InfiniteLights.size() + 1);
+    }
+
+private:
+    std::vector<Light*> m_BoundedLights;
+    std::vector<Light*> m_InfiniteLights;
+    std::vector<Node> m_Nodes;
+
+    //! The path from the root to the leaf of every bounded light, as passed to BuildNode()
+    std::unordered_map<const Light*, exrU64> m_LightToBitTrail;
+};
+
+exrEND_NAMESPACE
@@ -21,10 +21,16 @@
 #pragma once
 
 #include "directionallight.h"
+#include "core/scene/scene.h"
 
 exrBEGIN_NAMESPACE
 
-exrSpectrum DirectionalLight::Sample_Li(const Interaction& ref, exrVector3& wi, exrFloat& pdf,
+void DirectionalLight::Preprocess(const Scene& scene)
+{
+    m_SceneRadius = 0.5f * scene.GetBoundingVolume().GetExtents().Magnitude();
+}
+
+exrSpectrum DirectionalLight::Sample_Li(const Interaction& ref, const exrPoint2& u, exrVector3& wi, exrFloat& pdf,
     VisibilityTester* vis) const
 {
     exrVector3 direction = m_Transform.GetMatrix() * -exrVector3::Up();
@@ -36,7 +42,7 @@ exrSpectrum DirectionalLight::Sample_Li(const Interaction& ref, exrVector3& wi,
 
 exrSpectrum DirectionalLight::Power() const
 {
-    return m_Intensity;
+    return m_Intensity * (EXR_M_PI * m_SceneRadius * m_SceneRadius);
 }
 
 exrEND_NAMESPACE
\ No newline at end of file
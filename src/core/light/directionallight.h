@@ -31,11 +31,16 @@ public:
         : Light(transform, LightFlags::LIGHTFLAGS_DELTAPOSITION | LightFlags::LIGHTFLAGS_DELTADIRECTION) 
         , m_Intensity(intensity) {};
 
-    exrSpectrum Sample_Li(const Interaction& interaction, exrVector3& wi, exrFloat& pdf, VisibilityTester* vis) const override;
+    void Preprocess(const Scene& scene) override;
+
+    exrSpectrum Sample_Li(const Interaction& interaction, const exrPoint2& u, exrVector3& wi, exrFloat& pdf, VisibilityTester* vis) const override;
+
+    //! @brief Returns the power that falls onto the scene, through a disk the size of its bounding sphere
     exrSpectrum Power() const override;
 
 private:
     const exrSpectrum m_Intensity;
+    exrFloat m_SceneRadius = 0.0f;
 };
 
 exrEND_NAMESPACE
\ No newline at end of file
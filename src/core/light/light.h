@@ -22,6 +22,7 @@
 
 #include "core/elixir.h"
 #include "core/primitive/transform.h"
+#include "core/light/lightbounds.h"
 #include "core/light/visibilitytester.h"
 
 exrBEGIN_NAMESPACE
@@ -44,13 +45,28 @@ public:
         : m_Transform(transform)
         , m_Flags(flags) {};
 
-    inline exrBool IsDeltaLight() { return m_Flags & LightFlags::LIGHTFLAGS_DELTAPOSITION || m_Flags & LightFlags::LIGHTFLAGS_DELTADIRECTION; };
+    inline exrBool IsDeltaLight() const { return m_Flags & LightFlags::LIGHTFLAGS_DELTAPOSITION || m_Flags & LightFlags::LIGHTFLAGS_DELTADIRECTION; };
 
 public:
     virtual void Preprocess(const Scene& scene) {};
-    virtual exrSpectrum Sample_Li(const Interaction& interaction, exrVector3& wi, exrFloat& pdf, VisibilityTester* vis) const = 0;
+
+    //! @brief Samples the incident radiance from the light at a point
+    //! @param u                A uniform 2D sample that picks the point on the light, if it has an area
+    virtual exrSpectrum Sample_Li(const Interaction& interaction, const exrPoint2& u, exrVector3& wi, exrFloat& pdf, VisibilityTester* vis) const = 0;
+
+    //! @brief Returns the pdf (with respect to solid angle) that Sample_Li() samples wi with
+    //!
+    //! Delta lights can never be found by sampling directions, so their pdf is always 0.
+    virtual exrFloat Pdf_Li(const Interaction& interaction, const exrVector3& wi) const { return 0.0f; }
+
+    //! @brief Returns the radiance that an infinite light emits along a ray that escapes the scene
+    virtual exrSpectrum Le(const Ray& ray) const { return exrSpectrum(0.0f); }
     virtual exrSpectrum Power() const = 0;
 
+    //! @brief Outputs bounds on the emission of the light, for light sampling structures
+    //! @return                 False if the light is not bounded in space, such as an infinite light
+    virtual exrBool GetBounds(LightBounds& bounds) const { return false; }
+
 protected:
     const exrU32 m_Flags;
     const Transform m_Transform;
@@ -0,0 +1,129 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "lightbounds.h"
+
+exrBEGIN_NAMESPACE
+
+// cos(max(0, a - b)) and sin(max(0, a - b)), given the sines and cosines of two angles in [0, pi]
+static inline exrFloat CosSubClamped(exrFloat sinA, exrFloat cosA, exrFloat sinB, exrFloat cosB)
+{
+    return cosA > cosB ? 1.0f : cosA * cosB + sinA * sinB;
+}
+
+static inline exrFloat SinSubClamped(exrFloat sinA, exrFloat cosA, exrFloat sinB, exrFloat cosB)
+{
+    return cosA > cosB ? 0.0f : sinA * cosB - cosA * sinB;
+}
+
+exrFloat LightBounds::Importance(const exrPoint3& point, const exrVector3& normal) const
+{
+    // Clamp the distance to the size of the bounds, so that points inside or right next to a
+    // large group of lights do not get an unbounded importance
+    const exrPoint3 centroid = GetCentroid();
+    const exrVector3 toPoint = point - centroid;
+    const exrFloat radiusSquared = m_Bounds.GetExtents().MagnitudeSquared() * 0.25f;
+    const exrFloat distanceSquared = exrMax(toPoint.MagnitudeSquared(), sqrt(radiusSquared));
+    const exrVector3 wi = toPoint.Normalized();
+
+    // The angle between the axis and the point
+    exrFloat cosThetaW = Dot(m_Axis, wi);
+    if (m_TwoSided)
+        cosThetaW = abs(cosThetaW);
+    const exrFloat sinThetaW = exrSafeSqrt(1.0f - cosThetaW * cosThetaW);
+
+    // The angle that the bounds subtend as seen from the point, through their bounding sphere
+    const exrFloat cosThetaB = toPoint.MagnitudeSquared() < radiusSquared ? -1.0f :
+        exrSafeSqrt(1.0f - radiusSquared / toPoint.MagnitudeSquared());
+    const exrFloat sinThetaB = exrSafeSqrt(1.0f - cosThetaB * cosThetaB);
+
+    // The smallest angle between any emitting normal and any direction towards the point
+    const exrFloat sinThetaO = exrSafeSqrt(1.0f - m_CosThetaO * m_CosThetaO);
+    const exrFloat cosThetaX = CosSubClamped(sinThetaW, cosThetaW, sinThetaO, m_CosThetaO);
+    const exrFloat sinThetaX = SinSubClamped(sinThetaW, cosThetaW, sinThetaO, m_CosThetaO);
+    const exrFloat cosThetaP = CosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+    if (cosThetaP <= m_CosThetaE)
+        return 0.0f;
+
+    exrFloat importance = m_Phi * cosThetaP / distanceSquared;
+
+    // The smallest angle between the surface normal and any direction towards the lights
+    if (normal.MagnitudeSquared() > 0.0f)
+    {
+        const exrFloat cosThetaI = AbsDot(wi, normal);
+        const exrFloat sinThetaI = exrSafeSqrt(1.0f - cosThetaI * cosThetaI);
+        importance *= CosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+    }
+
+    return exrMax(importance, 0.0f);
+}
+
+LightBounds LightBounds::Union(const LightBounds& lb1, const LightBounds& lb2)
+{
+    if (lb1.m_Phi == 0.0f)
+        return lb2;
+    if (lb2.m_Phi == 0.0f)
+        return lb1;
+
+    LightBounds result;
+    result.m_Bounds = AABB::Union(lb1.m_Bounds, lb2.m_Bounds);
+    result.m_Phi = lb1.m_Phi + lb2.m_Phi;
+    result.m_CosThetaE = exrMin(lb1.m_CosThetaE, lb2.m_CosThetaE);
+    result.m_TwoSided = lb1.m_TwoSided || lb2.m_TwoSided;
+
+    // Find the smallest cone that contains both normal cones
+    const exrFloat thetaA = exrSafeACos(lb1.m_CosThetaO);
+    const exrFloat thetaB = exrSafeACos(lb2.m_CosThetaO);
+    const exrFloat thetaD = exrSafeACos(Dot(lb1.m_Axis, lb2.m_Axis));
+
+    if (exrMin(thetaD + thetaB, EXR_M_PI) <= thetaA)
+    {
+        result.m_Axis = lb1.m_Axis;
+        result.m_CosThetaO = lb1.m_CosThetaO;
+        return result;
+    }
+
+    if (exrMin(thetaD + thetaA, EXR_M_PI) <= thetaB)
+    {
+        result.m_Axis = lb2.m_Axis;
+        result.m_CosThetaO = lb2.m_CosThetaO;
+        return result;
+    }
+
+    const exrFloat thetaO = (thetaA + thetaD + thetaB) * 0.5f;
+    const exrVector3 rotationAxis = Cross(lb1.m_Axis, lb2.m_Axis);
+    if (thetaO >= EXR_M_PI || rotationAxis.MagnitudeSquared() == 0.0f)
+    {
+        result.m_Axis = lb1.m_Axis;
+        result.m_CosThetaO = -1.0f;
+        return result;
+    }
+
+    // Rotate the first axis towards the second until the cone just contains the first cone
+    const exrFloat thetaR = thetaO - thetaA;
+    const exrVector3 k = rotationAxis.Normalized();
+    const exrVector3 v = lb1.m_Axis;
+    result.m_Axis = (v * cos(thetaR) + Cross(k, v) * sin(thetaR) + k * Dot(k, v) * (1.0f - cos(thetaR))).Normalized();
+    result.m_CosThetaO = cos(thetaO);
+    return result;
+}
+
+exrEND_NAMESPACE
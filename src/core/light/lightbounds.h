@@ -0,0 +1,67 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "core/elixir.h"
+#include "core/spatial/utils/aabb.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A conservative bound on where a light, or a group of lights, emits from and towards
+//!
+//! Emission is bounded by a box, the total power, and two cones around a common axis: every
+//! emitting normal lies within m_CosThetaO of m_Axis, and every normal emits only within
+//! m_CosThetaE of itself. This is enough to bound the contribution of the lights to any point
+//! in space (see Conty Estevez and Kulla 2018).
+struct LightBounds
+{
+    LightBounds() = default;
+
+    LightBounds(const AABB& bounds, const exrVector3& axis, exrFloat phi, exrFloat cosThetaO,
+        exrFloat cosThetaE, exrBool twoSided)
+        : m_Bounds(bounds)
+        , m_Axis(axis.Normalized())
+        , m_Phi(phi)
+        , m_CosThetaO(cosThetaO)
+        , m_CosThetaE(cosThetaE)
+        , m_TwoSided(twoSided) {};
+
+    //! @brief Returns the centroid of the bounding box
+    inline exrPoint3 GetCentroid() const { return m_Bounds.Min() + m_Bounds.GetExtents() * 0.5f; }
+
+    //! @brief Returns an estimate of how much the lights contribute to a point
+    //! @param point            The point that is being lit
+    //! @param normal           The surface normal at the point, or a zero vector for points in media
+    exrFloat Importance(const exrPoint3& point, const exrVector3& normal) const;
+
+    //! @brief Returns bounds that contain both inputs
+    static LightBounds Union(const LightBounds& lb1, const LightBounds& lb2);
+
+    AABB m_Bounds = AABB(exrPoint3(0.0f), exrPoint3(0.0f));
+    exrVector3 m_Axis = exrVector3(0.0f, 0.0f, 1.0f);
+    exrFloat m_Phi = 0.0f;
+    exrFloat m_CosThetaO = 1.0f;
+    exrFloat m_CosThetaE = 1.0f;
+    exrBool m_TwoSided = false;
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,57 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "lightsampler.h"
+#include "bvhlightsampler.h"
+#include "powerlightsampler.h"
+#include "uniformlightsampler.h"
+
+exrBEGIN_NAMESPACE
+
+std::unique_ptr<LightSampler> LightSampler::Create(LightSamplerType type, const std::vector<Light*>& lights)
+{
+    switch (type)
+    {
+    case LIGHTSAMPLERTYPE_UNIFORM:
+        return std::make_unique<UniformLightSampler>(lights);
+    case LIGHTSAMPLERTYPE_POWER:
+        return std::make_unique<PowerLightSampler>(lights);
+    case LIGHTSAMPLERTYPE_BVH:
+    default:
+        return std::make_unique<BVHLightSampler>(lights);
+    }
+}
+
+exrBool LightSampler::ParseLightSamplerType(const exrString& name, LightSamplerType& type)
+{
+    if (name == "uniform")
+        type = LIGHTSAMPLERTYPE_UNIFORM;
+    else if (name == "power")
+        type = LIGHTSAMPLERTYPE_POWER;
+    else if (name == "bvh")
+        type = LIGHTSAMPLERTYPE_BVH;
+    else
+        return false;
+
+    return true;
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,68 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "system/system.h"
+#include "math/math.h"
+
+exrBEGIN_NAMESPACE
+
+class Light;
+struct Interaction;
+
+//! The structures that a light can be chosen for direct lighting with
+enum LightSamplerType
+{
+    LIGHTSAMPLERTYPE_UNIFORM,   //!< Every light with the same probability
+    LIGHTSAMPLERTYPE_POWER,     //!< Every light in proportion to its power
+    LIGHTSAMPLERTYPE_BVH        //!< In proportion to an estimate of the light's contribution to the shaded point
+};
+
+//! @brief Chooses the light that a shaded point takes its direct lighting sample from
+//!
+//! Next event estimation only samples a single light per bounce, so scenes with many lights
+//! depend on choosing the lights that matter most at each point. A light sampler is built
+//! once per render and is shared by all threads.
+class LightSampler
+{
+public:
+    virtual ~LightSampler() = default;
+
+    //! @brief Chooses a light for a point
+    //! @param it               The point that is being lit
+    //! @param u                A uniform 1D sample
+    //! @param pmf              Outputs the probability that the light is chosen
+    //! @return                 The chosen light, or nullptr if no light can contribute
+    virtual const Light* Sample(const Interaction& it, exrFloat u, exrFloat& pmf) const = 0;
+
+    //! @brief Returns the probability that Sample() chooses a light for a point
+    virtual exrFloat Pmf(const Interaction& it, const Light* light) const = 0;
+
+    //! @brief Creates a light sampler of the given type over a set of lights
+    static std::unique_ptr<LightSampler> Create(LightSamplerType type, const std::vector<Light*>& lights);
+
+    //! @brief Parses the name of a light sampler type (uniform, power or bvh)
+    //! @return                 False if the name is unknown
+    static exrBool ParseLightSamplerType(const exrString& name, LightSamplerType& type);
+};
+
+exrEND_NAMESPACE
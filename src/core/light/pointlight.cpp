@@ -24,7 +24,7 @@
 
 exrBEGIN_NAMESPACE
 
-exrSpectrum PointLight::Sample_Li(const Interaction& ref, exrVector3& wi, exrFloat& pdf,
+exrSpectrum PointLight::Sample_Li(const Interaction& ref, const exrPoint2& u, exrVector3& wi, exrFloat& pdf,
     VisibilityTester* vis) const
 {
     *vis = VisibilityTester(ref, Interaction(m_Transform.GetPosition()));
@@ -37,4 +37,12 @@ exrSpectrum PointLight::Power() const
 {
     return m_Intensity * 4 * EXR_M_PI;
 }
+
+exrBool PointLight::GetBounds(LightBounds& bounds) const
+{
+    // A point light emits in all directions from a single point
+    const exrPoint3 position = m_Transform.GetPosition();
+    bounds = LightBounds(AABB(position, position), exrVector3(0.0f, 0.0f, 1.0f), Power().GetLuminance(), -1.0f, 0.0f, false);
+    return true;
+}
 exrEND_NAMESPACE
\ No newline at end of file
@@ -31,8 +31,9 @@ public:
         : Light(transform, LightFlags::LIGHTFLAGS_DELTAPOSITION) 
         , m_Intensity(intensity) {};
 
-    exrSpectrum Sample_Li(const Interaction& interaction, exrVector3& wi, exrFloat& pdf, VisibilityTester* vis) const override;
+    exrSpectrum Sample_Li(const Interaction& interaction, const exrPoint2& u, exrVector3& wi, exrFloat& pdf, VisibilityTester* vis) const override;
     exrSpectrum Power() const override;
+    exrBool GetBounds(LightBounds& bounds) const override;
 
 private:
     const exrSpectrum m_Intensity;
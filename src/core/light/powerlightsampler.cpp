@@ -0,0 +1,54 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "powerlightsampler.h"
+#include "light.h"
+
+exrBEGIN_NAMESPACE
+
+PowerLightSampler::PowerLightSampler(const std::vector<Light*>& lights)
+    : m_Lights(lights)
+{
+    std::vector<exrFloat> weights(lights.size());
+    for (exrU32 i = 0; i < lights.size(); ++i)
+    {
+        weights[i] = lights[i]->Power().GetLuminance();
+        m_LightToIndex[lights[i]] = i;
+    }
+
+    m_AliasTable = AliasTable(weights);
+}
+
+const Light* PowerLightSampler::Sample(const Interaction& it, exrFloat u, exrFloat& pmf) const
+{
+    if (m_Lights.empty())
+        return nullptr;
+
+    return m_Lights[m_AliasTable.Sample(u, &pmf)];
+}
+
+exrFloat PowerLightSampler::Pmf(const Interaction& it, const Light* light) const
+{
+    auto index = m_LightToIndex.find(light);
+    return index == m_LightToIndex.end() ? 0.0f : m_AliasTable.Pmf(index->second);
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,48 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "lightsampler.h"
+#include "core/sampling/aliastable.h"
+#include <unordered_map>
+
+exrBEGIN_NAMESPACE
+
+//! @brief A light sampler that chooses lights in proportion to their power
+//!
+//! Ignores where the lights are, so it is only a good fit for scenes where most lights
+//! reach most of the scene.
+class PowerLightSampler : public LightSampler
+{
+public:
+    PowerLightSampler(const std::vector<Light*>& lights);
+
+    const Light* Sample(const Interaction& it, exrFloat u, exrFloat& pmf) const override;
+    exrFloat Pmf(const Interaction& it, const Light* light) const override;
+
+private:
+    std::vector<Light*> m_Lights;
+    AliasTable m_AliasTable;
+    std::unordered_map<const Light*, exrU32> m_LightToIndex;
+};
+
+exrEND_NAMESPACE
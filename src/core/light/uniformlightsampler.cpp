@@ -0,0 +1,41 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "uniformlightsampler.h"
+
+exrBEGIN_NAMESPACE
+
+const Light* UniformLightSampler::Sample(const Interaction& it, exrFloat u, exrFloat& pmf) const
+{
+    const exrU32 numLights = static_cast<exrU32>(m_Lights.size());
+    if (numLights == 0)
+        return nullptr;
+
+    pmf = 1.0f / numLights;
+    return m_Lights[exrMin(exrU32(u * numLights), numLights - 1)];
+}
+
+exrFloat UniformLightSampler::Pmf(const Interaction& it, const Light* light) const
+{
+    return m_Lights.empty() ? 0.0f : 1.0f / m_Lights.size();
+}
+
+exrEND_NAMESPACE
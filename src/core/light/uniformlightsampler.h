@@ -0,0 +1,42 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "lightsampler.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A light sampler that chooses every light with the same probability
+class UniformLightSampler : public LightSampler
+{
+public:
+    UniformLightSampler(const std::vector<Light*>& lights)
+        : m_Lights(lights) {};
+
+    const Light* Sample(const Interaction& it, exrFloat u, exrFloat& pmf) const override;
+    exrFloat Pmf(const Interaction& it, const Light* light) const override;
+
+private:
+    std::vector<Light*> m_Lights;
+};
+
+exrEND_NAMESPACE
@@ -32,6 +32,17 @@ class Material
 {
 public:
     virtual void ComputeScatteringFunctions(SurfaceInteraction* si, MemoryArena& arena) const = 0;
+
+    //! @brief Sets the radiance that surfaces with this material emit from their front side
+    inline void SetEmission(const exrSpectrum& emission) { m_Emission = emission; }
+
+    inline const exrSpectrum& GetEmission() const { return m_Emission; }
+
+    //! @brief Returns true if the shapes with this material are area lights
+    inline exrBool IsEmissive() const { return !m_Emission.IsBlack(); }
+
+protected:
+    exrSpectrum m_Emission = exrSpectrum(0.0f);
 };
 
 exrEND_NAMESPACE
\ No newline at end of file
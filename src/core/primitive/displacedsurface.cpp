@@ -0,0 +1,213 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "displacedsurface.h"
+#include "tessellationcache.h"
+
+exrBEGIN_NAMESPACE
+
+static std::atomic<exrU32> g_NextSurfaceId(0);
+
+// Lattice value noise in [-1, 1]
+static exrFloat LatticeValue(exrS32 x, exrS32 y, exrS32 z)
+{
+    exrU32 hash = exrU32(x) * 73856093u ^ exrU32(y) * 19349663u ^ exrU32(z) * 83492791u;
+    hash ^= hash >> 13;
+    hash *= 0x5bd1e995u;
+    hash ^= hash >> 15;
+    return exrFloat(hash & 0xFFFFFF) / exrFloat(0xFFFFFF) * 2.0f - 1.0f;
+}
+
+static exrFloat ValueNoise(const exrPoint3& p)
+{
+    const exrPoint3 cell = Floor(p);
+    const exrS32 x = exrS32(cell.x), y = exrS32(cell.y), z = exrS32(cell.z);
+    exrVector3 f = p - cell;
+
+    // Smoothstep the fraction so that the noise has no visible creases along cell borders
+    f = exrVector3(f.x * f.x * (3 - 2 * f.x), f.y * f.y * (3 - 2 * f.y), f.z * f.z * (3 - 2 * f.z));
+
+    const exrFloat x00 = exrLerp(LatticeValue(x, y, z), LatticeValue(x + 1, y, z), f.x);
+    const exrFloat x10 = exrLerp(LatticeValue(x, y + 1, z), LatticeValue(x + 1, y + 1, z), f.x);
+    const exrFloat x01 = exrLerp(LatticeValue(x, y, z + 1), LatticeValue(x + 1, y, z + 1), f.x);
+    const exrFloat x11 = exrLerp(LatticeValue(x, y + 1, z + 1), LatticeValue(x + 1, y + 1, z + 1), f.x);
+    return exrLerp(exrLerp(x00, x10, f.y), exrLerp(x01, x11, f.y), f.z);
+}
+
+// Four octaves of value noise, normalized to [-1, 1]
+static exrFloat FractalNoise(const exrPoint3& p)
+{
+    exrFloat sum = 0.0f;
+    exrFloat weight = 0.5f;
+    exrFloat totalWeight = 0.0f;
+    exrFloat frequency = 1.0f;
+
+    for (exrU32 i = 0; i < 4; ++i)
+    {
+        sum += weight * ValueNoise(p * frequency);
+        totalWeight += weight;
+        weight *= 0.5f;
+        frequency *= 2.0f;
+    }
+
+    return sum / totalWeight;
+}
+
+static void GetPatchVertices(const Mesh& mesh, exrU32 patchIndex, Vertex (&vertices)[3])
+{
+    mesh.GetVertexAtIndex(patchIndex, vertices[0], vertices[1], vertices[2]);
+
+    // Faces without vertex normals stay flat
+    const exrVector3 faceNormal = Cross(vertices[1].m_Position - vertices[0].m_Position,
+        vertices[2].m_Position - vertices[0].m_Position).Normalized();
+
+    for (Vertex& vertex : vertices)
+        vertex.m_Normal = vertex.m_Normal.MagnitudeSquared() > 0 ? vertex.m_Normal.Normalized() : faceNormal;
+}
+
+static void BuildNode(TessellatedPatch& patch, exrU32 node, const TessellatedPatch::GridCoord* corners, exrU32 depth)
+{
+    if (depth == patch.m_Level)
+    {
+        const exrPoint3& p0 = patch.m_Positions[patch.GetVertexIndex(corners[0])];
+        const exrPoint3& p1 = patch.m_Positions[patch.GetVertexIndex(corners[1])];
+        const exrPoint3& p2 = patch.m_Positions[patch.GetVertexIndex(corners[2])];
+        patch.m_Nodes[node] = AABB(Min(Min(p0, p1), p2), Max(Max(p0, p1), p2));
+        return;
+    }
+
+    TessellatedPatch::GridCoord children[12];
+    TessellatedPatch::Subdivide(corners, children);
+
+    for (exrU32 i = 0; i < 4; ++i)
+        BuildNode(patch, node * 4 + 1 + i, children + i * 3, depth + 1);
+
+    patch.m_Nodes[node] = AABB::Union(
+        AABB::Union(patch.m_Nodes[node * 4 + 1], patch.m_Nodes[node * 4 + 2]),
+        AABB::Union(patch.m_Nodes[node * 4 + 3], patch.m_Nodes[node * 4 + 4]));
+}
+
+DisplacedSurface::DisplacedSurface(const std::shared_ptr<Mesh>& baseMesh, const DisplacementSettings& settings,
+    const TessellationCache& cache)
+    : m_BaseMesh(baseMesh)
+    , m_Settings(settings)
+    , m_Cache(cache)
+    , m_Id(g_NextSurfaceId++)
+{
+    m_Settings.m_Level = exrMin(m_Settings.m_Level, DisplacementSettings::MaxLevel);
+    m_Settings.m_Smoothing = exrClamp(m_Settings.m_Smoothing, 0.0f, 1.0f);
+    m_Settings.m_Amplitude = abs(m_Settings.m_Amplitude);
+}
+
+AABB DisplacedSurface::ComputePatchBounds(exrU32 patchIndex) const
+{
+    Vertex vertices[3];
+    GetPatchVertices(*m_BaseMesh, patchIndex, vertices);
+
+    // Phong tessellation moves a point by at most the distance of the face corners from the
+    // tangent planes at the other corners, and displacement by at most the amplitude
+    exrFloat maxBulge = 0.0f;
+    for (exrU32 i = 0; i < 3; ++i)
+    {
+        for (exrU32 j = 0; j < 3; ++j)
+            maxBulge = exrMax(maxBulge, abs(Dot(vertices[j].m_Position - vertices[i].m_Position, vertices[i].m_Normal)));
+    }
+
+    const exrVector3 padding(maxBulge * m_Settings.m_Smoothing + m_Settings.m_Amplitude);
+    const exrPoint3 min = Min(Min(vertices[0].m_Position, vertices[1].m_Position), vertices[2].m_Position);
+    const exrPoint3 max = Max(Max(vertices[0].m_Position, vertices[1].m_Position), vertices[2].m_Position);
+    return AABB(min - padding, max + padding);
+}
+
+const TessellatedPatch& DisplacedSurface::GetPatch(exrU32 patchIndex) const
+{
+    return m_Cache.GetPatch(*this, patchIndex);
+}
+
+std::shared_ptr<TessellatedPatch> DisplacedSurface::Tessellate(exrU32 patchIndex) const
+{
+    Vertex vertices[3];
+    GetPatchVertices(*m_BaseMesh, patchIndex, vertices);
+
+    const exrS32 n = 1 << m_Settings.m_Level;
+    std::shared_ptr<TessellatedPatch> patch = std::make_shared<TessellatedPatch>();
+    patch->m_Level = m_Settings.m_Level;
+    for (exrU32 i = 0; i < 3; ++i)
+        patch->m_TexCoords[i] = vertices[i].m_TexCoord;
+    patch->m_Positions.resize((n + 1) * (n + 2) / 2);
+    patch->m_Normals.resize(patch->m_Positions.size(), exrVector3::Zero());
+    patch->m_Nodes.resize(((exrU32(1) << (2 * m_Settings.m_Level + 2)) - 1) / 3);
+
+    // Displace every vertex of the grid
+    for (exrS32 i = 0; i <= n; ++i)
+    {
+        for (exrS32 j = 0; i + j <= n; ++j)
+        {
+            const exrFloat w[3] = { exrFloat(n - i - j) / n, exrFloat(i) / n, exrFloat(j) / n };
+            const exrPoint3 flat = vertices[0].m_Position + w[1] * (vertices[1].m_Position - vertices[0].m_Position) +
+                w[2] * (vertices[2].m_Position - vertices[0].m_Position);
+
+            exrVector3 normal = exrVector3::Zero();
+            exrVector3 bulge = exrVector3::Zero();
+            for (exrU32 k = 0; k < 3; ++k)
+            {
+                normal += w[k] * vertices[k].m_Normal;
+                bulge += w[k] * Dot(flat - vertices[k].m_Position, vertices[k].m_Normal) * vertices[k].m_Normal;
+            }
+
+            exrPoint3 position = flat - m_Settings.m_Smoothing * bulge;
+            position += m_Settings.m_Amplitude * FractalNoise(position * m_Settings.m_Frequency) * normal.Normalized();
+            patch->m_Positions[patch->GetVertexIndex({ i, j })] = position;
+        }
+    }
+
+    // Shading normals are the area weighted normals of the micro triangles around each vertex.
+    // The grid has n * n micro triangles, n * (n + 1) / 2 of them pointing "up".
+    for (exrS32 i = 0; i < n; ++i)
+    {
+        for (exrS32 j = 0; i + j < n; ++j)
+        {
+            const exrU32 up[3] = { patch->GetVertexIndex({ i, j }), patch->GetVertexIndex({ i + 1, j }), patch->GetVertexIndex({ i, j + 1 }) };
+            const exrVector3 upNormal = Cross(patch->m_Positions[up[1]] - patch->m_Positions[up[0]], patch->m_Positions[up[2]] - patch->m_Positions[up[0]]);
+            for (exrU32 index : up)
+                patch->m_Normals[index] += upNormal;
+
+            if (i + j + 1 < n)
+            {
+                const exrU32 down[3] = { up[1], patch->GetVertexIndex({ i + 1, j + 1 }), up[2] };
+                const exrVector3 downNormal = Cross(patch->m_Positions[down[1]] - patch->m_Positions[down[0]], patch->m_Positions[down[2]] - patch->m_Positions[down[0]]);
+                for (exrU32 index : down)
+                    patch->m_Normals[index] += downNormal;
+            }
+        }
+    }
+
+    // Keep the normals on the same side as the base mesh normals, whatever the winding of the face
+    const exrVector3 baseNormal = vertices[0].m_Normal + vertices[1].m_Normal + vertices[2].m_Normal;
+    for (exrVector3& normal : patch->m_Normals)
+        normal = Dot(normal, baseNormal) < 0 ? -normal.Normalized() : normal.Normalized();
+
+    const TessellatedPatch::GridCoord root[3] = { { 0, 0 }, { n, 0 }, { 0, n } };
+    BuildNode(*patch, 0, root, 0);
+
+    return patch;
+}
+
+exrEND_NAMESPACE
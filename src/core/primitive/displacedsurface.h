@@ -0,0 +1,93 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/elixir.h"
+#include "core/primitive/mesh.h"
+#include "core/spatial/utils/aabb.h"
+
+exrBEGIN_NAMESPACE
+
+struct TessellatedPatch;
+class TessellationCache;
+
+//! @brief Controls how the faces of a mesh are refined at render time
+struct DisplacementSettings
+{
+    //! The maximum number of subdivision levels
+    static constexpr exrU32 MaxLevel = 8;
+
+    //! Every face is split into 4^level micro triangles. Zero renders the mesh as it is.
+    exrU32 m_Level = 0;
+
+    //! How far the surface is pulled towards the curved surface implied by the vertex normals,
+    //! from 0 (flat faces) to 1
+    exrFloat m_Smoothing = 0.75f;
+
+    //! The largest distance that vertices are displaced along their normal
+    exrFloat m_Amplitude = 0.0f;
+
+    //! The spatial frequency of the displacement noise
+    exrFloat m_Frequency = 1.0f;
+};
+
+//! @brief A mesh that is subdivided and displaced lazily, one face at a time
+//!
+//! Each face of the base mesh is a patch that is tessellated only when a ray first reaches
+//! its bounds. Faces are refined with Phong tessellation, which curves them using only their
+//! own vertex normals, so every patch can be tessellated independently of its neighbours.
+//! The refined surface is then displaced along its normal by fractal noise.
+class DisplacedSurface
+{
+public:
+    //! @brief Creates a displaced surface over the faces of a mesh
+    //! @param baseMesh         The control mesh. Each face becomes one patch.
+    //! @param settings         The subdivision and displacement settings
+    //! @param cache            The cache that holds the tessellated patches
+    DisplacedSurface(const std::shared_ptr<Mesh>& baseMesh, const DisplacementSettings& settings,
+        const TessellationCache& cache);
+
+    //! @brief Returns a conservative bound of a patch, without tessellating it
+    AABB ComputePatchBounds(exrU32 patchIndex) const;
+
+    //! @brief Returns the tessellated geometry of a patch, tessellating it if needed
+    //!
+    //! The reference is valid until the calling thread asks for another patch, see
+    //! TessellationCache::GetPatch().
+    const TessellatedPatch& GetPatch(exrU32 patchIndex) const;
+
+    //! @brief Tessellates a patch, bypassing the cache
+    std::shared_ptr<TessellatedPatch> Tessellate(exrU32 patchIndex) const;
+
+    inline exrU32 GetId() const { return m_Id; }
+    inline exrU32 GetNumPatches() const { return m_BaseMesh->m_NumFaces; }
+    inline const DisplacementSettings& GetSettings() const { return m_Settings; }
+
+private:
+    std::shared_ptr<Mesh> m_BaseMesh;
+    DisplacementSettings m_Settings;
+    const TessellationCache& m_Cache;
+
+    //! A process-unique id, used to tell patches of different surfaces apart in the cache
+    const exrU32 m_Id;
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,102 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "geometrycache.h"
+
+exrBEGIN_NAMESPACE
+
+static std::atomic<exrU64> g_NextCacheId(0);
+
+// Most consecutive reads from a thread land on the same page, so each thread remembers the
+// last page it touched and only goes through the (locked) LRU when it moves to another one.
+struct LastPageCache
+{
+    exrU64 m_CacheId = ~exrU64(0);
+    exrU64 m_PageIndex = 0;
+    std::shared_ptr<MappedRegion> m_Page;
+};
+
+static thread_local LastPageCache t_LastPage;
+
+GeometryCache::GeometryCache(const exrString& filename, exrU64 residencyBudget)
+    : m_File(filename)
+    , m_ResidentPages(exrMax(residencyBudget, PageSize))
+    , m_CacheId(g_NextCacheId++)
+{
+    exrAssert(PageSize % MappedFile::GetMappingGranularity() == 0, "Geometry cache page size is not a multiple of the mapping granularity!");
+}
+
+exrU64 GeometryCache::Allocate(exrU64 size)
+{
+    // Pad every block to a whole number of pages so that a page is never shared by two blocks,
+    // which could still be in the middle of being written. This wastes at most one page per block.
+    return m_File.Reserve((size + PageSize - 1) / PageSize * PageSize);
+}
+
+void GeometryCache::Write(exrU64 offset, const void* data, exrU64 size)
+{
+    m_File.WriteAt(offset, data, size);
+}
+
+void GeometryCache::Read(exrU64 offset, exrU64 size, void* dst) const
+{
+    exrByte* out = static_cast<exrByte*>(dst);
+
+    while (size > 0)
+    {
+        const exrU64 pageIndex = offset / PageSize;
+        const exrU64 pageOffset = offset % PageSize;
+        const exrU64 chunk = exrMin(size, PageSize - pageOffset);
+
+        if (t_LastPage.m_CacheId != m_CacheId || t_LastPage.m_PageIndex != pageIndex)
+        {
+            t_LastPage.m_Page = m_ResidentPages.GetOrLoad(pageIndex, [&](exrU64& cost)
+            {
+                cost = PageSize;
+                return m_File.Map(pageIndex * PageSize, PageSize);
+            });
+
+            if (t_LastPage.m_Page == nullptr)
+                throw std::runtime_error("Unable to page in geometry from the cache file!");
+
+            t_LastPage.m_CacheId = m_CacheId;
+            t_LastPage.m_PageIndex = pageIndex;
+        }
+
+        memcpy(out, t_LastPage.m_Page->GetData() + pageOffset, chunk);
+
+        out += chunk;
+        offset += chunk;
+        size -= chunk;
+    }
+}
+
+void GeometryCache::PrintStatistics() const
+{
+    LRUCache<exrU64, MappedRegion>::Statistics stats = m_ResidentPages.GetStatistics();
+    const exrU64 totalAccesses = exrMax(stats.m_Hits + stats.m_Misses, exrU64(1));
+
+    exrInfoLine("Geometry cache: " << m_File.GetSize() / (1024.0 * 1024.0) << " MB on disk, "
+        << stats.m_PeakResidentCost / (1024.0 * 1024.0) << " MB peak resident");
+    exrInfoLine("\t   " << stats.m_Misses << " page faults (" << (100.0 * stats.m_Misses / totalAccesses) << "%), "
+        << stats.m_Hits << " hits, " << stats.m_Evictions << " evictions");
+}
+
+exrEND_NAMESPACE
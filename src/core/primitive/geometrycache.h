@@ -0,0 +1,79 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/elixir.h"
+#include "system/memory/lrucache.h"
+#include "system/memory/mappedfile.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief An out-of-core store for geometry that does not fit into memory
+//!
+//! Geometry is appended to a cache file on disk, which is then paged back in on demand in
+//! fixed size pages. Only a bounded number of pages are mapped at any time; the least
+//! recently used pages are unmapped when the residency budget is exceeded.
+//!
+//! Only mesh vertex data is paged. The triangles, primitives and BVH nodes built over a mesh
+//! stay resident, because the accelerators hand out primitive pointers from their leaves.
+class GeometryCache
+{
+public:
+    //! The size of a single page. Must be a multiple of the mapping granularity of all platforms.
+    static constexpr exrU64 PageSize = 65536;
+
+    //! @brief Creates an empty geometry cache backed by a file on disk
+    //! @param filename         The path of the cache file. The file is deleted with the cache.
+    //! @param residencyBudget  The maximum number of bytes that may be mapped at once
+    GeometryCache(const exrString& filename, exrU64 residencyBudget);
+
+    //! @brief Reserves a block of the cache that is filled in afterwards with Write()
+    //! @param size             The number of bytes to reserve
+    //! @return                 The offset of the block, which is also used to read the data back
+    exrU64 Allocate(exrU64 size);
+
+    //! @brief Writes geometry data into a block returned by Allocate()
+    //!
+    //! A block may be written in several parts, and different blocks may be written concurrently.
+    //!
+    //! @param offset           The offset to write to, within an allocated block
+    //! @param data             The data to write
+    //! @param size             The number of bytes to write
+    void Write(exrU64 offset, const void* data, exrU64 size);
+
+    //! @brief Reads a block of data from the cache, paging it in if it is not resident
+    //! @param offset           The offset returned by Write()
+    //! @param size             The number of bytes to read
+    //! @param dst              Output buffer of at least size bytes
+    void Read(exrU64 offset, exrU64 size, void* dst) const;
+
+    //! @brief Logs the number of page faults, hits, and evictions so far
+    void PrintStatistics() const;
+
+private:
+    MappedFile m_File;
+    mutable LRUCache<exrU64, MappedRegion> m_ResidentPages;
+
+    //! A process-unique id, used to validate the per-thread last page lookup
+    const exrU64 m_CacheId;
+};
+
+exrEND_NAMESPACE
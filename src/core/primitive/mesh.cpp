@@ -19,6 +19,7 @@
 */
 
 #include "mesh.h"
+#include "geometrycache.h"
 #include <sstream>
 #include <fstream>
 
@@ -97,23 +98,93 @@ Mesh Mesh::LoadFromFile(const exrChar* fileName)
     return mesh;
 }
 
+Mesh Mesh::FromFaceRecords(const Vertex* faceRecords, exrU32 numFaces)
+{
+    Mesh mesh;
+    mesh.m_FaceRecords = faceRecords;
+    mesh.m_NumFaces = numFaces;
+    mesh.m_NumVertices = numFaces * 3;
+    return mesh;
+}
+
+void Mesh::PageOut(GeometryCache& cache)
+{
+    // Stream the faces out a chunk at a time, so that paging out never needs a second copy of the mesh
+    static constexpr exrU32 FacesPerChunk = 4096;
+    std::vector<Vertex> faces(exrMin(m_NumFaces, FacesPerChunk) * 3);
+
+    const exrU64 offset = cache.Allocate(exrU64(m_NumFaces) * 3 * sizeof(Vertex));
+
+    for (exrU32 first = 0; first < m_NumFaces; first += FacesPerChunk)
+    {
+        const exrU32 numFaces = exrMin(m_NumFaces - first, FacesPerChunk);
+
+        for (exrU32 i = 0; i < numFaces; ++i)
+            GetVertexAtIndex(first + i, faces[i * 3], faces[i * 3 + 1], faces[i * 3 + 2]);
+
+        cache.Write(offset + exrU64(first) * 3 * sizeof(Vertex), faces.data(), exrU64(numFaces) * 3 * sizeof(Vertex));
+    }
+
+    m_CacheOffset = offset;
+    m_GeometryCache = &cache;
+
+    // Release the in-memory copies
+    std::vector<exrU32>().swap(m_IndexBuffer);
+    std::vector<exrPoint3>().swap(m_PositionBuffer);
+    std::vector<exrVector2>().swap(m_TexCoordBuffer);
+    std::vector<exrVector3>().swap(m_NormalBuffer);
+    m_IndexReplicas.Clear();
+    m_PositionReplicas.Clear();
+    m_TexCoordReplicas.Clear();
+    m_NormalReplicas.Clear();
+}
+
 const exrBool Mesh::GetVertexAtIndex(exrU32 faceIndex, Vertex& v1, Vertex& v2, Vertex& v3) const
 {
+    if (m_GeometryCache != nullptr)
+    {
+        if (faceIndex >= m_NumFaces)
+            return false;
+
+        Vertex face[3];
+        m_GeometryCache->Read(m_CacheOffset + exrU64(faceIndex) * sizeof(face), sizeof(face), face);
+        v1 = face[0];
+        v2 = face[1];
+        v3 = face[2];
+        return true;
+    }
+
+    if (m_FaceRecords != nullptr)
+    {
+        if (faceIndex >= m_NumFaces)
+            return false;
+
+        const Vertex* faceRecords = m_FaceRecordReplicas.Get(m_FaceRecords, exrU64(m_NumFaces) * 3);
+        v1 = faceRecords[faceIndex * 3];
+        v2 = faceRecords[faceIndex * 3 + 1];
+        v3 = faceRecords[faceIndex * 3 + 2];
+        return true;
+    }
+
     if (faceIndex * 9 + 8 >= m_IndexBuffer.size())
         return false;
 
+    const exrU32* indices = m_IndexReplicas.Get(m_IndexBuffer.data(), m_IndexBuffer.size()) + faceIndex * 9;
+    const exrPoint3* positions = m_PositionReplicas.Get(m_PositionBuffer.data(), m_PositionBuffer.size());
+    const exrVector2* texCoords = m_TexCoordReplicas.Get(m_TexCoordBuffer.data(), m_TexCoordBuffer.size());
+    const exrVector3* normals = m_NormalReplicas.Get(m_NormalBuffer.data(), m_NormalBuffer.size());
 
-    v1.m_Position = m_PositionBuffer[m_IndexBuffer[faceIndex * 9]];
-    v1.m_TexCoord = m_TexCoordBuffer[m_IndexBuffer[faceIndex * 9 + 1]];
-    v1.m_Normal = m_NormalBuffer[m_IndexBuffer[faceIndex * 9 + 2]];
+    v1.m_Position = positions[indices[0]];
+    v1.m_TexCoord = texCoords[indices[1]];
+    v1.m_Normal = normals[indices[2]];
 
-    v2.m_Position = m_PositionBuffer[m_IndexBuffer[faceIndex * 9 + 3]];
-    v2.m_TexCoord = m_TexCoordBuffer[m_IndexBuffer[faceIndex * 9 + 4]];
-    v2.m_Normal = m_NormalBuffer[m_IndexBuffer[faceIndex * 9 + 5]];
+    v2.m_Position = positions[indices[3]];
+    v2.m_TexCoord = texCoords[indices[4]];
+    v2.m_Normal = normals[indices[5]];
 
-    v3.m_Position = m_PositionBuffer[m_IndexBuffer[faceIndex * 9 + 6]];
-    v3.m_TexCoord = m_TexCoordBuffer[m_IndexBuffer[faceIndex * 9 + 7]];
-    v3.m_Normal = m_NormalBuffer[m_IndexBuffer[faceIndex * 9 + 8]];
+    v3.m_Position = positions[indices[6]];
+    v3.m_TexCoord = texCoords[indices[7]];
+    v3.m_Normal = normals[indices[8]];
 
     return true;
 }
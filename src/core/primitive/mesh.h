@@ -21,9 +21,12 @@
 #pragma once
 
 #include "primitive.h"
+#include "system/memory/numareplicatedarray.h"
 
 exrBEGIN_NAMESPACE
 
+class GeometryCache;
+
 struct Vertex
 {
     exrPoint3 m_Position;
@@ -39,16 +42,47 @@ class Mesh
 public:
     static Mesh LoadFromFile(const exrChar* fileName);
 
+    //! @brief Creates a mesh that reads its faces from existing face records
+    //!
+    //! The records are three vertices per face, in the layout written by PageOut(). They
+    //! are not copied and must outlive the mesh, which allows a mesh to live in mapped memory.
+    //!
+    //! @param faceRecords      Three vertices per face
+    //! @param numFaces         The number of faces
+    static Mesh FromFaceRecords(const Vertex* faceRecords, exrU32 numFaces);
+
+    //! @brief Moves the vertex data of the mesh out of core and into a geometry cache
+    //!
+    //! The faces are flattened into self contained records of three vertices so that a
+    //! single cache read is enough to fetch a triangle. The in-memory buffers are freed.
+    //!
+    //! @param cache            The geometry cache that will page the data back in
+    void PageOut(GeometryCache& cache);
+
     const exrBool GetVertexAtIndex(exrU32 faceIndex, Vertex& v1, Vertex& v2, Vertex& v3) const;
 
     exrU32 m_NumVertices = 0;
     exrU32 m_NumFaces = 0;
 
 private:
+    //! The cache that holds the face records when the mesh is paged out, or null
+    const GeometryCache* m_GeometryCache = nullptr;
+    exrU64 m_CacheOffset = 0;
+
+    //! Externally owned face records, or null
+    const Vertex* m_FaceRecords = nullptr;
+
     std::vector<exrU32> m_IndexBuffer;
     std::vector<exrPoint3> m_PositionBuffer;
     std::vector<exrVector2> m_TexCoordBuffer;
     std::vector<exrVector3> m_NormalBuffer;
+
+    //! Copies of the buffers for threads on other NUMA nodes
+    NumaReplicatedArray<Vertex> m_FaceRecordReplicas;
+    NumaReplicatedArray<exrU32> m_IndexReplicas;
+    NumaReplicatedArray<exrPoint3> m_PositionReplicas;
+    NumaReplicatedArray<exrVector2> m_TexCoordReplicas;
+    NumaReplicatedArray<exrVector3> m_NormalReplicas;
 };
 
 exrEND_NAMESPACE
\ No newline at end of file
@@ -37,6 +37,7 @@ exrBool Primitive::Intersect(const Ray& ray, SurfaceInteraction* interaction) co
 
     ray.m_TMax = tHit;
     interaction->m_Primitive = this;
+    interaction->m_Material = m_Material;
 
     return true;
 }
@@ -52,6 +53,29 @@ exrBool Primitive::HasIntersect(const Ray& r) const
     return m_Shape->HasIntersect(r, temp);
 }
 
+exrU32 Primitive::Intersect(RayPacket& packet, exrU32 laneMask, SurfaceInteraction* interactions) const
+{
+    exrFloat tHit[RayPacketSize];
+    const exrU32 hitMask = m_Shape->Intersect(packet, laneMask, tHit, interactions);
+
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+    {
+        if ((hitMask & (1u << lane)) == 0)
+            continue;
+
+        packet.m_TMax[lane] = tHit[lane];
+        interactions[lane].m_Primitive = this;
+        interactions[lane].m_Material = m_Material;
+    }
+
+    return hitMask;
+}
+
+exrU32 Primitive::HasIntersect(const RayPacket& packet, exrU32 laneMask) const
+{
+    return m_Shape->HasIntersect(packet, laneMask);
+}
+
 void Primitive::SetShape(std::unique_ptr<Shape> shape)
 {
     m_Shape = std::move(shape);
@@ -65,6 +65,22 @@ public:
     //! @return                 True if the there is an intersection
     exrBool HasIntersect(const Ray& r) const;
 
+    //! @brief Test the geometry for intersections with the rays of a packet
+    //!
+    //! Outputs the surface intersection data of every ray that hits the geometry within its
+    //! tmax into its lane of <interactions>, and reduces the tmax of those rays to the hit.
+    //!
+    //! @param packet           The rays to test against
+    //! @param laneMask         The rays of the packet to test
+    //! @param interactions     The output surface interaction structs, one per lane
+    //!
+    //! @return                 The lane mask of the rays that intersect
+    exrU32 Intersect(RayPacket& packet, exrU32 laneMask, SurfaceInteraction* interactions) const;
+
+    //! @brief Test the geometry for intersections with the rays of a packet, ignoring surface data
+    //! @return                 The lane mask of the rays that intersect
+    exrU32 HasIntersect(const RayPacket& packet, exrU32 laneMask) const;
+
     //! @brief Sets the shape of the primitive
     //! 
     //! Assign a shape to the primitive. A reference to the primitive is also set in
@@ -107,6 +123,9 @@ public:
 
     //! Returns the material of the current primitive
     const Material* GetMaterial() const;
+
+    //! Returns the shape of the current primitive
+    const Shape* GetShape() const { return m_Shape.get(); }
     
 protected:
     //! The underlying shape that describes the primitive
@@ -0,0 +1,152 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "displacedpatch.h"
+#include "core/primitive/tessellationcache.h"
+
+exrBEGIN_NAMESPACE
+
+// Möller-Trumbore ray triangle intersection, see triangle.cpp
+static exrBool IntersectMicroTriangle(const Ray& ray, const exrPoint3& p0, const exrPoint3& p1, const exrPoint3& p2,
+    exrFloat& t, exrFloat& u, exrFloat& v)
+{
+    const exrVector3 e1 = p1 - p0;
+    const exrVector3 e2 = p2 - p0;
+    const exrVector3 p = Cross(ray.m_Direction, e2);
+    const exrFloat det = Dot(e1, p);
+
+    if (abs(det) < EXR_EPSILON * EXR_EPSILON)
+        return false;
+
+    const exrFloat invDet = 1 / det;
+    const exrVector3 s = ray.m_Origin - p0;
+
+    u = Dot(s, p) * invDet;
+    if (u < 0 || u > 1)
+        return false;
+
+    const exrVector3 q = Cross(s, e1);
+    v = Dot(ray.m_Direction, q) * invDet;
+    if (v < 0 || u + v > 1)
+        return false;
+
+    t = Dot(e2, q) * invDet;
+    return t > 0 && t <= ray.m_TMax;
+}
+
+exrBool DisplacedPatch::IntersectPatch(const Ray& ray, exrBool anyHit, exrFloat& tHit, exrVector3* normal, exrPoint2* uv) const
+{
+    struct StackEntry
+    {
+        exrU32 m_Node;
+        exrU32 m_Depth;
+        TessellatedPatch::GridCoord m_Corners[3];
+    };
+
+    // Held by reference for the whole traversal, so that no reference count is touched per ray
+    const TessellatedPatch& patch = m_Surface->GetPatch(m_IndexInSurface);
+    const exrS32 n = 1 << patch.m_Level;
+
+    // Shrink a copy of the ray as hits are found, so that farther nodes are culled
+    Ray localRay(ray);
+    exrBool hasHit = false;
+
+    // Every level pushes four children and pops one of them
+    StackEntry stack[3 * DisplacementSettings::MaxLevel + 1];
+    exrU32 stackSize = 0;
+    stack[stackSize++] = { 0, 0, { { 0, 0 }, { n, 0 }, { 0, n } } };
+
+    while (stackSize > 0)
+    {
+        const StackEntry entry = stack[--stackSize];
+        if (!patch.m_Nodes[entry.m_Node].Intersect(localRay))
+            continue;
+
+        if (entry.m_Depth < patch.m_Level)
+        {
+            TessellatedPatch::GridCoord children[12];
+            TessellatedPatch::Subdivide(entry.m_Corners, children);
+
+            for (exrU32 i = 0; i < 4; ++i)
+            {
+                StackEntry& child = stack[stackSize++];
+                child.m_Node = entry.m_Node * 4 + 1 + i;
+                child.m_Depth = entry.m_Depth + 1;
+                std::copy(children + i * 3, children + i * 3 + 3, child.m_Corners);
+            }
+
+            continue;
+        }
+
+        const exrU32 i0 = patch.GetVertexIndex(entry.m_Corners[0]);
+        const exrU32 i1 = patch.GetVertexIndex(entry.m_Corners[1]);
+        const exrU32 i2 = patch.GetVertexIndex(entry.m_Corners[2]);
+
+        exrFloat t, u, v;
+        if (!IntersectMicroTriangle(localRay, patch.m_Positions[i0], patch.m_Positions[i1], patch.m_Positions[i2], t, u, v))
+            continue;
+
+        hasHit = true;
+        tHit = t;
+        localRay.m_TMax = t;
+
+        if (anyHit)
+            return true;
+
+        *normal = (1 - u - v) * patch.m_Normals[i0] + u * patch.m_Normals[i1] + v * patch.m_Normals[i2];
+
+        // Grid coordinates of the hit, which are the barycentric coordinates on the base face times n
+        const TessellatedPatch::GridCoord* c = entry.m_Corners;
+        const exrFloat b1 = ((1 - u - v) * c[0].i + u * c[1].i + v * c[2].i) / n;
+        const exrFloat b2 = ((1 - u - v) * c[0].j + u * c[1].j + v * c[2].j) / n;
+        const exrVector2 texCoord = (1 - b1 - b2) * patch.m_TexCoords[0] + b1 * patch.m_TexCoords[1] + b2 * patch.m_TexCoords[2];
+        *uv = exrPoint2(texCoord.x, texCoord.y);
+    }
+
+    return hasHit;
+}
+
+exrBool DisplacedPatch::Intersect(const Ray& ray, exrFloat& tHit, SurfaceInteraction* interaction) const
+{
+    exrVector3 normal;
+    exrPoint2 uv;
+    if (!IntersectPatch(ray, false, tHit, &normal, &uv))
+        return false;
+
+    interaction->m_Point = ray(tHit);
+    interaction->m_Normal = normal.Normalized();
+    interaction->m_Wo = -ray.m_Direction;
+    interaction->m_Shape = this;
+    interaction->m_UV = uv;
+
+    return true;
+}
+
+exrBool DisplacedPatch::HasIntersect(const Ray& ray, exrFloat& tHit) const
+{
+    return IntersectPatch(ray, true, tHit, nullptr, nullptr);
+}
+
+AABB DisplacedPatch::ComputeBoundingVolume() const
+{
+    return m_Surface->ComputePatchBounds(m_IndexInSurface);
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,56 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "shape.h"
+#include "core/primitive/displacedsurface.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A single face of a displaced surface
+//!
+//! The patch is only tessellated once a ray reaches its conservative bounds. The micro
+//! triangles are then intersected through the bounding volume tree of the tessellated patch.
+class DisplacedPatch : public Shape
+{
+public:
+    DisplacedPatch(const std::shared_ptr<DisplacedSurface>& surface, exrU32 index)
+        : m_Surface(surface)
+        , m_IndexInSurface(index) {};
+
+    exrBool Intersect(const Ray& ray, exrFloat& tHit, SurfaceInteraction* interaction) const override;
+    exrBool HasIntersect(const Ray& ray, exrFloat& tHit) const override;
+
+protected:
+    AABB ComputeBoundingVolume() const override;
+
+private:
+    //! @brief Finds the closest micro triangle hit, or any hit if anyHit is set
+    //! @param normal           Output shading normal of the closest hit, unused if anyHit is set
+    //! @param uv               Output texture coordinates of the closest hit, unused if anyHit is set
+    exrBool IntersectPatch(const Ray& ray, exrBool anyHit, exrFloat& tHit, exrVector3* normal, exrPoint2* uv) const;
+
+private:
+    std::shared_ptr<DisplacedSurface> m_Surface;
+    exrU32 m_IndexInSurface;
+};
+
+exrEND_NAMESPACE
@@ -73,4 +73,28 @@ AABB Quad::ComputeBoundingVolume() const
     return AABB(realMin, realMax);
 }
 
+exrFloat Quad::Area() const
+{
+    const Matrix4x4& objectToWorld = m_Primitive->GetObjectToWorldMatrix();
+    const exrFloat scale = (objectToWorld * exrVector3(1, 0, 0)).Magnitude();
+    return 4 * m_HalfExtents.x * m_HalfExtents.y * scale * scale;
+}
+
+Interaction Quad::Sample(const exrPoint2& u, exrFloat& pdf) const
+{
+    const exrPoint3 localPoint(exrLerp(-m_HalfExtents.x, m_HalfExtents.x, u.x), exrLerp(-m_HalfExtents.y, m_HalfExtents.y, u.y), 0.0f);
+
+    Interaction it;
+    it.m_Point = m_Primitive->GetObjectToWorldMatrix() * localPoint;
+    it.m_Normal = (m_Primitive->GetObjectToWorldMatrix() * exrVector3::Forward()).Normalized();
+    pdf = 1.0f / Area();
+    return it;
+}
+
+void Quad::GetNormalBounds(exrVector3& axis, exrFloat& cosTheta) const
+{
+    axis = (m_Primitive->GetObjectToWorldMatrix() * exrVector3::Forward()).Normalized();
+    cosTheta = 1.0f;
+}
+
 exrEND_NAMESPACE
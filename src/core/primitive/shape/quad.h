@@ -38,6 +38,10 @@ public:
 
     AABB ComputeBoundingVolume() const override;
 
+    exrFloat Area() const override;
+    Interaction Sample(const exrPoint2& u, exrFloat& pdf) const override;
+    void GetNormalBounds(exrVector3& axis, exrFloat& cosTheta) const override;
+
 public:
     exrPoint3 m_HalfExtents;
 };
@@ -22,4 +22,62 @@
 
 exrBEGIN_NAMESPACE
 
+exrU32 Shape::Intersect(const RayPacket& packet, exrU32 laneMask, exrFloat* tHit, SurfaceInteraction* interactions) const
+{
+    exrU32 hitMask = 0;
+
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+    {
+        if ((laneMask & (1u << lane)) != 0 && Intersect(packet.GetRay(lane), tHit[lane], &interactions[lane]))
+            hitMask |= 1u << lane;
+    }
+
+    return hitMask;
+}
+
+exrU32 Shape::HasIntersect(const RayPacket& packet, exrU32 laneMask) const
+{
+    exrU32 hitMask = 0;
+    exrFloat tHit;
+
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+    {
+        if ((laneMask & (1u << lane)) != 0 && HasIntersect(packet.GetRay(lane), tHit))
+            hitMask |= 1u << lane;
+    }
+
+    return hitMask;
+}
+
+Interaction Shape::Sample(const Interaction& ref, const exrPoint2& u, exrFloat& pdf) const
+{
+    Interaction it = Sample(u, pdf);
+    pdf = AreaToSolidAnglePdf(pdf, ref.m_Point, it.m_Point, it.m_Normal);
+    return it;
+}
+
+exrFloat Shape::Pdf(const Interaction& ref, const exrVector3& wi) const
+{
+    Ray ray = ref.SpawnRay(wi);
+    exrFloat tHit;
+    SurfaceInteraction isect;
+
+    if (!Intersect(ray, tHit, &isect))
+        return 0.0f;
+
+    return AreaToSolidAnglePdf(1.0f / Area(), ref.m_Point, isect.m_Point, isect.m_Normal.Normalized());
+}
+
+exrFloat Shape::AreaToSolidAnglePdf(exrFloat pdf, const exrPoint3& ref, const exrPoint3& point, const exrVector3& normal)
+{
+    const exrVector3 wi = point - ref;
+    const exrFloat distanceSquared = wi.MagnitudeSquared();
+    const exrFloat cosTheta = AbsDot(normal, wi.Normalized());
+
+    if (distanceSquared == 0.0f || cosTheta == 0.0f)
+        return 0.0f;
+
+    return pdf * distanceSquared / cosTheta;
+}
+
 exrEND_NAMESPACE
\ No newline at end of file
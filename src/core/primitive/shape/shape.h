@@ -60,10 +60,60 @@ public:
     //! @return                 True if the there is an intersection
     virtual exrBool HasIntersect(const Ray& ray, exrFloat& tHit) const = 0;
 
+    //! @brief Test the geometry for intersections with the rays of a packet
+    //!
+    //! Outputs the t value and the interaction info of every ray that hits the geometry within
+    //! its tmax. The default tests the rays one at a time.
+    //!
+    //! @param packet           The rays to test against
+    //! @param laneMask         The rays of the packet to test
+    //! @param tHit             The t values of the rays at their points of intersection, if any
+    //! @param interactions     Output structs that contain the interaction information, one per lane
+    //!
+    //! @return                 The lane mask of the rays that intersect
+    virtual exrU32 Intersect(const RayPacket& packet, exrU32 laneMask, exrFloat* tHit, SurfaceInteraction* interactions) const;
+
+    //! @brief Test the geometry for intersections with the rays of a packet, without interaction info
+    //! @return                 The lane mask of the rays that intersect
+    virtual exrU32 HasIntersect(const RayPacket& packet, exrU32 laneMask) const;
+
 public:
     //! Computes a bounding volume that encapsulates the current geometry.
     virtual AABB ComputeBoundingVolume() const = 0;
 
+public:
+    // Shapes are sampled for area lights. Points, normals and directions are all in the space that
+    // the shape is intersected in, which is the object space of instanced groups.
+
+    //! @brief Returns the surface area of the shape
+    //!
+    //! Shapes that return 0 cannot be sampled, and therefore cannot emit light.
+    virtual exrFloat Area() const { return 0.0f; }
+
+    //! @brief Samples a point uniformly by area on the surface of the shape
+    //! @param u                A uniform 2D sample
+    //! @param pdf              Outputs the pdf of the point with respect to area
+    //! @return                 The point and the surface normal at it
+    virtual Interaction Sample(const exrPoint2& u, exrFloat& pdf) const { pdf = 0.0f; return Interaction(); }
+
+    //! @brief Samples a point on the shape as seen from a reference point
+    //!
+    //! The default converts a sample by area to solid angle. Shapes can do better by only
+    //! sampling the directions that they subtend from the reference point.
+    //!
+    //! @param pdf              Outputs the pdf of the point with respect to solid angle at ref
+    virtual Interaction Sample(const Interaction& ref, const exrPoint2& u, exrFloat& pdf) const;
+
+    //! @brief Returns the pdf with respect to solid angle that Sample(ref, u, pdf) samples wi with
+    virtual exrFloat Pdf(const Interaction& ref, const exrVector3& wi) const;
+
+    //! @brief Outputs a cone that contains every surface normal of the shape
+    virtual void GetNormalBounds(exrVector3& axis, exrFloat& cosTheta) const { axis = exrVector3::Up(); cosTheta = -1.0f; }
+
+protected:
+    //! @brief Converts a pdf with respect to area to one with respect to solid angle at a reference point
+    static exrFloat AreaToSolidAnglePdf(exrFloat pdf, const exrPoint3& ref, const exrPoint3& point, const exrVector3& normal);
+
 protected:
     friend class Primitive;
 
@@ -73,5 +73,72 @@ AABB Sphere::ComputeBoundingVolume() const
     return AABB(min, max);
 }
 
+exrFloat Sphere::Area() const
+{
+    const exrFloat radius = GetTransformedRadius();
+    return 4 * EXR_M_PI * radius * radius;
+}
+
+Interaction Sphere::Sample(const exrPoint2& u, exrFloat& pdf) const
+{
+    Interaction it;
+    it.m_Normal = UniformSampleSphere(u);
+    it.m_Point = m_Primitive->GetPosition() + it.m_Normal * GetTransformedRadius();
+    pdf = 1.0f / Area();
+    return it;
+}
+
+Interaction Sphere::Sample(const Interaction& ref, const exrPoint2& u, exrFloat& pdf) const
+{
+    const exrPoint3 center = m_Primitive->GetPosition();
+    const exrFloat radius = GetTransformedRadius();
+    const exrFloat distanceSquared = DistanceSquared(ref.m_Point, center);
+
+    // Points inside the sphere see all of it
+    if (distanceSquared <= radius * radius)
+        return Shape::Sample(ref, u, pdf);
+
+    // Sample a direction in the cone that the sphere subtends
+    const exrFloat sinThetaMax2 = radius * radius / distanceSquared;
+    const exrFloat cosThetaMax = exrSafeSqrt(1.0f - sinThetaMax2);
+    const exrFloat cosTheta = (1.0f - u.x) + u.x * cosThetaMax;
+    const exrFloat sinTheta2 = exrMax(0.0f, 1.0f - cosTheta * cosTheta);
+    const exrFloat phi = u.y * 2 * EXR_M_PI;
+
+    // Find the point on the sphere that the direction hits first, as an angle from the center
+    const exrFloat distance = sqrt(distanceSquared);
+    const exrFloat ds = distance * cosTheta - exrSafeSqrt(radius * radius - distanceSquared * sinTheta2);
+    const exrFloat cosAlpha = exrClamp((distanceSquared + radius * radius - ds * ds) / (2 * distance * radius), -1.0f, 1.0f);
+    const exrFloat sinAlpha = exrSafeSqrt(1.0f - cosAlpha * cosAlpha);
+
+    const exrVector3 wc = (center - ref.m_Point) / distance;
+    exrVector3 wcX, wcY;
+    CoordinateSystem(wc, &wcX, &wcY);
+
+    Interaction it;
+    it.m_Normal = -(wcX * (sinAlpha * cos(phi)) + wcY * (sinAlpha * sin(phi)) + wc * cosAlpha);
+    it.m_Point = center + it.m_Normal * radius;
+    pdf = UniformConePdf(cosThetaMax);
+    return it;
+}
+
+exrFloat Sphere::Pdf(const Interaction& ref, const exrVector3& wi) const
+{
+    const exrPoint3 center = m_Primitive->GetPosition();
+    const exrFloat radius = GetTransformedRadius();
+    const exrFloat distanceSquared = DistanceSquared(ref.m_Point, center);
+
+    if (distanceSquared <= radius * radius)
+        return Shape::Pdf(ref, wi);
+
+    const exrFloat cosThetaMax = exrSafeSqrt(1.0f - radius * radius / distanceSquared);
+    return UniformConePdf(cosThetaMax);
+}
+
+exrFloat Sphere::GetTransformedRadius() const
+{
+    return m_Radius * (m_Primitive->GetObjectToWorldMatrix() * exrVector3(1, 0, 0)).Magnitude();
+}
+
 exrEND_NAMESPACE
 
@@ -39,9 +39,20 @@ public:
     exrBool Intersect(const Ray& ray, exrFloat& tHit, SurfaceInteraction* interaction) const override;
     exrBool HasIntersect(const Ray& ray, exrFloat& tHit) const override;
 
+    exrFloat Area() const override;
+    Interaction Sample(const exrPoint2& u, exrFloat& pdf) const override;
+
+    //! @brief Samples the cone of directions that the sphere subtends from the reference point
+    Interaction Sample(const Interaction& ref, const exrPoint2& u, exrFloat& pdf) const override;
+    exrFloat Pdf(const Interaction& ref, const exrVector3& wi) const override;
+
 protected:
     AABB ComputeBoundingVolume() const override;
 
+private:
+    //! @brief Returns the radius of the sphere after the transform of its primitive
+    exrFloat GetTransformedRadius() const;
+
 private:
     //! The radius of the sphere
     exrFloat m_Radius;
@@ -76,6 +76,9 @@ exrBool Triangle::Intersect(const Ray& ray, exrFloat& tHit, SurfaceInteraction*
     interaction->m_Wo = -ray.m_Direction;
     interaction->m_Shape = this;
 
+    const exrVector2 texCoord = (1 - u - v) * v0.m_TexCoord + u * v1.m_TexCoord + v * v2.m_TexCoord;
+    interaction->m_UV = exrPoint2(texCoord.x, texCoord.y);
+
     return true;
 }
 
@@ -124,6 +127,100 @@ exrBool Triangle::HasIntersect(const Ray& ray, exrFloat& tHit) const
     return true;
 }
 
+// The same test as Intersect() for every ray of a packet, with the early outs turned into a lane mask
+static exrU32 IntersectPacket(const RayPacket& packet, exrU32 laneMask, const Vertex& v0, const Vertex& v1, const Vertex& v2,
+    exrFloat* tHit, exrFloat* b1, exrFloat* b2)
+{
+    const exrVector3 e1 = v1.m_Position - v0.m_Position;
+    const exrVector3 e2 = v2.m_Position - v0.m_Position;
+    exrU32 isHit[RayPacketSize];
+
+    exrPacketLoop
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+    {
+        const exrFloat dx = packet.m_Direction[0][lane];
+        const exrFloat dy = packet.m_Direction[1][lane];
+        const exrFloat dz = packet.m_Direction[2][lane];
+
+        // p = Cross(direction, e2)
+        const exrFloat px = dy * e2.z - dz * e2.y;
+        const exrFloat py = -(dx * e2.z - dz * e2.x);
+        const exrFloat pz = dx * e2.y - dy * e2.x;
+        const exrFloat det = e1.x * px + e1.y * py + e1.z * pz;
+        const exrFloat invDet = 1 / det;
+
+        // Calculate distance from v0 to ray origin
+        const exrFloat tx = packet.m_Origin[0][lane] - v0.m_Position.x;
+        const exrFloat ty = packet.m_Origin[1][lane] - v0.m_Position.y;
+        const exrFloat tz = packet.m_Origin[2][lane] - v0.m_Position.z;
+        const exrFloat u = (tx * px + ty * py + tz * pz) * invDet;
+
+        // q = Cross(t, e1)
+        const exrFloat qx = ty * e1.z - tz * e1.y;
+        const exrFloat qy = -(tx * e1.z - tz * e1.x);
+        const exrFloat qz = tx * e1.y - ty * e1.x;
+        const exrFloat v = (dx * qx + dy * qy + dz * qz) * invDet;
+        const exrFloat t = (e2.x * qx + e2.y * qy + e2.z * qz) * invDet;
+
+        isHit[lane] = exrU32(!(abs(det) < EXR_EPSILON) & !((u < 0) | (u > 1)) &
+            !((v < 0) | (u + v > 1)) & !((t < 0) | (t > packet.m_TMax[lane])));
+
+        tHit[lane] = t;
+        b1[lane] = u;
+        b2[lane] = v;
+    }
+
+    // Packed separately, so that the loop above vectorizes
+    exrU32 hitMask = 0;
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+        hitMask |= isHit[lane] << lane;
+
+    return hitMask & laneMask;
+}
+
+exrU32 Triangle::Intersect(const RayPacket& packet, exrU32 laneMask, exrFloat* tHit, SurfaceInteraction* interactions) const
+{
+    // The vertices are fetched once for all rays, which matters most for out-of-core meshes
+    Vertex v0, v1, v2;
+    m_SharedMesh->GetVertexAtIndex(m_IndexInMesh, v0, v1, v2);
+
+    exrFloat u[RayPacketSize], v[RayPacketSize];
+    const exrU32 hitMask = IntersectPacket(packet, laneMask, v0, v1, v2, tHit, u, v);
+
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+    {
+        if ((hitMask & (1u << lane)) == 0)
+            continue;
+
+        // Compute normal vector
+        exrVector3 normal =
+            (1 - u[lane] - v[lane]) * v0.m_Normal +
+            u[lane] * v1.m_Normal +
+            v[lane] * v2.m_Normal;
+
+        const Ray ray = packet.GetRay(lane);
+        SurfaceInteraction* interaction = &interactions[lane];
+        interaction->m_Point = ray(tHit[lane]);
+        interaction->m_Normal = normal.Normalized();
+        interaction->m_Wo = -ray.m_Direction;
+        interaction->m_Shape = this;
+
+        const exrVector2 texCoord = (1 - u[lane] - v[lane]) * v0.m_TexCoord + u[lane] * v1.m_TexCoord + v[lane] * v2.m_TexCoord;
+        interaction->m_UV = exrPoint2(texCoord.x, texCoord.y);
+    }
+
+    return hitMask;
+}
+
+exrU32 Triangle::HasIntersect(const RayPacket& packet, exrU32 laneMask) const
+{
+    Vertex v0, v1, v2;
+    m_SharedMesh->GetVertexAtIndex(m_IndexInMesh, v0, v1, v2);
+
+    exrFloat tHit[RayPacketSize], u[RayPacketSize], v[RayPacketSize];
+    return IntersectPacket(packet, laneMask, v0, v1, v2, tHit, u, v);
+}
+
 AABB Triangle::ComputeBoundingVolume() const
 {
     Vertex v0, v1, v2;
@@ -140,5 +237,56 @@ AABB Triangle::ComputeBoundingVolume() const
     return AABB(exrPoint3(xMin, yMin, zMin), exrPoint3(xMax, yMax, zMax));
 }
 
+exrFloat Triangle::Area() const
+{
+    Vertex v0, v1, v2;
+    m_SharedMesh->GetVertexAtIndex(m_IndexInMesh, v0, v1, v2);
+    return 0.5f * Cross(v1.m_Position - v0.m_Position, v2.m_Position - v0.m_Position).Magnitude();
+}
+
+Interaction Triangle::Sample(const exrPoint2& u, exrFloat& pdf) const
+{
+    Vertex v0, v1, v2;
+    m_SharedMesh->GetVertexAtIndex(m_IndexInMesh, v0, v1, v2);
+
+    const exrPoint2 b = UniformSampleTriangle(u);
+    const exrFloat b2 = 1.0f - b.x - b.y;
+
+    Interaction it;
+    it.m_Point = v0.m_Position + (v1.m_Position - v0.m_Position) * b.y + (v2.m_Position - v0.m_Position) * b2;
+    it.m_Normal = GetGeometricNormal(v0, v1, v2);
+    pdf = 2.0f / Cross(v1.m_Position - v0.m_Position, v2.m_Position - v0.m_Position).Magnitude();
+    return it;
+}
+
+exrFloat Triangle::Pdf(const Interaction& ref, const exrVector3& wi) const
+{
+    // Uses the geometric normal rather than the interpolated normal that Intersect() outputs
+    Ray ray = ref.SpawnRay(wi);
+    exrFloat tHit;
+
+    if (!HasIntersect(ray, tHit))
+        return 0.0f;
+
+    Vertex v0, v1, v2;
+    m_SharedMesh->GetVertexAtIndex(m_IndexInMesh, v0, v1, v2);
+    return AreaToSolidAnglePdf(1.0f / Area(), ref.m_Point, ray(tHit), GetGeometricNormal(v0, v1, v2));
+}
+
+void Triangle::GetNormalBounds(exrVector3& axis, exrFloat& cosTheta) const
+{
+    Vertex v0, v1, v2;
+    m_SharedMesh->GetVertexAtIndex(m_IndexInMesh, v0, v1, v2);
+    axis = GetGeometricNormal(v0, v1, v2);
+    cosTheta = 1.0f;
+}
+
+exrVector3 Triangle::GetGeometricNormal(const Vertex& v0, const Vertex& v1, const Vertex& v2) const
+{
+    const exrVector3 normal = Cross(v1.m_Position - v0.m_Position, v2.m_Position - v0.m_Position).Normalized();
+    const exrVector3 vertexNormal = v0.m_Normal + v1.m_Normal + v2.m_Normal;
+    return Dot(normal, vertexNormal) < 0.0f ? -normal : normal;
+}
+
 exrEND_NAMESPACE
 
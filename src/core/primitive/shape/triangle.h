@@ -34,10 +34,21 @@ public:
 
     exrBool Intersect(const Ray& ray, exrFloat& tHit, SurfaceInteraction* interaction) const override;
     exrBool HasIntersect(const Ray& ray, exrFloat& tHit) const override;
+    exrU32 Intersect(const RayPacket& packet, exrU32 laneMask, exrFloat* tHit, SurfaceInteraction* interactions) const override;
+    exrU32 HasIntersect(const RayPacket& packet, exrU32 laneMask) const override;
+
+    exrFloat Area() const override;
+    Interaction Sample(const exrPoint2& u, exrFloat& pdf) const override;
+    exrFloat Pdf(const Interaction& ref, const exrVector3& wi) const override;
+    void GetNormalBounds(exrVector3& axis, exrFloat& cosTheta) const override;
 
 protected:
     AABB ComputeBoundingVolume() const override;
 
+private:
+    //! @brief Returns the normal of the plane of the triangle, on the side of its vertex normals
+    exrVector3 GetGeometricNormal(const Vertex& v0, const Vertex& v1, const Vertex& v2) const;
+
 private:
     std::shared_ptr<Mesh> m_SharedMesh;
     exrU32 m_IndexInMesh;
@@ -0,0 +1,79 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tessellationcache.h"
+#include "displacedsurface.h"
+
+exrBEGIN_NAMESPACE
+
+// Rays that hit a patch tend to be followed by more rays hitting the same patch, so each
+// thread remembers the last patch it used and only goes through the (locked) LRU when it
+// moves to another one.
+struct LastPatchCache
+{
+    exrU64 m_Key = ~exrU64(0);
+    std::shared_ptr<TessellatedPatch> m_Patch;
+};
+
+static thread_local LastPatchCache t_LastPatch;
+
+exrU64 TessellatedPatch::GetMemoryUsage() const
+{
+    return sizeof(TessellatedPatch) +
+        m_Positions.capacity() * sizeof(exrPoint3) +
+        m_Normals.capacity() * sizeof(exrVector3) +
+        m_Nodes.capacity() * sizeof(AABB);
+}
+
+TessellationCache::TessellationCache(exrU64 residencyBudget)
+    : m_ResidentPatches(residencyBudget)
+{
+}
+
+const TessellatedPatch& TessellationCache::GetPatch(const DisplacedSurface& surface, exrU32 patchIndex) const
+{
+    // Surface ids are unique for the lifetime of the process, so keys are never reused
+    const exrU64 key = (exrU64(surface.GetId()) << 32) | patchIndex;
+
+    if (t_LastPatch.m_Key != key)
+    {
+        t_LastPatch.m_Patch = m_ResidentPatches.GetOrLoad(key, [&](exrU64& cost)
+        {
+            std::shared_ptr<TessellatedPatch> patch = surface.Tessellate(patchIndex);
+            cost = patch->GetMemoryUsage();
+            return patch;
+        });
+
+        t_LastPatch.m_Key = key;
+    }
+
+    return *t_LastPatch.m_Patch;
+}
+
+void TessellationCache::PrintStatistics() const
+{
+    LRUCache<exrU64, TessellatedPatch>::Statistics stats = m_ResidentPatches.GetStatistics();
+
+    exrInfoLine("Tessellation cache: " << stats.m_Misses << " patches tessellated, "
+        << stats.m_PeakResidentCost / (1024.0 * 1024.0) << " MB peak resident");
+    exrInfoLine("\t   " << stats.m_Hits << " hits, " << stats.m_Evictions << " evictions");
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,110 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/elixir.h"
+#include "core/spatial/utils/aabb.h"
+#include "system/memory/lrucache.h"
+
+exrBEGIN_NAMESPACE
+
+class DisplacedSurface;
+
+//! @brief The dense geometry of a single patch of a displaced surface
+//!
+//! A patch is tessellated into a regular triangular grid of (N + 1) * (N + 2) / 2 vertices,
+//! where N = 2^level is the number of segments along each edge. m_Nodes holds the bounds of
+//! a complete 4-ary tree over the micro triangles, in which node k has children 4k + 1 to
+//! 4k + 4 and every leaf is a single micro triangle.
+struct TessellatedPatch
+{
+    //! A vertex of the grid, at barycentric coordinates (i / N, j / N) of the base face
+    struct GridCoord
+    {
+        exrS32 i;
+        exrS32 j;
+    };
+
+    //! @brief Returns the index of a grid vertex in m_Positions and m_Normals
+    inline exrU32 GetVertexIndex(const GridCoord& coord) const
+    {
+        const exrS32 n = 1 << m_Level;
+        return exrU32(coord.i * (n + 1) - coord.i * (coord.i - 1) / 2 + coord.j);
+    }
+
+    //! @brief Splits a triangle of the grid into the four triangles of its child nodes
+    //! @param corners          The three corners of the triangle
+    //! @param children         Output corners of the four children, three per child
+    static inline void Subdivide(const GridCoord* corners, GridCoord* children)
+    {
+        const GridCoord& a = corners[0];
+        const GridCoord& b = corners[1];
+        const GridCoord& c = corners[2];
+        const GridCoord ab = { (a.i + b.i) / 2, (a.j + b.j) / 2 };
+        const GridCoord bc = { (b.i + c.i) / 2, (b.j + c.j) / 2 };
+        const GridCoord ca = { (c.i + a.i) / 2, (c.j + a.j) / 2 };
+
+        const GridCoord result[12] = { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca };
+        std::copy(result, result + 12, children);
+    }
+
+    exrU32 m_Level;
+
+    //! The texture coordinates of the three corners of the base face
+    exrVector2 m_TexCoords[3];
+
+    std::vector<exrPoint3> m_Positions;
+    std::vector<exrVector3> m_Normals;
+    std::vector<AABB> m_Nodes;
+
+    //! @brief Returns the number of bytes the patch occupies in memory
+    exrU64 GetMemoryUsage() const;
+};
+
+//! @brief A bounded store of tessellated patches, shared by all displaced surfaces of a job
+//!
+//! Patches are tessellated the first time a ray reaches them and stay resident until the
+//! least recently used ones are evicted to make room for others. Evicted patches are simply
+//! tessellated again if they are needed later.
+class TessellationCache
+{
+public:
+    //! @brief Creates an empty tessellation cache
+    //! @param residencyBudget  The maximum number of bytes of tessellated geometry to keep
+    TessellationCache(exrU64 residencyBudget);
+
+    //! @brief Returns a tessellated patch, tessellating it if it is not resident
+    //!
+    //! Each thread keeps its last patch pinned, so the reference stays valid until the same
+    //! thread asks for another patch. It is meant to be used for the duration of one query.
+    //!
+    //! @param surface          The surface that the patch belongs to
+    //! @param patchIndex       The index of the patch within the surface
+    const TessellatedPatch& GetPatch(const DisplacedSurface& surface, exrU32 patchIndex) const;
+
+    //! @brief Logs the number of patches tessellated, cache hits and evictions so far
+    void PrintStatistics() const;
+
+private:
+    mutable LRUCache<exrU64, TessellatedPatch> m_ResidentPatches;
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,94 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "ray.h"
+
+exrBEGIN_NAMESPACE
+
+//! The number of rays in a ray packet
+static constexpr exrU32 RayPacketSize = 8;
+
+//! A lane mask with every ray of a packet set
+static constexpr exrU32 RayPacketFullMask = (1u << RayPacketSize) - 1;
+
+//! Placed before a loop over the lanes of a packet. GCC fully unrolls loops this short before
+//! it tries to vectorize them, and then cannot vectorize the selects in their bodies.
+#if defined(__GNUC__) && !defined(__clang__)
+#define exrPacketLoop _Pragma("GCC unroll 1")
+#else
+#define exrPacketLoop
+#endif
+
+//! @brief A group of rays that are traced through the accelerator together
+//!
+//! The components of the rays are stored in separate arrays, so that loops over the lanes of
+//! a packet compile to vector instructions. Traversal visits a node once for the whole packet
+//! and fetches every primitive once, which pays off when the rays are coherent, such as the
+//! camera rays of a pixel or shadow rays towards the same light.
+//!
+//! Functions that take a packet also take a lane mask, with bit i set if ray i takes part.
+//! Unused lanes have a negative tmax, so that they never hit anything.
+struct RayPacket
+{
+    RayPacket()
+    {
+        for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+        {
+            for (exrU32 i = 0; i < 3; ++i)
+                m_Origin[i][lane] = m_Direction[i][lane] = m_InvDirection[i][lane] = 0.0f;
+
+            m_TMax[lane] = -1.0f;
+        }
+    }
+
+    //! @brief Stores a ray in a lane of the packet
+    void SetRay(exrU32 lane, const Ray& ray)
+    {
+        for (exrU32 i = 0; i < 3; ++i)
+        {
+            m_Origin[i][lane] = ray.m_Origin[i];
+            m_Direction[i][lane] = ray.m_Direction[i];
+            m_InvDirection[i][lane] = 1.0f / ray.m_Direction[i];
+        }
+
+        m_TMax[lane] = ray.m_TMax;
+    }
+
+    //! @brief Returns the ray in a lane of the packet
+    Ray GetRay(exrU32 lane) const
+    {
+        // The direction is normalized already, so the ray is not constructed from it
+        Ray ray;
+        ray.m_Origin = exrPoint3(m_Origin[0][lane], m_Origin[1][lane], m_Origin[2][lane]);
+        ray.m_Direction = exrVector3(m_Direction[0][lane], m_Direction[1][lane], m_Direction[2][lane]);
+        ray.m_TMax = m_TMax[lane];
+        return ray;
+    }
+
+    alignas(32) exrFloat m_Origin[3][RayPacketSize];
+    alignas(32) exrFloat m_Direction[3][RayPacketSize];
+    alignas(32) exrFloat m_InvDirection[3][RayPacketSize];
+    alignas(32) exrFloat m_TMax[RayPacketSize];
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,108 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "aliastable.h"
+#include "lowdiscrepancy.h"
+
+exrBEGIN_NAMESPACE
+
+AliasTable::AliasTable(const std::vector<exrFloat>& weights)
+    : m_Bins(weights.size())
+{
+    const exrU32 numBins = static_cast<exrU32>(weights.size());
+    if (numBins == 0)
+        return;
+
+    // Sum in double, since tables can have tens of thousands of entries of very different weight
+    double sum = 0.0;
+    for (exrFloat weight : weights)
+        sum += exrMax(weight, 0.0f);
+
+    for (exrU32 i = 0; i < numBins; ++i)
+        m_Bins[i].m_Pmf = sum > 0.0 ? exrFloat(exrMax(weights[i], 0.0f) / sum) : 1.0f / numBins;
+
+    // Split the bins into those that are under- and overfull relative to the average, then let
+    // every underfull bin take the rest of its space from an overfull one
+    struct Outcome
+    {
+        double m_ScaledPmf;
+        exrU32 m_Index;
+    };
+
+    std::vector<Outcome> under, over;
+    for (exrU32 i = 0; i < numBins; ++i)
+    {
+        const double scaledPmf = double(m_Bins[i].m_Pmf) * numBins;
+        if (scaledPmf < 1.0)
+            under.push_back({ scaledPmf, i });
+        else
+            over.push_back({ scaledPmf, i });
+    }
+
+    while (!under.empty() && !over.empty())
+    {
+        Outcome small = under.back();
+        Outcome& large = over.back();
+        under.pop_back();
+
+        m_Bins[small.m_Index].m_Threshold = exrFloat(small.m_ScaledPmf);
+        m_Bins[small.m_Index].m_Alias = large.m_Index;
+
+        // The overfull bin gave away (1 - small) of its probability
+        large.m_ScaledPmf -= 1.0 - small.m_ScaledPmf;
+        if (large.m_ScaledPmf < 1.0)
+        {
+            under.push_back(large);
+            over.pop_back();
+        }
+    }
+
+    // Whatever is left is full up to rounding error
+    for (const Outcome& outcome : under)
+        m_Bins[outcome.m_Index].m_Threshold = 1.0f;
+    for (const Outcome& outcome : over)
+        m_Bins[outcome.m_Index].m_Threshold = 1.0f;
+}
+
+exrU32 AliasTable::Sample(exrFloat u, exrFloat* pmf, exrFloat* uRemapped) const
+{
+    const exrU32 numBins = GetSize();
+    const exrU32 bin = exrMin(exrU32(u * numBins), numBins - 1);
+    const exrFloat up = exrMin(u * numBins - bin, OneMinusFloatEpsilon);
+
+    const Bin& sampledBin = m_Bins[bin];
+    const exrBool isOwnIndex = up < sampledBin.m_Threshold;
+    const exrU32 index = isOwnIndex ? bin : sampledBin.m_Alias;
+
+    if (pmf != nullptr)
+        *pmf = m_Bins[index].m_Pmf;
+
+    if (uRemapped != nullptr)
+    {
+        *uRemapped = isOwnIndex ? up / sampledBin.m_Threshold :
+            (up - sampledBin.m_Threshold) / (1.0f - sampledBin.m_Threshold);
+        *uRemapped = exrMin(*uRemapped, OneMinusFloatEpsilon);
+    }
+
+    return index;
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,71 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "system/system.h"
+#include "math/math.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief Samples indices in proportion to a set of weights in constant time
+//!
+//! Uses Vose's alias method: every index owns a bin that it shares with at most one other
+//! index (its alias), so a sample takes one bin lookup and one comparison no matter how
+//! many weights there are.
+class AliasTable
+{
+public:
+    AliasTable() = default;
+
+    //! @brief Builds a table over a set of non-negative weights
+    //!
+    //! If all weights are zero, every index is sampled with the same probability.
+    AliasTable(const std::vector<exrFloat>& weights);
+
+    //! @brief Samples an index
+    //! @param u                A uniform sample in [0, 1)
+    //! @param pmf              Outputs the probability of the index, if not null
+    //! @param uRemapped        Outputs a new uniform sample that is independent of the index, if not null
+    exrU32 Sample(exrFloat u, exrFloat* pmf = nullptr, exrFloat* uRemapped = nullptr) const;
+
+    //! @brief Returns the probability that an index is sampled
+    inline exrFloat Pmf(exrU32 index) const { return m_Bins[index].m_Pmf; }
+
+    //! @brief Returns the number of indices in the table
+    inline exrU32 GetSize() const { return static_cast<exrU32>(m_Bins.size()); }
+
+private:
+    struct Bin
+    {
+        //! The probability that the bin returns its own index rather than its alias
+        exrFloat m_Threshold = 0.0f;
+
+        //! The probability of the bin's own index over the whole table
+        exrFloat m_Pmf = 0.0f;
+
+        exrU32 m_Alias = 0;
+    };
+
+    std::vector<Bin> m_Bins;
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,76 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "haltonsampler.h"
+#include "lowdiscrepancy.h"
+
+exrBEGIN_NAMESPACE
+
+static constexpr exrU32 NumPrimes = 64;
+static constexpr exrU32 Primes[NumPrimes] =
+{
+    2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+    59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+    137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223,
+    227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311
+};
+
+exrFloat HaltonSampler::Get1D()
+{
+    return SampleDimension(m_Dimension++);
+}
+
+exrPoint2 HaltonSampler::Get2D()
+{
+    const exrFloat x = SampleDimension(m_Dimension);
+    const exrFloat y = SampleDimension(m_Dimension + 1);
+    m_Dimension += 2;
+    return exrPoint2(x, y);
+}
+
+exrFloat HaltonSampler::SampleDimension(exrU32 dimension) const
+{
+    const exrU64 seed = HashValues(m_Pixel.x, m_Pixel.y, dimension);
+    if (dimension >= NumPrimes)
+        return BitsToUnitFloat(exrU32(HashValues(seed, m_SampleIndex)));
+
+    // Digits are generated until they no longer change the float result. Zero digits past the
+    // end of the index are permuted too, otherwise the scrambling would not be uniform.
+    const exrU32 base = Primes[dimension];
+    const exrFloat invBase = 1.0f / base;
+    exrU32 index = m_SampleIndex;
+    exrFloat invBaseN = 1.0f;
+    exrFloat result = 0.0f;
+
+    for (exrU32 digitIndex = 0; invBaseN > 0x1p-24f; ++digitIndex)
+    {
+        const exrU32 next = index / base;
+        const exrU32 digit = index - next * base;
+        const exrU32 permutedDigit = PermutationElement(digit, base, exrU32(MixBits(seed + digitIndex)));
+
+        invBaseN *= invBase;
+        result += permutedDigit * invBaseN;
+        index = next;
+    }
+
+    return exrMin(result, OneMinusFloatEpsilon);
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,46 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "sampler.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A sampler that takes the samples of every pixel from the Halton sequence
+//!
+//! Dimension i is the radical inverse of the sample index in the i-th prime base. Every digit
+//! goes through a random permutation that depends on the pixel, the dimension and the digit,
+//! which breaks up the correlation between dimensions with large bases and keeps neighboring
+//! pixels from sharing a pattern. Dimensions past the prime table use uniform random numbers.
+class HaltonSampler : public Sampler
+{
+public:
+    HaltonSampler(exrU32 samplesPerPixel)
+        : Sampler(samplesPerPixel) {};
+
+    exrFloat Get1D() override;
+    exrPoint2 Get2D() override;
+
+private:
+    exrFloat SampleDimension(exrU32 dimension) const;
+};
+
+exrEND_NAMESPACE
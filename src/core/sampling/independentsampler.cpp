@@ -0,0 +1,49 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "independentsampler.h"
+#include "lowdiscrepancy.h"
+
+exrBEGIN_NAMESPACE
+
+void IndependentSampler::StartPixelSample(const Point2<exrU32>& pixel, exrU32 sampleIndex, exrU32 dimension)
+{
+    Sampler::StartPixelSample(pixel, sampleIndex, dimension);
+    m_Rng.SetSequence(HashValues(pixel.x, pixel.y, sampleIndex));
+
+    // Every dimension takes one number of the stream
+    if (dimension > 0)
+        m_Rng.Advance(dimension);
+}
+
+exrFloat IndependentSampler::Get1D()
+{
+    m_Dimension++;
+    return m_Rng.UniformFloat();
+}
+
+exrPoint2 IndependentSampler::Get2D()
+{
+    m_Dimension += 2;
+    const exrFloat x = m_Rng.UniformFloat();
+    return exrPoint2(x, m_Rng.UniformFloat());
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,46 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "sampler.h"
+#include "pcg32.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A sampler that returns independent uniform random numbers
+//!
+//! Every pixel sample draws from its own PCG32 stream. This converges the slowest, but makes
+//! no assumptions about the integrand and serves as a reference for the other samplers.
+class IndependentSampler : public Sampler
+{
+public:
+    IndependentSampler(exrU32 samplesPerPixel)
+        : Sampler(samplesPerPixel) {};
+
+    void StartPixelSample(const Point2<exrU32>& pixel, exrU32 sampleIndex, exrU32 dimension = 0) override;
+    exrFloat Get1D() override;
+    exrPoint2 Get2D() override;
+
+private:
+    PCG32 m_Rng;
+};
+
+exrEND_NAMESPACE
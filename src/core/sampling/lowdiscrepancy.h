@@ -0,0 +1,135 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "system/system.h"
+#include "math/math.h"
+
+exrBEGIN_NAMESPACE
+
+//! The largest float below 1, so that [0, 1) samples never round up to 1
+static constexpr exrFloat OneMinusFloatEpsilon = 0x1.fffffep-1f;
+
+//! @brief Scrambles the bits of a 64 bit value (the finalizer of MurmurHash3)
+inline exrU64 MixBits(exrU64 v)
+{
+    v ^= v >> 33;
+    v *= 0xff51afd7ed558ccdULL;
+    v ^= v >> 33;
+    v *= 0xc4ceb9fe1a85ec53ULL;
+    v ^= v >> 33;
+    return v;
+}
+
+//! @brief Hashes any number of integers into a single 64 bit value
+template <typename... Args>
+inline exrU64 HashValues(exrU64 first, Args... rest)
+{
+    exrU64 hash = MixBits(first);
+    ((hash = MixBits(hash ^ (exrU64(rest) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2)))), ...);
+    return hash;
+}
+
+//! @brief Maps 32 random bits to a float in [0, 1)
+inline exrFloat BitsToUnitFloat(exrU32 bits)
+{
+    return exrMin(exrFloat(bits) * 0x1p-32f, OneMinusFloatEpsilon);
+}
+
+inline exrU32 ReverseBits32(exrU32 v)
+{
+    v = (v << 16) | (v >> 16);
+    v = ((v & 0x00ff00ff) << 8) | ((v & 0xff00ff00) >> 8);
+    v = ((v & 0x0f0f0f0f) << 4) | ((v & 0xf0f0f0f0) >> 4);
+    v = ((v & 0x33333333) << 2) | ((v & 0xcccccccc) >> 2);
+    v = ((v & 0x55555555) << 1) | ((v & 0xaaaaaaaa) >> 1);
+    return v;
+}
+
+//! @brief Owen scrambles a base 2 fixed-point value in [0, 2^32)
+//!
+//! Uses the hash based nested uniform scramble of Burley, "Practical Hash-based Owen Scrambling"
+//! (JCGT 2020): every bit is flipped depending only on the bits above it.
+inline exrU32 OwenScramble(exrU32 v, exrU32 seed)
+{
+    v = ReverseBits32(v);
+    v += seed;
+    v ^= v * 0x6c50b47cu;
+    v ^= v * 0xb82f1e52u;
+    v ^= v * 0xc7afe638u;
+    v ^= v * 0x8d22f6e6u;
+    return ReverseBits32(v);
+}
+
+//! @brief Returns element i of a random permutation of [0, n), without storing the permutation
+//!
+//! From Kensler, "Correlated Multi-Jittered Sampling" (Pixar technical memo 13-01).
+inline exrU32 PermutationElement(exrU32 i, exrU32 n, exrU32 seed)
+{
+    exrU32 w = n - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+
+    do
+    {
+        i ^= seed;
+        i *= 0xe170893d;
+        i ^= seed >> 16;
+        i ^= (i & w) >> 4;
+        i ^= seed >> 8;
+        i *= 0x0929eb3f;
+        i ^= seed >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1 | seed >> 27;
+        i *= 0x6935fa69;
+        i ^= (i & w) >> 11;
+        i *= 0x74dcb303;
+        i ^= (i & w) >> 2;
+        i *= 0x9e501cc3;
+        i ^= (i & w) >> 2;
+        i *= 0xc860a3df;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= n);
+
+    return (i + seed) % n;
+}
+
+//! @brief Returns the first two dimensions of the Sobol sequence as 32 bit fixed-point values
+//!
+//! The first dimension is the van der Corput sequence. The generator matrix of the second one
+//! is Pascal's triangle mod 2, whose columns follow from v[k] = v[k - 1] ^ (v[k - 1] >> 1).
+inline void SobolSample2D(exrU32 index, exrU32& x, exrU32& y)
+{
+    x = ReverseBits32(index);
+    y = 0;
+
+    for (exrU32 v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1)
+    {
+        if (index & 1)
+            y ^= v;
+    }
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,123 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "system/system.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A small and fast permuted congruential generator (PCG32)
+//!
+//! Every generator has 2^63 independent streams of 2^64 numbers. Selecting a different stream
+//! for every pixel makes the sequence that a pixel uses independent of the order that pixels
+//! are rendered in, and of the thread that renders them.
+class PCG32
+{
+public:
+    constexpr PCG32()
+        : m_State(DefaultState)
+        , m_Increment(DefaultStream) {};
+
+    PCG32(exrU64 sequenceIndex, exrU64 seed = DefaultState) { SetSequence(sequenceIndex, seed); }
+
+    //! @brief Restarts the generator at the beginning of a stream
+    //! @param sequenceIndex    The stream to select
+    //! @param seed             The starting state within the stream
+    void SetSequence(exrU64 sequenceIndex, exrU64 seed = DefaultState)
+    {
+        m_State = 0;
+        m_Increment = (sequenceIndex << 1u) | 1u;
+        UniformUInt32();
+        m_State += seed;
+        UniformUInt32();
+    }
+
+    //! @return A random number in the range [0, 2^32 - 1].
+    exrU32 UniformUInt32()
+    {
+        const exrU64 oldState = m_State;
+        m_State = oldState * Multiplier + m_Increment;
+        const exrU32 xorShifted = exrU32(((oldState >> 18u) ^ oldState) >> 27u);
+        const exrU32 rotation = exrU32(oldState >> 59u);
+        return (xorShifted >> rotation) | (xorShifted << ((~rotation + 1u) & 31));
+    }
+
+    //! @param b the upper bound of the generated number
+    //! @return A random number in the range [0, b], without modulo bias.
+    exrU32 UniformUInt32(exrU32 b)
+    {
+        if (b == ~exrU32(0))
+            return UniformUInt32();
+
+        const exrU32 bound = b + 1;
+        const exrU32 threshold = (~bound + 1u) % bound;
+
+        while (true)
+        {
+            const exrU32 r = UniformUInt32();
+            if (r >= threshold)
+                return r % bound;
+        }
+    }
+
+    //! @return A random floating-point number in the range [0,1).
+    exrFloat UniformFloat()
+    {
+        // The top 24 bits fill the mantissa exactly, so this can never round up to 1
+        return exrFloat(UniformUInt32() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    //! @brief Skips over numbers of the stream in O(log delta) steps
+    //! @param delta            The number of numbers to skip, or to step back if negative
+    void Advance(exrS64 delta)
+    {
+        exrU64 curMultiplier = Multiplier;
+        exrU64 curIncrement = m_Increment;
+        exrU64 accMultiplier = 1u;
+        exrU64 accIncrement = 0u;
+
+        // Composes the affine step with itself for every bit of delta (Brown, "Random Number
+        // Generation with Arbitrary Strides"). Negative deltas wrap around the 2^64 period.
+        for (exrU64 steps = exrU64(delta); steps > 0; steps >>= 1)
+        {
+            if (steps & 1u)
+            {
+                accMultiplier *= curMultiplier;
+                accIncrement = accIncrement * curMultiplier + curIncrement;
+            }
+
+            curIncrement = (curMultiplier + 1u) * curIncrement;
+            curMultiplier *= curMultiplier;
+        }
+
+        m_State = accMultiplier * m_State + accIncrement;
+    }
+
+private:
+    static constexpr exrU64 DefaultState = 0x853c49e6748fea9bULL;
+    static constexpr exrU64 DefaultStream = 0xda3e39cb94b95bdbULL;
+    static constexpr exrU64 Multiplier = 0x5851f42d4c957f2dULL;
+
+    exrU64 m_State;
+    exrU64 m_Increment;
+};
+
+exrEND_NAMESPACE
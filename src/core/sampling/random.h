@@ -20,35 +20,38 @@
 
 #pragma once
 
-#include <random>
 #include "system/system.h"
 #include "math/math.h"
+#include "pcg32.h"
 
 exrBEGIN_NAMESPACE
 
 //! @brief A class that handles various pseudo random value generations
+//!
+//! Every thread has its own generator, so threads never share (or race on) any state. Rendering
+//! takes its samples from a Sampler instead, which makes renders deterministic.
 class Random
 {
 public:
-    static void Seed(exrU32 seed) { m_Rng = std::mt19937(seed); }
+    static void Seed(exrU32 seed) { m_Rng.SetSequence(0, seed); }
 
-    //! @return A random number in the range [0, 2^23 - 1].
-    static exrU32 UniformUInt32() { return m_Rng(); }
+    //! @brief Restarts the generator of the calling thread at the beginning of a stream
+    //! @param sequenceIndex    The stream to select, e.g. the index of the sample being taken
+    static void SetSequence(exrU64 sequenceIndex) { m_Rng.SetSequence(sequenceIndex); }
+
+    //! @return A random number in the range [0, 2^32 - 1].
+    static exrU32 UniformUInt32() { return m_Rng.UniformUInt32(); }
     
     //! @param b the upper bound of the generated number
     //! @return A random number in the range [0, b].
-    static exrU32 UniformUInt32(exrU32 b) {
-        return (std::uniform_int_distribution<exrU32>(0, b))(m_Rng);
-    }
+    static exrU32 UniformUInt32(exrU32 b) { return m_Rng.UniformUInt32(b); }
 
     //! @return A random floating-point number in the range [0,1).
-    static exrFloat UniformFloat() {
-        return (std::uniform_real_distribution<exrFloat>(0, 1))(m_Rng);
-    }
+    static exrFloat UniformFloat() { return m_Rng.UniformFloat(); }
 
 private:
     Random() {}
-    static std::mt19937 m_Rng;
+    static inline thread_local PCG32 m_Rng;
 };
 
-exrEND_NAMESPACE
\ No newline at end of file
+exrEND_NAMESPACE
@@ -0,0 +1,61 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sampler.h"
+#include "haltonsampler.h"
+#include "independentsampler.h"
+#include "sobolsampler.h"
+#include "stratifiedsampler.h"
+
+exrBEGIN_NAMESPACE
+
+std::unique_ptr<Sampler> Sampler::Create(SamplerType type, exrU32 samplesPerPixel)
+{
+    switch (type)
+    {
+    case SAMPLERTYPE_INDEPENDENT:
+        return std::make_unique<IndependentSampler>(samplesPerPixel);
+    case SAMPLERTYPE_STRATIFIED:
+        return std::make_unique<StratifiedSampler>(samplesPerPixel);
+    case SAMPLERTYPE_HALTON:
+        return std::make_unique<HaltonSampler>(samplesPerPixel);
+    case SAMPLERTYPE_SOBOL:
+    default:
+        return std::make_unique<SobolSampler>(samplesPerPixel);
+    }
+}
+
+exrBool Sampler::ParseSamplerType(const exrString& name, SamplerType& type)
+{
+    if (name == "independent")
+        type = SAMPLERTYPE_INDEPENDENT;
+    else if (name == "stratified")
+        type = SAMPLERTYPE_STRATIFIED;
+    else if (name == "halton")
+        type = SAMPLERTYPE_HALTON;
+    else if (name == "sobol")
+        type = SAMPLERTYPE_SOBOL;
+    else
+        return false;
+
+    return true;
+}
+
+exrEND_NAMESPACE
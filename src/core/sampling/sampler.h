@@ -0,0 +1,91 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "system/system.h"
+#include "math/math.h"
+
+exrBEGIN_NAMESPACE
+
+//! The sample patterns that pixels can be rendered with
+enum SamplerType
+{
+    SAMPLERTYPE_INDEPENDENT,    //!< Uniform random numbers, with no correlation between samples
+    SAMPLERTYPE_STRATIFIED,     //!< Jittered samples, one per stratum of every dimension
+    SAMPLERTYPE_HALTON,         //!< The Halton sequence, with the digits permuted per pixel
+    SAMPLERTYPE_SOBOL           //!< Owen scrambled Sobol points, shuffled per pixel and dimension
+};
+
+//! @brief Generates the sample values that a single pixel sample consumes
+//!
+//! Every random decision of a camera path (the position on the image and the lens, the choice
+//! and sample of a light, the choice and direction of a BSDF sample, ...) takes the next
+//! dimension of the current sample in a fixed order. Samples are a pure function of the pixel,
+//! the sample index and the dimension, so renders do not depend on scheduling, and samplers can
+//! spread the samples of a pixel evenly over every dimension.
+//!
+//! A sampler is not thread safe; every tile uses its own.
+class Sampler
+{
+public:
+    //! @param samplesPerPixel  The number of samples that a pixel will usually take. Samplers
+    //!                         are most effective if it is a power of two.
+    Sampler(exrU32 samplesPerPixel)
+        : m_SamplesPerPixel(samplesPerPixel) {};
+
+    virtual ~Sampler() = default;
+
+    //! @brief Starts a sample of a pixel
+    //!
+    //! Starting at the dimension that another sampler had reached continues the same sample, so
+    //! a path can be suspended and resumed on another sampler.
+    //! @param dimension        The first dimension to take, usually 0
+    virtual void StartPixelSample(const Point2<exrU32>& pixel, exrU32 sampleIndex, exrU32 dimension = 0)
+    {
+        m_Pixel = pixel;
+        m_SampleIndex = sampleIndex;
+        m_Dimension = dimension;
+    }
+
+    //! @return The number of dimensions of the current sample that have been taken
+    inline exrU32 GetDimension() const { return m_Dimension; }
+
+    //! @return The next dimension of the current sample, in [0, 1)
+    virtual exrFloat Get1D() = 0;
+
+    //! @return The next two dimensions of the current sample, in [0, 1)^2
+    virtual exrPoint2 Get2D() = 0;
+
+    //! @brief Creates a sampler of the given type
+    static std::unique_ptr<Sampler> Create(SamplerType type, exrU32 samplesPerPixel);
+
+    //! @brief Parses the name of a sampler type (independent, stratified, halton or sobol)
+    //! @return                 False if the name is unknown
+    static exrBool ParseSamplerType(const exrString& name, SamplerType& type);
+
+protected:
+    const exrU32 m_SamplesPerPixel;
+    Point2<exrU32> m_Pixel;
+    exrU32 m_SampleIndex = 0;
+    exrU32 m_Dimension = 0;
+};
+
+exrEND_NAMESPACE
@@ -37,11 +37,11 @@ inline exrFloat UniformHemispherePdf() {
     return EXR_M_INV2PI;
 }
 
-inline exrVector3 UniformSampleSphere()
+inline exrVector3 UniformSampleSphere(const exrPoint2& u)
 {
-    exrFloat z = 1 - 2 * Random::UniformFloat();
+    exrFloat z = 1 - 2 * u.x;
     exrFloat r = sqrt(exrMax(0.0f, 1.0f - z * z));
-    exrFloat phi = 2 * EXR_M_PI * Random::UniformFloat();
+    exrFloat phi = 2 * EXR_M_PI * u.y;
     return exrVector3(r * cos(phi), r * sin(phi), z);
 }
 
@@ -50,19 +50,10 @@ inline exrFloat UniformSpherePdf()
     return EXR_M_INV2PI;
 }
 
-inline exrPoint2 RejectionSampleDisk()
-{
-    exrPoint2 p;
-    do {
-        p.x = 1 - 2 * Random::UniformFloat();
-        p.y = 1 - 2 * Random::UniformFloat();
-    } while (p.x * p.x + p.y * p.y > 1);
-    return p;
-}
-
-inline exrPoint2 ConcentricSampleDisk()
+// Maps the unit square onto the unit disk, keeping strata of the square intact
+inline exrPoint2 ConcentricSampleDisk(const exrPoint2& u)
 {
-    exrPoint2 uOffset = 2.0f * exrPoint2(Random::UniformFloat(), Random::UniformFloat()) - exrVector2(1, 1);
+    exrPoint2 uOffset = 2.0f * u - exrVector2(1, 1);
 
     if (uOffset.x == 0 && uOffset.y == 0)
         return exrPoint2(0, 0);
@@ -81,9 +72,9 @@ inline exrPoint2 ConcentricSampleDisk()
     return r * exrPoint2(cos(theta), sin(theta));
 }
 
-inline exrVector3 CosineSampleHemisphere()
+inline exrVector3 CosineSampleHemisphere(const exrPoint2& u)
 {
-    exrPoint2 d = ConcentricSampleDisk();
+    exrPoint2 d = ConcentricSampleDisk(u);
     exrFloat z = sqrt(exrMax(0.0f, 1.0f - d.x * d.x - d.y * d.y));
     return exrVector3(d.x, d.y, z);
 }
@@ -93,4 +84,29 @@ inline exrFloat CosineHemispherePdf(exrFloat cosTheta)
     return cosTheta * EXR_M_INVPI;
 }
 
+//! @brief Samples barycentric coordinates uniformly over a triangle
+//! @return                 The first two barycentric coordinates; the third is 1 minus their sum
+inline exrPoint2 UniformSampleTriangle(const exrPoint2& u)
+{
+    const exrFloat su0 = sqrt(u.x);
+    return exrPoint2(1.0f - su0, u.y * su0);
+}
+
+inline exrFloat UniformConePdf(exrFloat cosThetaMax)
+{
+    return 1.0f / (2.0f * EXR_M_PI * (1.0f - cosThetaMax));
+}
+
+//! @brief The weight of a sample from strategy f when it is combined with strategy g (Veach's power heuristic, beta = 2)
+//! @param nf               The number of samples taken from f
+//! @param fPdf             The pdf of the sample under f
+//! @param ng               The number of samples taken from g
+//! @param gPdf             The pdf of the sample under g
+inline exrFloat PowerHeuristic(exrU32 nf, exrFloat fPdf, exrU32 ng, exrFloat gPdf)
+{
+    const exrFloat f = nf * fPdf;
+    const exrFloat g = ng * gPdf;
+    return (f * f) / (f * f + g * g);
+}
+
 exrEND_NAMESPACE
\ No newline at end of file
@@ -0,0 +1,50 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sobolsampler.h"
+#include "lowdiscrepancy.h"
+
+exrBEGIN_NAMESPACE
+
+exrFloat SobolSampler::Get1D()
+{
+    const exrU64 hash = HashValues(m_Pixel.x, m_Pixel.y, m_Dimension++);
+    const exrU32 index = OwenScramble(m_SampleIndex, exrU32(hash));
+
+    exrU32 x, y;
+    SobolSample2D(index, x, y);
+    return BitsToUnitFloat(OwenScramble(x, exrU32(hash >> 32)));
+}
+
+exrPoint2 SobolSampler::Get2D()
+{
+    const exrU64 hash = HashValues(m_Pixel.x, m_Pixel.y, m_Dimension);
+    const exrU32 index = OwenScramble(m_SampleIndex, exrU32(hash));
+    m_Dimension += 2;
+
+    exrU32 x, y;
+    SobolSample2D(index, x, y);
+
+    const exrU64 scrambleSeeds = MixBits(hash);
+    return exrPoint2(BitsToUnitFloat(OwenScramble(x, exrU32(scrambleSeeds))),
+                     BitsToUnitFloat(OwenScramble(y, exrU32(scrambleSeeds >> 32))));
+}
+
+exrEND_NAMESPACE
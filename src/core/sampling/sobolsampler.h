@@ -0,0 +1,44 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "sampler.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A sampler that takes Owen scrambled Sobol points for every pixel
+//!
+//! Every 1D or 2D sample uses the first one or two Sobol dimensions, whose order is shuffled
+//! by a random nested permutation of the sample index, and whose values are Owen scrambled.
+//! Both depend on the pixel and the dimension, which decorrelates dimensions from each other
+//! while keeping each of them well stratified ("padded" Sobol, see Burley 2020). The samples
+//! of a pixel are stratified best when their number is a power of two.
+class SobolSampler : public Sampler
+{
+public:
+    SobolSampler(exrU32 samplesPerPixel)
+        : Sampler(samplesPerPixel) {};
+
+    exrFloat Get1D() override;
+    exrPoint2 Get2D() override;
+};
+
+exrEND_NAMESPACE
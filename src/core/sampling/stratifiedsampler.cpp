@@ -0,0 +1,59 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stratifiedsampler.h"
+#include "lowdiscrepancy.h"
+
+exrBEGIN_NAMESPACE
+
+StratifiedSampler::StratifiedSampler(exrU32 samplesPerPixel)
+    : Sampler(exrMax(samplesPerPixel, 1u))
+{
+    // Use the divisor closest to the square root, so that strata are as square as possible
+    m_NumStrataX = exrU32(sqrt(exrFloat(m_SamplesPerPixel)));
+    while (m_SamplesPerPixel % m_NumStrataX != 0)
+        m_NumStrataX--;
+
+    m_NumStrataY = m_SamplesPerPixel / m_NumStrataX;
+}
+
+exrFloat StratifiedSampler::Get1D()
+{
+    const exrU64 hash = HashValues(m_Pixel.x, m_Pixel.y, m_Dimension, m_SampleIndex / m_SamplesPerPixel);
+    const exrU32 stratum = PermutationElement(m_SampleIndex % m_SamplesPerPixel, m_SamplesPerPixel, exrU32(hash));
+    const exrFloat jitter = BitsToUnitFloat(exrU32(HashValues(hash, m_SampleIndex)));
+    m_Dimension++;
+
+    return exrMin((stratum + jitter) / m_SamplesPerPixel, OneMinusFloatEpsilon);
+}
+
+exrPoint2 StratifiedSampler::Get2D()
+{
+    const exrU64 hash = HashValues(m_Pixel.x, m_Pixel.y, m_Dimension, m_SampleIndex / m_SamplesPerPixel);
+    const exrU32 stratum = PermutationElement(m_SampleIndex % m_SamplesPerPixel, m_SamplesPerPixel, exrU32(hash));
+    const exrU64 jitter = HashValues(hash, m_SampleIndex);
+    m_Dimension += 2;
+
+    const exrFloat x = (stratum % m_NumStrataX + BitsToUnitFloat(exrU32(jitter))) / m_NumStrataX;
+    const exrFloat y = (stratum / m_NumStrataX + BitsToUnitFloat(exrU32(jitter >> 32))) / m_NumStrataY;
+    return exrPoint2(exrMin(x, OneMinusFloatEpsilon), exrMin(y, OneMinusFloatEpsilon));
+}
+
+exrEND_NAMESPACE
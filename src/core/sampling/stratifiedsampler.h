@@ -0,0 +1,46 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "sampler.h"
+
+exrBEGIN_NAMESPACE
+
+//! @brief A sampler that places every sample of a pixel in its own stratum
+//!
+//! Each dimension is split into as many strata as there are samples per pixel (2D samples into
+//! the most square grid with that many cells), and the samples of a pixel visit the strata in
+//! a random order that is different for every pixel and dimension. Samples beyond the samples
+//! per pixel (e.g. for adaptive sampling) start another round of strata.
+class StratifiedSampler : public Sampler
+{
+public:
+    StratifiedSampler(exrU32 samplesPerPixel);
+
+    exrFloat Get1D() override;
+    exrPoint2 Get2D() override;
+
+private:
+    exrU32 m_NumStrataX;
+    exrU32 m_NumStrataY;
+};
+
+exrEND_NAMESPACE
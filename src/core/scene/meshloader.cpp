@@ -0,0 +1,97 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "meshloader.h"
+#include "core/primitive/geometrycache.h"
+#include "core/primitive/mesh.h"
+#include "core/primitive/shape/displacedpatch.h"
+#include "core/primitive/shape/triangle.h"
+#include "core/scene/scene.h"
+#include "core/spatial/accelerator/bvh.h"
+#include <fstream>
+
+exrBEGIN_NAMESPACE
+
+static void LoadMesh(const MeshLoader::Request& request, GeometryCache* geometryCache,
+    const TessellationCache* tessellationCache, Scene::PrimitiveGroup& result)
+{
+    std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(Mesh::LoadFromFile(request.m_FileName.c_str()));
+    result.m_Mesh = mesh;
+
+    if (geometryCache != nullptr)
+        mesh->PageOut(*geometryCache);
+
+    std::shared_ptr<DisplacedSurface> surface;
+    if (request.m_Displacement.m_Level > 0)
+    {
+        exrAssert(tessellationCache != nullptr, "Displaced meshes require a tessellation cache!");
+        surface = std::make_shared<DisplacedSurface>(mesh, request.m_Displacement, *tessellationCache);
+    }
+
+    std::vector<Primitive*> primitivePtrs;
+    result.m_Primitives.reserve(mesh->m_NumFaces);
+    primitivePtrs.reserve(mesh->m_NumFaces);
+
+    for (exrU32 i = 0; i < mesh->m_NumFaces; ++i)
+    {
+        std::unique_ptr<Primitive> primitive = std::make_unique<Primitive>();
+        if (surface != nullptr)
+            primitive->SetShape(std::make_unique<DisplacedPatch>(surface, i));
+        else
+            primitive->SetShape(std::make_unique<Triangle>(mesh, i));
+        primitive->SetMaterial(request.m_Material);
+        primitivePtrs.push_back(primitive.get());
+        result.m_Primitives.push_back(std::move(primitive));
+    }
+
+    result.m_Accelerator = std::make_unique<BVHAccelerator>(primitivePtrs);
+}
+
+std::vector<std::shared_ptr<Scene::PrimitiveGroup>> MeshLoader::LoadMeshes(const std::vector<Request>& requests,
+    GeometryCache* geometryCache, const TessellationCache* tessellationCache)
+{
+    exrProfile("Loading " + std::to_string(requests.size()) + " Mesh(es)");
+
+    std::vector<std::shared_ptr<Scene::PrimitiveGroup>> groups(requests.size());
+    for (std::shared_ptr<Scene::PrimitiveGroup>& group : groups)
+        group = std::make_shared<Scene::PrimitiveGroup>();
+
+    // Start the largest files first so that a big mesh does not end up running alone
+    std::vector<exrU32> order(requests.size());
+    std::vector<exrU64> fileSizes(requests.size());
+    for (exrU32 i = 0; i < requests.size(); ++i)
+    {
+        std::ifstream file(requests[i].m_FileName, std::ifstream::ate | std::ifstream::binary);
+        order[i] = i;
+        fileSizes[i] = file ? exrU64(file.tellg()) : 0;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](exrU32 a, exrU32 b) { return fileSizes[a] > fileSizes[b]; });
+
+    ParallelFor(0, order.size(), 1, [&](exrU64 i)
+    {
+        LoadMesh(requests[order[i]], geometryCache, tessellationCache, *groups[order[i]]);
+    });
+
+    exrEndProfile();
+    return groups;
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,64 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "core/elixir.h"
+#include "core/primitive/displacedsurface.h"
+#include "core/scene/scene.h"
+
+exrBEGIN_NAMESPACE
+
+class GeometryCache;
+class Material;
+class TessellationCache;
+
+//! @brief Loads mesh files in parallel
+//!
+//! Reading, parsing and building the acceleration structure of a mesh are independent of
+//! all other meshes, so each mesh is processed as its own task on a thread pool.
+class MeshLoader
+{
+public:
+    //! @brief A single mesh file to load
+    struct Request
+    {
+        //! The path of the .obj file
+        exrString m_FileName;
+
+        //! The material assigned to every triangle of the mesh (Owned by scene)
+        const Material* m_Material;
+
+        //! If the subdivision level is not zero, the faces become lazily displaced patches
+        DisplacementSettings m_Displacement;
+    };
+
+    //! @brief Loads all requested meshes into primitive groups that can be instanced into a scene
+    //! 
+    //! @param requests         The mesh files to load
+    //! @param geometryCache    If not null, mesh data is paged out to this cache after loading
+    //! @param tessellationCache The cache for the patches of displaced meshes. Required if any are requested.
+    //! 
+    //! @return                 One primitive group per request, in the order they were requested
+    static std::vector<std::shared_ptr<Scene::PrimitiveGroup>> LoadMeshes(const std::vector<Request>& requests,
+        GeometryCache* geometryCache = nullptr, const TessellationCache* tessellationCache = nullptr);
+};
+
+exrEND_NAMESPACE
@@ -19,6 +19,7 @@
 */
 
 #include "scene.h"
+#include "core/light/arealight.h"
 #include "core/spatial/accelerator/bvh.h"
 
 exrBEGIN_NAMESPACE
@@ -45,9 +46,64 @@ void Scene::AddPrimitive(std::unique_ptr<Primitive> primitive)
     m_SceneChanged = true;
 }
 
+void Scene::AddPrimitiveGroup(std::vector<std::unique_ptr<Primitive>> primitives, std::unique_ptr<Accelerator> accelerator)
+{
+    std::shared_ptr<PrimitiveGroup> group = std::make_shared<PrimitiveGroup>();
+    group->m_Primitives = std::move(primitives);
+    group->m_Accelerator = std::move(accelerator);
+    AddInstance(std::move(group));
+}
+
+void Scene::AddInstance(std::shared_ptr<const PrimitiveGroup> group, const Transform* transform, const Material* material)
+{
+    if (transform == nullptr)
+        m_GroupInstances.push_back({ std::move(group), nullptr, 1.0f, material, {} });
+    else
+    {
+        // GetScale() only works for unrotated transforms, so measure transformed unit vectors instead.
+        // Distances along object space rays are converted with a single factor, which is only
+        // correct if every axis is scaled alike.
+        const exrFloat scale = (transform->GetMatrix() * exrVector3(1, 0, 0)).Magnitude();
+        const exrFloat scaleY = (transform->GetMatrix() * exrVector3(0, 1, 0)).Magnitude();
+        const exrFloat scaleZ = (transform->GetMatrix() * exrVector3(0, 0, 1)).Magnitude();
+
+        if (!(scale > 0.0f) || std::abs(scaleY - scale) > 1e-4f * scale || std::abs(scaleZ - scale) > 1e-4f * scale)
+            throw std::invalid_argument("Instances only support uniform, non-zero scaling");
+
+        m_GroupInstances.push_back({ std::move(group), std::make_unique<Transform>(*transform), scale, material, {} });
+    }
+
+    // Shapes are shared by all instances of a group, so every instance has its own lights
+    GroupInstance& instance = m_GroupInstances.back();
+    const Transform instanceTransform = transform != nullptr ? *transform : Transform();
+    exrU32 numUnsupportedShapes = 0;
+
+    for (const std::unique_ptr<Primitive>& primitive : instance.m_Group->m_Primitives)
+    {
+        const Material* primitiveMaterial = material != nullptr ? material : primitive->GetMaterial();
+        if (primitiveMaterial == nullptr || !primitiveMaterial->IsEmissive())
+            continue;
+
+        const Shape* shape = primitive->GetShape();
+        if (shape->Area() <= 0.0f)
+        {
+            numUnsupportedShapes++;
+            continue;
+        }
+
+        std::unique_ptr<AreaLight> light = std::make_unique<AreaLight>(instanceTransform, shape, primitiveMaterial->GetEmission());
+        instance.m_AreaLights[shape] = light.get();
+        AddLight(std::move(light));
+    }
+
+    if (numUnsupportedShapes > 0)
+        exrWarningLine(numUnsupportedShapes << " emissive shapes cannot be sampled and will not emit light");
+
+    m_SceneChanged = true;
+}
+
 void Scene::AddLight(std::unique_ptr<Light> light)
 {
-    light->Preprocess(*this);
     m_Lights.push_back(light.get());
     m_SceneLights.push_back(std::move(light));
 }
@@ -67,76 +123,455 @@ Material* Scene::GetMaterial(exrU32 index)
 
 void Scene::AddLight(Light& light)
 {
-    light.Preprocess(*this);
     m_Lights.push_back(&light);
 }
 
+exrU64 Scene::GetSceneSize() const
+{
+    exrU64 size = static_cast<exrU64>(m_Primitives.size());
+
+    for (const GroupInstance& instance : m_GroupInstances)
+        size += static_cast<exrU64>(instance.m_Group->m_Primitives.size());
+
+    return size;
+}
+
 void Scene::InitAccelerator()
 {
     m_SceneChanged = false;
+    BuildInstanceBVH();
+
+    // Everything may have been added in prebuilt groups
+    m_Accelerator = nullptr;
+    if (!m_Primitives.empty())
+    {
+        std::vector<Primitive*> primitivePtrs;
+
+        // shallow copy pointer values to be used by bvh accel
+        for (exrU32 i = 0; i < m_Primitives.size(); ++i)
+            primitivePtrs.push_back(m_Primitives[i].get());
+
+        switch (m_AcceleratorType)
+        {
+        case Accelerator::ACCELERATORTYPE_BVH:
+            m_Accelerator = std::make_unique<BVHAccelerator>(primitivePtrs);
+            break;
+        case Accelerator::ACCELERATORTYPE_KDTREE:
+            throw "KDTree is not yet implemented!";
+        default:
+            throw "Invalid accelerator type!";
+        }
+    }
+
+    // Lights may depend on the extent of the scene, so they are prepared once all geometry is in
+    for (Light* light : m_Lights)
+        light->Preprocess(*this);
+}
+
+AABB Scene::GetBoundingVolume() const
+{
+    exrAssert(!m_SceneChanged, "Scene accelerator has not yet been initialized!");
+
+    if (m_InstanceNodes.empty())
+        return m_Accelerator != nullptr ? m_Accelerator->GetBoundingVolume() : AABB(exrPoint3::Zero(), exrPoint3::Zero());
 
-    std::vector<Primitive*> primitivePtrs;
+    if (m_Accelerator == nullptr)
+        return m_InstanceNodes[0].m_BoundingVolume;
 
-    // shallow copy pointer values to be used by bvh accel
-    for (exrU32 i = 0; i < m_Primitives.size(); ++i)
-        primitivePtrs.push_back(m_Primitives[i].get());
+    return AABB::Union(m_InstanceNodes[0].m_BoundingVolume, m_Accelerator->GetBoundingVolume());
+}
+
+//! Maximum instances in a leaf of the instance BVH
+static constexpr exrU32 MaxInstancesPerLeaf = 2;
+
+//! The maximum number of instance BVH nodes that traversal may have to come back to. The median
+//! splits keep the tree balanced, so this is enough for any number of instances that fits in 32 bits.
+static constexpr exrU32 MaxInstanceStackSize = 64;
+
+// Bounds the eight corners of a bounding volume after a transform
+static AABB TransformBoundingVolume(const Transform& transform, const AABB& bounds)
+{
+    const exrPoint3 first = transform.GetMatrix() * bounds.Min();
+    AABB result(first, first);
 
-    switch (m_AcceleratorType)
+    for (exrU32 i = 1; i < 8; ++i)
     {
-    case Accelerator::ACCELERATORTYPE_BVH:
-        m_Accelerator = std::make_unique<BVHAccelerator>(primitivePtrs);
-        break;
-    case Accelerator::ACCELERATORTYPE_KDTREE:
-        throw "KDTree is not yet implemented!";
-    default:
-        throw "Invalid accelerator type!";
+        const exrPoint3 corner(
+            (i & 1) ? bounds.Max().x : bounds.Min().x,
+            (i & 2) ? bounds.Max().y : bounds.Min().y,
+            (i & 4) ? bounds.Max().z : bounds.Min().z);
+
+        const exrPoint3 point = transform.GetMatrix() * corner;
+        result = AABB::Union(result, AABB(point, point));
     }
+
+    return result;
 }
 
-exrBool Scene::Intersect(const Ray& ray, SurfaceInteraction* interaction) const
+// Recursively builds the subtree over the instances in order[begin, end), appending its nodes in
+// depth first order. Instances are split at the median of their centers along the widest axis.
+static exrU32 BuildInstanceNode(const std::vector<AABB>& bounds, std::vector<exrU32>& order, exrU32 begin, exrU32 end,
+    std::vector<LinearBVHNode>& nodes)
+{
+    auto center = [&](exrU32 instance) { return bounds[instance].Min() + bounds[instance].GetExtents() * 0.5f; };
+
+    AABB nodeBounds = bounds[order[begin]];
+    AABB centerBounds(center(order[begin]), center(order[begin]));
+
+    for (exrU32 i = begin + 1; i < end; ++i)
+    {
+        nodeBounds = AABB::Union(nodeBounds, bounds[order[i]]);
+        centerBounds = AABB::Union(centerBounds, AABB(center(order[i]), center(order[i])));
+    }
+
+    const exrU32 index = static_cast<exrU32>(nodes.size());
+    nodes.push_back({ nodeBounds, begin, end - begin, 0 });
+
+    if (end - begin <= MaxInstancesPerLeaf)
+        return index;
+
+    const exrVector3 extents = centerBounds.GetExtents();
+    const exrU32 axis = extents.x > extents.y && extents.x > extents.z ? 0 : (extents.y > extents.z ? 1 : 2);
+    const exrU32 middle = begin + (end - begin) / 2;
+
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](exrU32 lhs, exrU32 rhs)
+    {
+        return center(lhs)[axis] < center(rhs)[axis];
+    });
+
+    // The first child is implicitly the next node
+    BuildInstanceNode(bounds, order, begin, middle, nodes);
+    const exrU32 secondChild = BuildInstanceNode(bounds, order, middle, end, nodes);
+
+    nodes[index].m_Offset = secondChild;
+    nodes[index].m_NumPrimitives = 0;
+    nodes[index].m_SplitAxis = axis;
+    return index;
+}
+
+void Scene::BuildInstanceBVH()
 {
-    exrAssert(m_Accelerator, "Scene accelerator has not yet been initialized!");
-    const std::vector<Primitive*>* possibleHits = m_Accelerator->Intersect(ray);
+    m_InstanceNodes.clear();
+    m_OrderedInstances.clear();
+
+    if (m_GroupInstances.empty())
+        return;
+
+    // Instances of the same group share its object space bounds
+    std::unordered_map<const PrimitiveGroup*, AABB> groupBounds;
+    std::vector<AABB> instanceBounds;
+    instanceBounds.reserve(m_GroupInstances.size());
+
+    for (const GroupInstance& instance : m_GroupInstances)
+    {
+        auto bounds = groupBounds.find(instance.m_Group.get());
+        if (bounds == groupBounds.end())
+            bounds = groupBounds.emplace(instance.m_Group.get(), instance.m_Group->m_Accelerator->GetBoundingVolume()).first;
+
+        instanceBounds.push_back(instance.m_Transform == nullptr ? bounds->second : TransformBoundingVolume(*instance.m_Transform, bounds->second));
+        m_OrderedInstances.push_back(static_cast<exrU32>(m_OrderedInstances.size()));
+    }
+
+    m_InstanceNodes.reserve(2 * m_GroupInstances.size());
+    BuildInstanceNode(instanceBounds, m_OrderedInstances, 0, static_cast<exrU32>(m_OrderedInstances.size()), m_InstanceNodes);
+}
+
+// Calls visit(orderedIndex) for the instances of every instance BVH leaf that the ray enters, near
+// children first, until visit returns true
+template <typename Visitor>
+static void TraverseInstances(const std::vector<LinearBVHNode>& nodes, const Ray& ray, Visitor visit)
+{
+    if (nodes.empty())
+        return;
+
+    const exrBool isDirectionNegative[3] = { ray.m_Direction.x < 0, ray.m_Direction.y < 0, ray.m_Direction.z < 0 };
+    exrU32 nodesToVisit[MaxInstanceStackSize];
+    exrU32 numNodesToVisit = 0;
+    exrU32 currentNode = 0;
+
+    while (true)
+    {
+        const LinearBVHNode& node = nodes[currentNode];
+
+        if (node.m_BoundingVolume.Intersect(ray))
+        {
+            if (node.m_NumPrimitives > 0)
+            {
+                for (exrU32 i = 0; i < node.m_NumPrimitives; ++i)
+                {
+                    if (visit(node.m_Offset + i))
+                        return;
+                }
+            }
+            else
+            {
+                exrAssert(numNodesToVisit < MaxInstanceStackSize, "Instance BVH traversal stack overflow!");
+                if (isDirectionNegative[node.m_SplitAxis])
+                {
+                    nodesToVisit[numNodesToVisit++] = currentNode + 1;
+                    currentNode = node.m_Offset;
+                }
+                else
+                {
+                    nodesToVisit[numNodesToVisit++] = node.m_Offset;
+                    currentNode = currentNode + 1;
+                }
+
+                continue;
+            }
+        }
 
-    if (possibleHits == nullptr)
+        if (numNodesToVisit == 0)
+            break;
+
+        currentNode = nodesToVisit[--numNodesToVisit];
+    }
+}
+
+// The packet version of the above. visit(orderedIndex, nodeMask) returns the lanes that should go
+// on traversing, and traversal stops once there are none.
+template <typename Visitor>
+static void TraverseInstances(const std::vector<LinearBVHNode>& nodes, const RayPacket& packet, exrU32 laneMask, Visitor visit)
+{
+    if (nodes.empty() || laneMask == 0)
+        return;
+
+    exrU32 firstLane = 0;
+    while ((laneMask & (1u << firstLane)) == 0)
+        firstLane++;
+
+    const exrBool isDirectionNegative[3] = { packet.m_Direction[0][firstLane] < 0,
+        packet.m_Direction[1][firstLane] < 0, packet.m_Direction[2][firstLane] < 0 };
+    exrU32 nodesToVisit[MaxInstanceStackSize];
+    exrU32 numNodesToVisit = 0;
+    exrU32 currentNode = 0;
+
+    while (true)
+    {
+        const LinearBVHNode& node = nodes[currentNode];
+
+        const exrU32 nodeMask = node.m_BoundingVolume.Intersect(packet, laneMask);
+        if (nodeMask != 0)
+        {
+            if (node.m_NumPrimitives > 0)
+            {
+                for (exrU32 i = 0; i < node.m_NumPrimitives; ++i)
+                {
+                    laneMask = visit(node.m_Offset + i, nodeMask & laneMask);
+                    if (laneMask == 0)
+                        return;
+                }
+            }
+            else
+            {
+                exrAssert(numNodesToVisit < MaxInstanceStackSize, "Instance BVH traversal stack overflow!");
+                if (isDirectionNegative[node.m_SplitAxis])
+                {
+                    nodesToVisit[numNodesToVisit++] = currentNode + 1;
+                    currentNode = node.m_Offset;
+                }
+                else
+                {
+                    nodesToVisit[numNodesToVisit++] = node.m_Offset;
+                    currentNode = currentNode + 1;
+                }
+
+                continue;
+            }
+        }
+
+        if (numNodesToVisit == 0)
+            break;
+
+        currentNode = nodesToVisit[--numNodesToVisit];
+    }
+}
+
+static exrBool IntersectInstance(const Scene::PrimitiveGroup& group, const Transform& transform, exrFloat scale,
+    const Ray& ray, SurfaceInteraction* interaction)
+{
+    // The object space ray is normalized again, so distances along it shrink by the scale
+    Ray objectRay = transform.GetInverseMatrix() * ray;
+    objectRay.m_TMax = ray.m_TMax / scale;
+
+    if (!group.m_Accelerator->Intersect(objectRay, interaction))
         return false;
 
+    ray.m_TMax = objectRay.m_TMax * scale;
+    interaction->m_Point = transform.GetMatrix() * interaction->m_Point;
+    interaction->m_Normal = (transform.GetMatrix() * interaction->m_Normal).Normalized();
+    interaction->m_Wo = -ray.m_Direction;
+    return true;
+}
+
+static exrBool HasIntersectInstance(const Scene::PrimitiveGroup& group, const Transform& transform, exrFloat scale, const Ray& ray)
+{
+    Ray objectRay = transform.GetInverseMatrix() * ray;
+    objectRay.m_TMax = ray.m_TMax / scale;
+    return group.m_Accelerator->HasIntersect(objectRay);
+}
+
+// Builds the object space packet of an instance. Rays are transformed one at a time, since the
+// transform is cheap compared to the traversal that the packet saves.
+static RayPacket ToObjectSpace(const Transform& transform, exrFloat scale, const RayPacket& packet, exrU32 laneMask)
+{
+    RayPacket objectPacket;
+
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+    {
+        if ((laneMask & (1u << lane)) == 0)
+            continue;
+
+        Ray objectRay = transform.GetInverseMatrix() * packet.GetRay(lane);
+        objectRay.m_TMax = packet.m_TMax[lane] / scale;
+        objectPacket.SetRay(lane, objectRay);
+    }
+
+    return objectPacket;
+}
+
+static exrU32 IntersectInstance(const Scene::PrimitiveGroup& group, const Transform& transform, exrFloat scale,
+    RayPacket& packet, exrU32 laneMask, SurfaceInteraction* interactions)
+{
+    RayPacket objectPacket = ToObjectSpace(transform, scale, packet, laneMask);
+    const exrU32 hitMask = group.m_Accelerator->Intersect(objectPacket, laneMask, interactions);
+
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+    {
+        if ((hitMask & (1u << lane)) == 0)
+            continue;
+
+        SurfaceInteraction* interaction = &interactions[lane];
+        packet.m_TMax[lane] = objectPacket.m_TMax[lane] * scale;
+        interaction->m_Point = transform.GetMatrix() * interaction->m_Point;
+        interaction->m_Normal = (transform.GetMatrix() * interaction->m_Normal).Normalized();
+        interaction->m_Wo = -packet.GetRay(lane).m_Direction;
+    }
+
+    return hitMask;
+}
+
+exrBool Scene::Intersect(const Ray& ray, SurfaceInteraction* interaction) const
+{
+    exrAssert(!m_SceneChanged, "Scene accelerator has not yet been initialized!");
     exrBool hasIntersect = false;
 
-    for (Primitive* pp : *possibleHits) 
+    // Every accelerator has to be tested since the closest hit may be in any of them.
+    // The ray's tmax carries over, so later groups only report closer hits.
+    if (m_Accelerator != nullptr && m_Accelerator->Intersect(ray, interaction))
+    {
+        hasIntersect = true;
+        interaction->m_AreaLight = nullptr;
+    }
+
+    TraverseInstances(m_InstanceNodes, ray, [&](exrU32 orderedIndex)
     {
-        // Ray's tmax will be automatically reduced so we don't have to worry about hitting
-        // occluded geometry
-        if (pp->Intersect(ray, interaction))
+        const GroupInstance& instance = m_GroupInstances[m_OrderedInstances[orderedIndex]];
+        const exrBool instanceHit = instance.m_Transform == nullptr
+            ? instance.m_Group->m_Accelerator->Intersect(ray, interaction)
+            : IntersectInstance(*instance.m_Group, *instance.m_Transform, instance.m_Scale, ray, interaction);
+
+        if (instanceHit && instance.m_Material != nullptr)
+            interaction->m_Material = instance.m_Material;
+
+        if (instanceHit)
         {
-            hasIntersect = true;
+            auto areaLight = instance.m_AreaLights.find(interaction->m_Shape);
+            interaction->m_AreaLight = areaLight != instance.m_AreaLights.end() ? areaLight->second : nullptr;
         }
-    }
+
+        hasIntersect |= instanceHit;
+        return false;
+    });
 
     return hasIntersect;
 }
 
 exrBool Scene::HasIntersect(const Ray& ray) const
 {
-    exrAssert(m_Accelerator, "Scene accelerator has not yet been initialized!");
-    const std::vector<Primitive*>* possibleHits = m_Accelerator->Intersect(ray);
+    exrAssert(!m_SceneChanged, "Scene accelerator has not yet been initialized!");
 
-    if (possibleHits == nullptr)
-        return false;
+    if (m_Accelerator != nullptr && m_Accelerator->HasIntersect(ray))
+        return true;
 
     exrBool hasIntersect = false;
+    TraverseInstances(m_InstanceNodes, ray, [&](exrU32 orderedIndex)
+    {
+        const GroupInstance& instance = m_GroupInstances[m_OrderedInstances[orderedIndex]];
+        hasIntersect = instance.m_Transform == nullptr
+            ? instance.m_Group->m_Accelerator->HasIntersect(ray)
+            : HasIntersectInstance(*instance.m_Group, *instance.m_Transform, instance.m_Scale, ray);
+
+        return hasIntersect;
+    });
+
+    return hasIntersect;
+}
+
+exrU32 Scene::Intersect(RayPacket& packet, exrU32 laneMask, SurfaceInteraction* interactions) const
+{
+    exrAssert(!m_SceneChanged, "Scene accelerator has not yet been initialized!");
+    exrU32 hitMask = 0;
 
-    for (Primitive* pp : *possibleHits) 
+    // The same as the single ray version, with the per hit fix ups done for every lane that hit
+    if (m_Accelerator != nullptr)
     {
-        // Ray's tmax will be automatically reduced so we don't have to worry about hitting
-        // occluded geometry
-        if (pp->HasIntersect(ray))
+        hitMask = m_Accelerator->Intersect(packet, laneMask, interactions);
+
+        for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
         {
-            hasIntersect = true;
+            if ((hitMask & (1u << lane)) != 0)
+                interactions[lane].m_AreaLight = nullptr;
         }
     }
 
-    return hasIntersect;
+    TraverseInstances(m_InstanceNodes, packet, laneMask, [&](exrU32 orderedIndex, exrU32 nodeMask)
+    {
+        const GroupInstance& instance = m_GroupInstances[m_OrderedInstances[orderedIndex]];
+        const exrU32 instanceHits = instance.m_Transform == nullptr
+            ? instance.m_Group->m_Accelerator->Intersect(packet, nodeMask, interactions)
+            : IntersectInstance(*instance.m_Group, *instance.m_Transform, instance.m_Scale, packet, nodeMask, interactions);
+
+        for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+        {
+            if ((instanceHits & (1u << lane)) == 0)
+                continue;
+
+            SurfaceInteraction* interaction = &interactions[lane];
+            if (instance.m_Material != nullptr)
+                interaction->m_Material = instance.m_Material;
+
+            auto areaLight = instance.m_AreaLights.find(interaction->m_Shape);
+            interaction->m_AreaLight = areaLight != instance.m_AreaLights.end() ? areaLight->second : nullptr;
+        }
+
+        hitMask |= instanceHits;
+        return laneMask;
+    });
+
+    return hitMask;
+}
+
+exrU32 Scene::HasIntersect(const RayPacket& packet, exrU32 laneMask) const
+{
+    exrAssert(!m_SceneChanged, "Scene accelerator has not yet been initialized!");
+    exrU32 hitMask = 0;
+
+    if (m_Accelerator != nullptr)
+        hitMask = m_Accelerator->HasIntersect(packet, laneMask);
+
+    // Rays drop out of the traversal once they hit something
+    TraverseInstances(m_InstanceNodes, packet, laneMask & ~hitMask, [&](exrU32 orderedIndex, exrU32 nodeMask)
+    {
+        const GroupInstance& instance = m_GroupInstances[m_OrderedInstances[orderedIndex]];
+        hitMask |= instance.m_Transform == nullptr
+            ? instance.m_Group->m_Accelerator->HasIntersect(packet, nodeMask)
+            : instance.m_Group->m_Accelerator->HasIntersect(ToObjectSpace(*instance.m_Transform, instance.m_Scale, packet, nodeMask), nodeMask);
+
+        return laneMask & ~hitMask;
+    });
+
+    return hitMask;
 }
 
 exrSpectrum Scene::SampleSkyLight(const Ray& ray) const
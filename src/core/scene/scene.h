@@ -23,10 +23,14 @@
 #include "core/elixir.h"
 #include "core/light/light.h"
 #include "core/primitive/primitive.h"
-#include "core/spatial/accelerator/accelerator.h"
+#include "core/spatial/accelerator/bvh.h"
+#include <unordered_map>
 
 exrBEGIN_NAMESPACE
 
+class AreaLight;
+class Mesh;
+
 //! @brief A scene object that owns a collection of primitives
 //! 
 //! A scene class that contains a collection of primitives and various helper functions
@@ -34,6 +38,18 @@ exrBEGIN_NAMESPACE
 class Scene
 {
 public:
+    //! @brief A collection of primitives with its own prebuilt accelerator
+    //!
+    //! A group can be shared by several instances, each placing the same geometry in the
+    //! scene with its own transform and material.
+    struct PrimitiveGroup
+    {
+        std::vector<std::unique_ptr<Primitive>> m_Primitives;
+        std::unique_ptr<Accelerator> m_Accelerator;
+
+        //! The mesh that the primitives are the faces of, in order. Null if the group is not a mesh.
+        std::shared_ptr<Mesh> m_Mesh;
+    };
 
     Scene(
         Accelerator::AcceleratorType accelType = Accelerator::AcceleratorType::ACCELERATORTYPE_BVH);
@@ -50,10 +66,33 @@ public:
     //! @param primitive        A pointer to the primitive
     void AddPrimitive(std::unique_ptr<Primitive> primitive);
 
+    //! @brief Adds a group of primitives along with an accelerator already built over them
+    //! 
+    //! This allows the accelerators of independent meshes to be built concurrently before
+    //! they are added to the scene. The primitives will not be part of the scene's own
+    //! accelerator, but will be tested alongside it.
+    //! 
+    //! @param primitives       The primitives that make up the group
+    //! @param accelerator      An accelerator that was built over the primitives
+    void AddPrimitiveGroup(std::vector<std::unique_ptr<Primitive>> primitives, std::unique_ptr<Accelerator> accelerator);
+
+    //! @brief Adds an instance of a primitive group to the scene
+    //! 
+    //! The group is intersected in its own object space, so its primitives and accelerator
+    //! are shared by all instances rather than copied. Only uniform scaling is supported.
+    //! 
+    //! Every primitive with an emissive material becomes an area light of the scene.
+    //! 
+    //! @param group            The group to instance
+    //! @param transform        The object to world transform of the instance, or null for identity
+    //! @param material         Overrides the material of the group's primitives, or null to keep them
+    void AddInstance(std::shared_ptr<const PrimitiveGroup> group, const Transform* transform = nullptr,
+        const Material* material = nullptr);
+
     //! @brief Adds a light to the scene
     //! 
     //! This function adds a light to the scene's light collection
-    //! Lights will be importance sampled
+    //! Lights will be importance sampled, and are preprocessed by InitAccelerator()
     //! 
     //! @param light            A pointer to the light
     void AddLight(std::unique_ptr<Light> light);
@@ -71,9 +110,12 @@ public:
     //! @brief Initializes the scene's accelerator if it has yet to be initialized or needs to be updated
     void InitAccelerator();
 
+    //! @brief Returns the world space bounds of all geometry in the scene, once the accelerator is initialized
+    AABB GetBoundingVolume() const;
+
     //! @brief Returns the number of primitive in the scene
     //! @return                 The number of primitives in the scene
-    inline exrU64 GetSceneSize() const { return static_cast<exrU64>(m_Primitives.size()); };
+    exrU64 GetSceneSize() const;
 
     //! @brief Test the accelerator for intersections with a ray
     //! 
@@ -96,6 +138,26 @@ public:
     //! 
     //! @return                 True if the there is an intersection
     exrBool HasIntersect(const Ray& ray) const;
+
+    //! @brief Test the scene geometry for intersections with the rays of a packet
+    //!
+    //! Outputs the surface intersection data of the closest hit of every ray into its lane of
+    //! <interactions>. The rays should be coherent, such as camera rays through the same pixel.
+    //!
+    //! @param packet           The rays to test against. The tmax of every ray that hits is reduced to its hit.
+    //! @param laneMask         The rays of the packet to test
+    //! @param interactions     Output structs that contain the interaction information, one per lane
+    //!
+    //! @return                 The lane mask of the rays that hit anything
+    exrU32 Intersect(RayPacket& packet, exrU32 laneMask, SurfaceInteraction* interactions) const;
+
+    //! @brief Test the scene geometry for intersections with the rays of a packet, ignoring surface data
+    //!
+    //! @param packet           The rays to test against, such as shadow rays towards the same light
+    //! @param laneMask         The rays of the packet to test
+    //!
+    //! @return                 The lane mask of the rays that are obstructed
+    exrU32 HasIntersect(const RayPacket& packet, exrU32 laneMask) const;
     
     //! @brief Return the skylight color for the given ray direction
     //!
@@ -113,8 +175,29 @@ public:
     exrBool m_SceneChanged = true;
 
 private:
+    //! A placement of a primitive group in the scene
+    struct GroupInstance
+    {
+        std::shared_ptr<const PrimitiveGroup> m_Group;
+
+        //! The object to world transform of the instance, or null for identity
+        std::unique_ptr<Transform> m_Transform;
+
+        //! The length of a unit vector after the object to world transform
+        exrFloat m_Scale;
+
+        //! The material to shade the instance with, or null to use the primitives' materials
+        const Material* m_Material;
+
+        //! The area lights of the emissive shapes of the instance
+        std::unordered_map<const Shape*, const AreaLight*> m_AreaLights;
+    };
+
     void AddLight(Light& light);
 
+    //! @brief Builds the top level BVH over the world bounds of the group instances
+    void BuildInstanceBVH();
+
 private:
     //! The type of accelerator to use
     Accelerator::AcceleratorType m_AcceleratorType;
@@ -128,6 +211,15 @@ private:
     //! A collection of pointers that points to primitives in the scene
     std::vector<std::unique_ptr<Primitive>> m_Primitives;
 
+    //! Groups of primitives that were added with their own accelerator
+    std::vector<GroupInstance> m_GroupInstances;
+
+    //! A BVH over the world bounds of the group instances, so that rays only visit the instances they may hit
+    std::vector<LinearBVHNode> m_InstanceNodes;
+
+    //! The indices of the group instances, in the order that the leaves of m_InstanceNodes refer to them
+    std::vector<exrU32> m_OrderedInstances;
+
     //! A collection of materials that primitives in this scene can use
     std::vector<std::unique_ptr<Material>> m_Materials;
 };
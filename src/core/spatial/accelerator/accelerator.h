@@ -21,6 +21,8 @@
 #pragma once
 
 #include "core/elixir.h"
+#include "core/ray/raypacket.h"
+#include "core/spatial/utils/aabb.h"
 
 exrBEGIN_NAMESPACE
 
@@ -35,16 +37,51 @@ public:
         ACCELERATORTYPE_KDTREE // Not implemented (maybe no point? BVH is much faster.)
     };
 
+    virtual ~Accelerator() = default;
+
     //! @brief Test the accelerator for intersections with a ray
     //! 
-    //! Test all accelerator nodes for intersections with ray, and output a
-    //! smaller set of primitives that the caller can manually test intersections
-    //! with.
+    //! Traverses the accelerator and tests the primitives it reaches, outputting the
+    //! surface interaction data of the closest hit in <interaction>. The ray's tmax is
+    //! reduced to the distance of the closest hit.
     //! 
     //! @param ray              The ray to test against.
-    //! @return                 The collection of objects that the ray could possibly
-    //!                         intersect with.
-    virtual const std::vector<Primitive*>* Intersect(const Ray& ray) const = 0;
+    //! @param interaction      Output struct that contains the interaction information
+    //! 
+    //! @return                 True if the ray hit any primitive
+    virtual exrBool Intersect(const Ray& ray, SurfaceInteraction* interaction) const = 0;
+
+    //! @brief Test the accelerator for intersections with a ray
+    //! 
+    //! Stops at the first intersection that is found without computing any surface data.
+    //! Useful for shadow rays.
+    //! 
+    //! @param ray              The ray to test against.
+    //! 
+    //! @return                 True if the ray hit any primitive
+    virtual exrBool HasIntersect(const Ray& ray) const = 0;
+
+    //! @brief Test the accelerator for intersections with the rays of a packet
+    //!
+    //! Outputs the surface interaction data of the closest hit of every ray into its lane of
+    //! <interactions>, and reduces the tmax of those rays to the distance of their closest hit.
+    //!
+    //! @param packet           The rays to test against
+    //! @param laneMask         The rays of the packet to test
+    //! @param interactions     Output structs that contain the interaction information, one per lane
+    //!
+    //! @return                 The lane mask of the rays that hit any primitive
+    virtual exrU32 Intersect(RayPacket& packet, exrU32 laneMask, SurfaceInteraction* interactions) const = 0;
+
+    //! @brief Test the accelerator for intersections with the rays of a packet
+    //!
+    //! Stops testing a ray at its first intersection, and the packet once all rays have one.
+    //!
+    //! @return                 The lane mask of the rays that hit any primitive
+    virtual exrU32 HasIntersect(const RayPacket& packet, exrU32 laneMask) const = 0;
+
+    //! @brief Returns a bounding volume that contains everything in the accelerator
+    virtual AABB GetBoundingVolume() const = 0;
 };
 
 exrEND_NAMESPACE
\ No newline at end of file
@@ -28,60 +28,329 @@ static constexpr exrU16 MaxPrimitivesPerNode = 4;
 //! Maximum depth of BVH tree
 static constexpr exrU16 MaxNodeDepth = 32;
 
+//! The maximum number of nodes that traversal may have to come back to
+static constexpr exrU32 MaxTraversalStackSize = 2 * MaxNodeDepth + 2;
+
+//! Nodes with at least this many primitives are split in parallel
+static constexpr exrU64 ParallelSplitThreshold = 4096;
+
 BVHAccelerator::BVHAccelerator(const std::vector<Primitive*>& objects, const SplitMethod splitMethod)
 {
     exrProfile("Building BVH Accelerator");
 
-    const auto numObjects = objects.size();
+    // An empty BVH has no nodes at all, since a leaf without primitives would read as an interior node
+    if (objects.empty())
+        return;
 
     // Create root node
-    m_RootNode = std::make_unique<BVHNode>();
-    m_RootNode->m_Primitives = objects;
+    std::unique_ptr<BVHNode> rootNode = std::make_unique<BVHNode>();
+    rootNode->m_Primitives = objects;
 
     switch (splitMethod)
     {
     case BVHAccelerator::SplitMethod::SAH:
-        m_RootNode->m_BoundingVolume = AABB::BoundPrimitives(objects);
-        SAHSplit(*m_RootNode, MaxNodeDepth);
+        rootNode->m_BoundingVolume = AABB::BoundPrimitives(objects);
+        SAHSplit(*rootNode, MaxNodeDepth);
         break;
     case BVHAccelerator::SplitMethod::EqualCounts:
-        EqualCountSplit(*m_RootNode, MaxNodeDepth);
+        EqualCountSplit(*rootNode, MaxNodeDepth);
         break;
     default:
         throw "Selected split method is not implemented!";
         break;
     }
 
+    m_OrderedPrimitives.reserve(objects.size());
+    FlattenNode(*rootNode);
+
+    m_Nodes = m_NodeStorage.data();
+    m_NumNodes = static_cast<exrU32>(m_NodeStorage.size());
+
     exrEndProfile();
 }
 
-const std::vector<Primitive*>* BVHAccelerator::Intersect(const Ray& ray) const
+BVHAccelerator::BVHAccelerator(const LinearBVHNode* nodes, exrU32 numNodes, std::vector<Primitive*> primitives)
+    : m_Nodes(nodes)
+    , m_NumNodes(numNodes)
+    , m_OrderedPrimitives(std::move(primitives)) {}
+
+exrBool BVHAccelerator::IsValidTree(const LinearBVHNode* nodes, exrU32 numNodes, exrU64 numPrimitives)
+{
+    if (numNodes == 0)
+        return true;
+
+    // Walk the tree in the order it was flattened in. Every node has to come up exactly when it
+    // is expected, which rules out shared subtrees and nodes that are never reached. Limiting
+    // the depth limits the number of nodes that traversal has to come back to.
+    std::vector<std::pair<exrU32, exrU32>> nodesToVisit = { { 0, 0 } };
+    exrU32 expectedNode = 0;
+
+    while (!nodesToVisit.empty())
+    {
+        const exrU32 index = nodesToVisit.back().first;
+        const exrU32 depth = nodesToVisit.back().second;
+        nodesToVisit.pop_back();
+
+        if (index != expectedNode++ || depth > MaxNodeDepth)
+            return false;
+
+        const LinearBVHNode& node = nodes[index];
+        if (node.m_NumPrimitives > 0)
+        {
+            if (exrU64(node.m_Offset) + node.m_NumPrimitives > numPrimitives)
+                return false;
+
+            continue;
+        }
+
+        if (node.m_Offset <= index + 1 || node.m_Offset >= numNodes || index + 1 >= numNodes || node.m_SplitAxis >= 3)
+            return false;
+
+        nodesToVisit.push_back({ node.m_Offset, depth + 1 });
+        nodesToVisit.push_back({ index + 1, depth + 1 });
+    }
+
+    return expectedNode == numNodes;
+}
+
+exrU32 BVHAccelerator::FlattenNode(const BVHNode& node)
 {
-    return TraverseNode(*m_RootNode, ray);
+    const exrU32 index = static_cast<exrU32>(m_NodeStorage.size());
+    m_NodeStorage.push_back({ node.m_BoundingVolume, 0, 0, node.m_SplitAxis });
+
+    if (node.m_LeftSubtree == nullptr || node.m_RightSubtree == nullptr)
+    {
+        exrAssert(!node.m_Primitives.empty(), "BVH leaves must contain at least one primitive!");
+        m_NodeStorage[index].m_Offset = static_cast<exrU32>(m_OrderedPrimitives.size());
+        m_NodeStorage[index].m_NumPrimitives = static_cast<exrU32>(node.m_Primitives.size());
+        m_OrderedPrimitives.insert(m_OrderedPrimitives.end(), node.m_Primitives.begin(), node.m_Primitives.end());
+        return index;
+    }
+
+    // The first child is implicitly the next node
+    FlattenNode(*node.m_LeftSubtree);
+    const exrU32 secondChild = FlattenNode(*node.m_RightSubtree);
+    m_NodeStorage[index].m_Offset = secondChild;
+    return index;
+}
+
+exrBool BVHAccelerator::Intersect(const Ray& ray, SurfaceInteraction* interaction) const
+{
+    if (m_NumNodes == 0)
+        return false;
+
+    const LinearBVHNode* nodes = m_NodeReplicas.Get(m_Nodes, m_NumNodes);
+    Primitive* const* primitives = m_PrimitiveReplicas.Get(m_OrderedPrimitives.data(), m_OrderedPrimitives.size());
+
+    const exrBool isDirectionNegative[3] = { ray.m_Direction.x < 0, ray.m_Direction.y < 0, ray.m_Direction.z < 0 };
+    exrU32 nodesToVisit[MaxTraversalStackSize];
+    exrU32 numNodesToVisit = 0;
+    exrU32 currentNode = 0;
+    exrBool hasIntersect = false;
+
+    while (true)
+    {
+        const LinearBVHNode& node = nodes[currentNode];
+
+        if (node.m_BoundingVolume.Intersect(ray))
+        {
+            if (node.m_NumPrimitives > 0)
+            {
+                // Ray's tmax will be automatically reduced so we don't have to worry about hitting
+                // occluded geometry
+                for (exrU32 i = 0; i < node.m_NumPrimitives; ++i)
+                {
+                    if (primitives[node.m_Offset + i]->Intersect(ray, interaction))
+                        hasIntersect = true;
+                }
+            }
+            else
+            {
+                // Visit the near child first, so that the reduced tmax can cull the far one
+                exrAssert(numNodesToVisit < MaxTraversalStackSize, "BVH traversal stack overflow!");
+                if (isDirectionNegative[node.m_SplitAxis])
+                {
+                    nodesToVisit[numNodesToVisit++] = currentNode + 1;
+                    currentNode = node.m_Offset;
+                }
+                else
+                {
+                    nodesToVisit[numNodesToVisit++] = node.m_Offset;
+                    currentNode = currentNode + 1;
+                }
+
+                continue;
+            }
+        }
+
+        if (numNodesToVisit == 0)
+            break;
+
+        currentNode = nodesToVisit[--numNodesToVisit];
+    }
+
+    return hasIntersect;
 }
 
-const std::vector<Primitive*>* BVHAccelerator::TraverseNode(const BVHNode& node, const Ray& ray)
+exrBool BVHAccelerator::HasIntersect(const Ray& ray) const
 {
-    // If intersect bounding volume
-    if (node.m_BoundingVolume.Intersect(ray))
+    if (m_NumNodes == 0)
+        return false;
+
+    const LinearBVHNode* nodes = m_NodeReplicas.Get(m_Nodes, m_NumNodes);
+    Primitive* const* primitives = m_PrimitiveReplicas.Get(m_OrderedPrimitives.data(), m_OrderedPrimitives.size());
+
+    exrU32 nodesToVisit[MaxTraversalStackSize];
+    exrU32 numNodesToVisit = 0;
+    exrU32 currentNode = 0;
+
+    while (true)
     {
-        // reached the end of tree, return hit with primitive
-        if (node.m_LeftSubtree == nullptr || node.m_RightSubtree == nullptr)
-            return &node.m_Primitives;
-
-        const std::vector<Primitive*>* left = TraverseNode(*node.m_LeftSubtree, ray);
-        const std::vector<Primitive*>* right = TraverseNode(*node.m_RightSubtree, ray);
-
-        if (left == nullptr)
-            return right;
-        if (right == nullptr)
-            return left;
-        
-        return &node.m_Primitives; // both is not empty so return parent collection
+        const LinearBVHNode& node = nodes[currentNode];
+
+        if (node.m_BoundingVolume.Intersect(ray))
+        {
+            if (node.m_NumPrimitives > 0)
+            {
+                for (exrU32 i = 0; i < node.m_NumPrimitives; ++i)
+                {
+                    if (primitives[node.m_Offset + i]->HasIntersect(ray))
+                        return true;
+                }
+            }
+            else
+            {
+                exrAssert(numNodesToVisit < MaxTraversalStackSize, "BVH traversal stack overflow!");
+                nodesToVisit[numNodesToVisit++] = node.m_Offset;
+                currentNode = currentNode + 1;
+                continue;
+            }
+        }
+
+        if (numNodesToVisit == 0)
+            break;
+
+        currentNode = nodesToVisit[--numNodesToVisit];
     }
 
-    // Did not intersect with parent, so return an empty collection
-    return nullptr;
+    return false;
+}
+
+exrU32 BVHAccelerator::Intersect(RayPacket& packet, exrU32 laneMask, SurfaceInteraction* interactions) const
+{
+    if (m_NumNodes == 0 || laneMask == 0)
+        return 0;
+
+    const LinearBVHNode* nodes = m_NodeReplicas.Get(m_Nodes, m_NumNodes);
+    Primitive* const* primitives = m_PrimitiveReplicas.Get(m_OrderedPrimitives.data(), m_OrderedPrimitives.size());
+
+    // Children are visited in the order that suits the first ray, which the other rays of a
+    // coherent packet agree with
+    exrU32 firstLane = 0;
+    while ((laneMask & (1u << firstLane)) == 0)
+        firstLane++;
+
+    const exrBool isDirectionNegative[3] = { packet.m_Direction[0][firstLane] < 0,
+        packet.m_Direction[1][firstLane] < 0, packet.m_Direction[2][firstLane] < 0 };
+    exrU32 nodesToVisit[MaxTraversalStackSize];
+    exrU32 numNodesToVisit = 0;
+    exrU32 currentNode = 0;
+    exrU32 hitMask = 0;
+
+    while (true)
+    {
+        const LinearBVHNode& node = nodes[currentNode];
+
+        // Only the rays that enter a node are tested against what it contains
+        const exrU32 nodeMask = node.m_BoundingVolume.Intersect(packet, laneMask);
+        if (nodeMask != 0)
+        {
+            if (node.m_NumPrimitives > 0)
+            {
+                for (exrU32 i = 0; i < node.m_NumPrimitives; ++i)
+                    hitMask |= primitives[node.m_Offset + i]->Intersect(packet, nodeMask, interactions);
+            }
+            else
+            {
+                exrAssert(numNodesToVisit < MaxTraversalStackSize, "BVH traversal stack overflow!");
+                if (isDirectionNegative[node.m_SplitAxis])
+                {
+                    nodesToVisit[numNodesToVisit++] = currentNode + 1;
+                    currentNode = node.m_Offset;
+                }
+                else
+                {
+                    nodesToVisit[numNodesToVisit++] = node.m_Offset;
+                    currentNode = currentNode + 1;
+                }
+
+                continue;
+            }
+        }
+
+        if (numNodesToVisit == 0)
+            break;
+
+        currentNode = nodesToVisit[--numNodesToVisit];
+    }
+
+    return hitMask;
+}
+
+exrU32 BVHAccelerator::HasIntersect(const RayPacket& packet, exrU32 laneMask) const
+{
+    if (m_NumNodes == 0 || laneMask == 0)
+        return 0;
+
+    const LinearBVHNode* nodes = m_NodeReplicas.Get(m_Nodes, m_NumNodes);
+    Primitive* const* primitives = m_PrimitiveReplicas.Get(m_OrderedPrimitives.data(), m_OrderedPrimitives.size());
+
+    exrU32 nodesToVisit[MaxTraversalStackSize];
+    exrU32 numNodesToVisit = 0;
+    exrU32 currentNode = 0;
+    exrU32 hitMask = 0;
+
+    while (true)
+    {
+        const LinearBVHNode& node = nodes[currentNode];
+
+        // Rays drop out of the packet once they hit something
+        const exrU32 nodeMask = node.m_BoundingVolume.Intersect(packet, laneMask & ~hitMask);
+        if (nodeMask != 0)
+        {
+            if (node.m_NumPrimitives > 0)
+            {
+                for (exrU32 i = 0; i < node.m_NumPrimitives; ++i)
+                {
+                    hitMask |= primitives[node.m_Offset + i]->HasIntersect(packet, nodeMask & ~hitMask);
+                    if (hitMask == laneMask)
+                        return hitMask;
+                }
+            }
+            else
+            {
+                exrAssert(numNodesToVisit < MaxTraversalStackSize, "BVH traversal stack overflow!");
+                nodesToVisit[numNodesToVisit++] = node.m_Offset;
+                currentNode = currentNode + 1;
+                continue;
+            }
+        }
+
+        if (numNodesToVisit == 0)
+            break;
+
+        currentNode = nodesToVisit[--numNodesToVisit];
+    }
+
+    return hitMask;
+}
+
+AABB BVHAccelerator::GetBoundingVolume() const
+{
+    if (m_NumNodes == 0)
+        return AABB(exrPoint3::Zero(), exrPoint3::Zero());
+
+    return m_Nodes[0].m_BoundingVolume;
 }
 
 void BVHAccelerator::EqualCountSplit(BVHNode& currentRoot, exrU16 depth)
@@ -97,7 +366,8 @@ void BVHAccelerator::EqualCountSplit(BVHNode& currentRoot, exrU16 depth)
     std::vector<Primitive*> temp = currentRoot.m_Primitives;
 
     // Get a random axis to split objects
-    switch (exrU32(Random::UniformUInt32(2)))
+    currentRoot.m_SplitAxis = exrU32(Random::UniformUInt32(2));
+    switch (currentRoot.m_SplitAxis)
     {
     case 0:
         // Split along x axis
@@ -139,80 +409,78 @@ void BVHAccelerator::SAHSplit(BVHNode& currentRoot, exrU16 depth)
         return;
 
     const exrU32 splitsPerAxis = 32;
-    exrFloat bestHeuristics = MaxFloat;
-    exrBool hasSplit = false;
+    const exrU32 numCandidates = 3 * splitsPerAxis;
 
-    // for each axis
-    for (exrU32 axis = 0; axis < 3; ++axis)
+    // Partitions the primitives by the i-th split value along an axis
+    auto partition = [&](exrU32 candidate, std::vector<Primitive*>& leftObjects, std::vector<Primitive*>& rightObjects)
     {
-        for (exrU32 i = 0; i < splitsPerAxis; ++i)
-        {
-            exrFloat splitValue = exrFloat(i) / exrFloat(splitsPerAxis);
+        const exrU32 axis = candidate / splitsPerAxis;
+        exrFloat splitValue = exrFloat(candidate % splitsPerAxis) / exrFloat(splitsPerAxis);
 
-            std::vector<Primitive*> leftObjects, rightObjects;
-
-            for (exrU32 n = 0; n < numObjects; ++n)
+        for (exrU32 n = 0; n < numObjects; ++n)
+        {
+            if ((currentRoot.m_Primitives[n]->GetBoundingVolume().Min()[axis] - 
+                currentRoot.m_BoundingVolume.Min()[axis]) / currentRoot.m_BoundingVolume.GetExtents()[axis] < splitValue)
             {
-                if ((currentRoot.m_Primitives[n]->GetBoundingVolume().Min()[axis] - 
-                    currentRoot.m_BoundingVolume.Min()[axis]) / currentRoot.m_BoundingVolume.GetExtents()[axis] < splitValue)
-                {
-                    leftObjects.push_back(currentRoot.m_Primitives[n]);
-                }
-                else
-                {
-                    rightObjects.push_back(currentRoot.m_Primitives[n]);
-                }
+                leftObjects.push_back(currentRoot.m_Primitives[n]);
             }
-
-            // if all objects already on left side, no need to continue testing bigger split values
-            if (leftObjects.size() == numObjects)
+            else
             {
-                break;
+                rightObjects.push_back(currentRoot.m_Primitives[n]);
             }
+        }
+    };
 
-            AABB leftBv = AABB::BoundPrimitives(leftObjects);
-            AABB rightBv = AABB::BoundPrimitives(rightObjects);
+    // Score every candidate split independently, so that large nodes can do so in parallel
+    std::vector<exrFloat> candidateHeuristics(numCandidates, MaxFloat);
+    ParallelFor(0, numCandidates, numObjects >= ParallelSplitThreshold ? 1 : numCandidates, [&](exrU64 candidate)
+    {
+        std::vector<Primitive*> leftObjects, rightObjects;
+        partition(exrU32(candidate), leftObjects, rightObjects);
 
-            // Get score
-            exrFloat sc = currentRoot.m_BoundingVolume.GetSurfaceArea();
-            exrFloat aa = leftBv.GetSurfaceArea();
-            exrFloat ab = rightBv.GetSurfaceArea();
-            exrFloat pa = aa / sc;         // Probably of hitting A if hit parent
-            exrFloat pb = ab / sc;        // Probably of hitting B if hit parent
+        // if all objects already on left side, bigger split values along this axis will not be better either
+        if (leftObjects.size() == numObjects)
+            return;
 
-            auto ia = leftObjects.size();                       // Cost of intersection test on A (we assume all primitives are the same cost, like PBRT)
-            auto ib = rightObjects.size();                      // Cost of intersection test on B (we assume all primitives are the same cost, like PBRT)
+        AABB leftBv = AABB::BoundPrimitives(leftObjects);
+        AABB rightBv = AABB::BoundPrimitives(rightObjects);
 
-            exrFloat heuristics = 1 /*Ttrav*/ + pa * ia + pb * ib;
+        // Get score
+        exrFloat sc = currentRoot.m_BoundingVolume.GetSurfaceArea();
+        exrFloat aa = leftBv.GetSurfaceArea();
+        exrFloat ab = rightBv.GetSurfaceArea();
+        exrFloat pa = aa / sc;         // Probably of hitting A if hit parent
+        exrFloat pb = ab / sc;        // Probably of hitting B if hit parent
 
-            // Determine if doing a split is worth it
-            // A split is not worth it if it doesn't yield a lower cost than the parent
-            if (1 + aa * ia + ab * ib >= sc * numObjects)
-                continue;
+        auto ia = leftObjects.size();                       // Cost of intersection test on A (we assume all primitives are the same cost, like PBRT)
+        auto ib = rightObjects.size();                      // Cost of intersection test on B (we assume all primitives are the same cost, like PBRT)
 
-            if (heuristics < bestHeuristics)
-            {
-                hasSplit = true;
-
-                if (currentRoot.m_LeftSubtree == nullptr)
-                    currentRoot.m_LeftSubtree = std::make_unique<BVHNode>();
-                if (currentRoot.m_RightSubtree == nullptr)
-                    currentRoot.m_RightSubtree = std::make_unique<BVHNode>();
-
-                bestHeuristics = heuristics;
-                currentRoot.m_LeftSubtree->m_Primitives = leftObjects;
-                currentRoot.m_LeftSubtree->m_BoundingVolume = leftBv;
-                currentRoot.m_RightSubtree->m_Primitives = rightObjects;
-                currentRoot.m_RightSubtree->m_BoundingVolume = rightBv;
-            }
-        }
-    }
+        // Determine if doing a split is worth it
+        // A split is not worth it if it doesn't yield a lower cost than the parent
+        if (1 + aa * ia + ab * ib >= sc * numObjects)
+            return;
+
+        candidateHeuristics[candidate] = 1 /*Ttrav*/ + pa * ia + pb * ib;
+    });
 
-    if (!hasSplit)
+    // Pick the first of the best candidates, so that the tree does not depend on scheduling
+    const exrU32 bestCandidate = exrU32(std::min_element(candidateHeuristics.begin(), candidateHeuristics.end()) - candidateHeuristics.begin());
+    if (candidateHeuristics[bestCandidate] >= MaxFloat)
         return;
 
-    SAHSplit(*currentRoot.m_LeftSubtree, depth - 1);
-    SAHSplit(*currentRoot.m_RightSubtree, depth - 1);
+    currentRoot.m_SplitAxis = bestCandidate / splitsPerAxis;
+    currentRoot.m_LeftSubtree = std::make_unique<BVHNode>();
+    currentRoot.m_RightSubtree = std::make_unique<BVHNode>();
+    partition(bestCandidate, currentRoot.m_LeftSubtree->m_Primitives, currentRoot.m_RightSubtree->m_Primitives);
+    currentRoot.m_LeftSubtree->m_BoundingVolume = AABB::BoundPrimitives(currentRoot.m_LeftSubtree->m_Primitives);
+    currentRoot.m_RightSubtree->m_BoundingVolume = AABB::BoundPrimitives(currentRoot.m_RightSubtree->m_Primitives);
+
+    // The subtrees are independent, so build them in parallel until they get small
+    BVHNode* subtrees[2] = { currentRoot.m_LeftSubtree.get(), currentRoot.m_RightSubtree.get() };
+    ParallelFor(0, 2, numObjects >= ParallelSplitThreshold ? 1 : 2, [&](exrU64 i)
+    {
+        SAHSplit(*subtrees[i], depth - 1);
+    });
 }
 
 exrEND_NAMESPACE
\ No newline at end of file
@@ -22,20 +22,41 @@
 
 #include "accelerator.h"
 #include "core/spatial/utils/aabb.h"
+#include "system/memory/numareplicatedarray.h"
 
 exrBEGIN_NAMESPACE
 
 class Material;
 class Primitive;
 
+//! @brief A node of a BVH that has been flattened into an array
+//!
+//! The nodes are stored in depth first order, so the first child of an interior node always
+//! directly follows it. Nodes contain no pointers and can be written to disk as they are.
+struct LinearBVHNode
+{
+    //! A bounding volume that contains all the objects below this node
+    AABB m_BoundingVolume;
+
+    //! For leaves, the index of the first primitive. For interior nodes, the index of the second child.
+    exrU32 m_Offset;
+
+    //! The number of primitives in a leaf. Zero for interior nodes.
+    exrU32 m_NumPrimitives;
+
+    //! The axis that the children of an interior node were split along
+    exrU32 m_SplitAxis;
+};
+
 //! @brief Defines a bounding volume hierarchy
 //!
 //! A bounding volume hierarchy that recursively subdivides a list of objects into subgroups
-//! that can accelerate ray tracing through a large collection of objects
+//! that can accelerate ray tracing through a large collection of objects. The hierarchy is
+//! built as a tree and then flattened into an array of nodes for traversal.
 class BVHAccelerator : public Accelerator
 {
 public:
-    //! @brief A single BVH Node
+    //! @brief A single BVH Node, only used while building
     struct BVHNode
     {
         //! The list of primitives that this node contains
@@ -49,6 +70,9 @@ public:
 
         //! A pointer to the right subtree of the BVH. Will be null if this is a leaf node.
         std::unique_ptr<BVHNode> m_RightSubtree = nullptr;
+
+        //! The axis that the primitives were split along
+        exrU32 m_SplitAxis = 0;
     };
 
     //! Split Types
@@ -60,18 +84,47 @@ public:
     //! @param splitMethod      Splitting algorithm to use when building the BVH
     BVHAccelerator(const std::vector<Primitive*>& objects, const SplitMethod splitMethod = SplitMethod::SAH);
 
+    //! @brief Constructs a BVH from nodes that have already been built and flattened
+    //! @param nodes            The flattened nodes. They are not copied and must outlive the BVH.
+    //! @param numNodes         The number of nodes
+    //! @param primitives       The primitives, in the order that the leaves refer to them
+    BVHAccelerator(const LinearBVHNode* nodes, exrU32 numNodes, std::vector<Primitive*> primitives);
+
 public:
-    const std::vector<Primitive*>* Intersect(const Ray& ray) const override;
+    exrBool Intersect(const Ray& ray, SurfaceInteraction* interaction) const override;
+    exrBool HasIntersect(const Ray& ray) const override;
+    exrU32 Intersect(RayPacket& packet, exrU32 laneMask, SurfaceInteraction* interactions) const override;
+    exrU32 HasIntersect(const RayPacket& packet, exrU32 laneMask) const override;
+    AABB GetBoundingVolume() const override;
+
+    //! @brief Checks that flattened nodes from an untrusted source form a BVH that is safe to traverse
+    //!
+    //! The nodes must form a single tree in depth first order that is no deeper than the BVHs
+    //! that are built, and every leaf must refer to primitives that exist.
+    //!
+    //! @param nodes            The flattened nodes
+    //! @param numNodes         The number of nodes
+    //! @param numPrimitives    The number of primitives that the leaves may refer to
+    //!
+    //! @return                 True if the nodes can be passed to the constructor
+    static exrBool IsValidTree(const LinearBVHNode* nodes, exrU32 numNodes, exrU64 numPrimitives);
+
+    //! @brief Returns the flattened nodes of the BVH
+    inline const LinearBVHNode* GetNodes() const { return m_Nodes; }
+
+    //! @brief Returns the number of flattened nodes
+    inline exrU32 GetNumNodes() const { return m_NumNodes; }
+
+    //! @brief Returns the primitives in the order that the leaves refer to them
+    inline const std::vector<Primitive*>& GetOrderedPrimitives() const { return m_OrderedPrimitives; }
 
 private:
-    //! @brief A recursive function to recursively traverse nodes and check for intersection.
+    //! @brief Recursively appends a subtree to the flattened nodes in depth first order
     //!
-    //! @param node             The node to traverse down from.
-    //! @param ray              The ray to test against.
+    //! @param node             The root of the subtree to flatten
     //!
-    //! @return                 A collection of primitives that may pass intersection test
-    //!                         against the input ray.
-    static const std::vector<Primitive*>* TraverseNode(const BVHNode& node, const Ray& ray);
+    //! @return                 The index of the flattened node
+    exrU32 FlattenNode(const BVHNode& node);
 
     //! @brief Recursively splits objects into equal subtrees
     //! 
@@ -90,8 +143,19 @@ private:
     static void SAHSplit(BVHNode& currentRoot, exrU16 depth);
 
 private:
-    //! The root node of the BVH
-    std::unique_ptr<BVHNode> m_RootNode = nullptr;
+    //! The flattened nodes, which either point into m_NodeStorage or into memory owned by someone else
+    const LinearBVHNode* m_Nodes = nullptr;
+    exrU32 m_NumNodes = 0;
+
+    //! The flattened nodes when the BVH was built rather than loaded
+    std::vector<LinearBVHNode> m_NodeStorage;
+
+    //! The primitives of all leaves, stored contiguously per leaf
+    std::vector<Primitive*> m_OrderedPrimitives;
+
+    //! Copies of the nodes and primitives for threads on other NUMA nodes
+    NumaReplicatedArray<LinearBVHNode> m_NodeReplicas;
+    NumaReplicatedArray<Primitive*> m_PrimitiveReplicas;
 };
 
 exrEND_NAMESPACE
\ No newline at end of file
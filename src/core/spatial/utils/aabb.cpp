@@ -56,6 +56,44 @@ exrBool AABB::Intersect(const Ray& r) const
     return true;
 }
 
+exrU32 AABB::Intersect(const RayPacket& packet, exrU32 laneMask) const
+{
+    // The same slab test as above, one axis at a time for all lanes and without early outs, so
+    // that the loops compile to vector instructions
+    exrFloat tMin[RayPacketSize];
+    exrFloat tMax[RayPacketSize];
+
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+    {
+        tMin[lane] = EXR_EPSILON;
+        tMax[lane] = packet.m_TMax[lane];
+    }
+
+    for (exrU32 i = 0; i < 3; ++i)
+    {
+        const exrFloat min = m_Min[i];
+        const exrFloat max = m_Max[i];
+
+        exrPacketLoop
+        for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+        {
+            const exrFloat invD = packet.m_InvDirection[i][lane];
+            const exrFloat t0 = (min - packet.m_Origin[i][lane]) * invD;
+            const exrFloat t1 = (max - packet.m_Origin[i][lane]) * invD;
+            const exrFloat tNear = invD < 0.0f ? t1 : t0;
+            const exrFloat tFar = invD < 0.0f ? t0 : t1;
+            tMin[lane] = tNear > tMin[lane] ? tNear : tMin[lane];
+            tMax[lane] = tFar < tMax[lane] ? tFar : tMax[lane];
+        }
+    }
+
+    exrU32 hitMask = 0;
+    for (exrU32 lane = 0; lane < RayPacketSize; ++lane)
+        hitMask |= exrU32(tMax[lane] > tMin[lane]) << lane;
+
+    return hitMask & laneMask;
+}
+
 AABB AABB::Union(const AABB& bv1, const AABB& bv2)
 {
     exrFloat minX, minY, minZ;
@@ -80,14 +118,11 @@ AABB AABB::BoundPrimitives(const std::vector<Primitive*>& primitives)
         return AABB(exrPoint3::Zero(), exrPoint3::Zero());
     }
 
-    AABB combinedBv = primitives[0]->GetBoundingVolume();
-
-    for (exrU32 i = 1; i < primitives.size(); ++i)
-    {
-        combinedBv = Union(combinedBv, primitives[i]->GetBoundingVolume());
-    }
-
-    return combinedBv;
+    // Bounding a primitive can be expensive (displaced patches and paged out meshes), so large
+    // lists are bounded in parallel chunks
+    return ParallelReduce(1, primitives.size(), 16384, primitives[0]->GetBoundingVolume(),
+        [&](exrU64 i, AABB& combinedBv) { combinedBv = Union(combinedBv, primitives[i]->GetBoundingVolume()); },
+        [](const AABB& a, const AABB& b) { return Union(a, b); });
 }
 
 exrEND_NAMESPACE
\ No newline at end of file
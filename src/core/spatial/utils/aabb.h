@@ -21,6 +21,7 @@
 #pragma once
 
 #include "core/elixir.h"
+#include "core/ray/raypacket.h"
 
 exrBEGIN_NAMESPACE
 
@@ -80,6 +81,14 @@ public:
     //! @return                 True if the there is an intersection
     exrBool Intersect(const Ray& ray) const;
 
+    //! @brief Test the bounding volume for intersections with the rays of a packet
+    //!
+    //! @param packet           The rays to test against
+    //! @param laneMask         The rays of the packet to test
+    //!
+    //! @return                 The lane mask of the rays that intersect
+    exrU32 Intersect(const RayPacket& packet, exrU32 laneMask) const;
+
 public:
     //! @brief Combines two bounding volumes
     //!
@@ -72,6 +72,18 @@ inline _Type1 exrLerp(_Type1 a, _Type1 b, _Type2 t)
     return ((static_cast<_Type2>(1) - t) * a + t * b);
 }
 
+//! @brief sqrt() that treats small negative values from rounding errors as 0
+inline exrFloat exrSafeSqrt(exrFloat x)
+{
+    return sqrt(exrMax(x, 0.0f));
+}
+
+//! @brief acos() that clamps values slightly outside of [-1, 1] from rounding errors
+inline exrFloat exrSafeACos(exrFloat x)
+{
+    return acos(exrClamp(x, -1.0f, 1.0f));
+}
+
 inline exrBool exrQuadratic(exrFloat a, exrFloat b, exrFloat c, exrFloat* t0, exrFloat* t1)
 {
     exrFloat discriminator = b * b - 4 * a * c;
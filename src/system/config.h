@@ -0,0 +1,35 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+    DO NOT EDIT: This is a CMake auto generated file
+    CMake configurations can be defined here, but all other changes may be lost!
+*/
+
+#pragma once
+
+#define EXR_PLATFORM_NAME				"Linux"
+/* #undef EXR_PLATFORM_WIN */
+/* #undef EXR_PLATFORM_MAC */
+#define EXR_PLATFORM_LINUX
+#define EXR_USE_NAMESPACE
+/* #undef EXR_HAVE_ALIGNED_MALLOC */
+#define EXR_HAVE_POSIX_MEMALIGN
+/* #undef EXR_HAVE_MEMALIGN */
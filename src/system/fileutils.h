@@ -18,10 +18,16 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include "random.h"
+
+#pragma once
 
 exrBEGIN_NAMESPACE
 
-std::mt19937 Random::m_Rng;
+//! @brief Returns true if the file name ends with the extension, such as ".scene", and has a name before it
+inline exrBool HasExtension(const exrString& filename, const exrString& extension)
+{
+    return filename.size() > extension.size() &&
+        filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
 
-exrEND_NAMESPACE
\ No newline at end of file
+exrEND_NAMESPACE
@@ -0,0 +1,167 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+exrBEGIN_NAMESPACE
+
+//! @brief A thread-safe, cost-bounded least-recently-used cache
+//!
+//! Entries are shared pointers so that a caller can keep using a value after it has been
+//! evicted. The cache is split into shards with their own lock and a share of the budget,
+//! which keeps render threads from serializing on a single mutex.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LRUCache
+{
+public:
+    struct Statistics
+    {
+        exrU64 m_Hits = 0;
+        exrU64 m_Misses = 0;
+        exrU64 m_Evictions = 0;
+        exrU64 m_ResidentCost = 0;
+        exrU64 m_PeakResidentCost = 0;
+    };
+
+    //! @brief Constructs a cache given a total budget (in the same unit as the entry costs)
+    //! @param budget           The maximum total cost of all resident entries
+    //! @param numShards        The number of independently locked partitions
+    LRUCache(exrU64 budget, exrU32 numShards = 16)
+        : m_NumShards(exrMax(numShards, 1u))
+        , m_ShardBudget(exrMax(budget / exrMax(numShards, 1u), exrU64(1)))
+        , m_Shards(std::make_unique<Shard[]>(exrMax(numShards, 1u))) {};
+
+    //! @brief Returns the entry for key, invoking loader on a miss
+    //!
+    //! The loader is called without holding any lock and must have the signature
+    //! std::shared_ptr<Value>(exrU64& cost). If two threads miss on the same key at once,
+    //! the first value to be inserted wins and the other is discarded.
+    template <typename Loader>
+    std::shared_ptr<Value> GetOrLoad(const Key& key, Loader&& loader)
+    {
+        Shard& shard = m_Shards[Hash()(key) % m_NumShards];
+
+        {
+            std::lock_guard<std::mutex> lock(shard.m_Mutex);
+            auto it = shard.m_Lookup.find(key);
+            if (it != shard.m_Lookup.end())
+            {
+                shard.m_Entries.splice(shard.m_Entries.begin(), shard.m_Entries, it->second);
+                m_Hits.fetch_add(1, std::memory_order_relaxed);
+                return it->second->m_Value;
+            }
+        }
+
+        m_Misses.fetch_add(1, std::memory_order_relaxed);
+
+        exrU64 cost = 0;
+        std::shared_ptr<Value> value = loader(cost);
+
+        std::lock_guard<std::mutex> lock(shard.m_Mutex);
+        auto it = shard.m_Lookup.find(key);
+        if (it != shard.m_Lookup.end())
+            return it->second->m_Value;
+
+        shard.m_Entries.push_front({ key, value, cost });
+        shard.m_Lookup[key] = shard.m_Entries.begin();
+        shard.m_ResidentCost += cost;
+        exrS64 delta = exrS64(cost);
+
+        // Always keep the entry that was just loaded, even if it alone exceeds the budget
+        while (shard.m_ResidentCost > m_ShardBudget && shard.m_Entries.size() > 1)
+        {
+            Entry& victim = shard.m_Entries.back();
+            shard.m_ResidentCost -= victim.m_Cost;
+            delta -= exrS64(victim.m_Cost);
+            shard.m_Lookup.erase(victim.m_Key);
+            shard.m_Entries.pop_back();
+            m_Evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        UpdateResidentCost(delta);
+        return value;
+    }
+
+    //! @brief Evicts all entries from the cache
+    void Clear()
+    {
+        for (exrU32 i = 0; i < m_NumShards; ++i)
+        {
+            std::lock_guard<std::mutex> lock(m_Shards[i].m_Mutex);
+            UpdateResidentCost(-exrS64(m_Shards[i].m_ResidentCost));
+            m_Shards[i].m_ResidentCost = 0;
+            m_Shards[i].m_Lookup.clear();
+            m_Shards[i].m_Entries.clear();
+        }
+    }
+
+    //! @brief Returns a snapshot of the hit, miss and eviction counters
+    Statistics GetStatistics() const
+    {
+        Statistics stats;
+        stats.m_Hits = m_Hits;
+        stats.m_Misses = m_Misses;
+        stats.m_Evictions = m_Evictions;
+        stats.m_ResidentCost = m_ResidentCost;
+        stats.m_PeakResidentCost = m_PeakResidentCost;
+        return stats;
+    }
+
+private:
+    struct Entry
+    {
+        Key m_Key;
+        std::shared_ptr<Value> m_Value;
+        exrU64 m_Cost;
+    };
+
+    struct Shard
+    {
+        std::mutex m_Mutex;
+        std::list<Entry> m_Entries;
+        std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> m_Lookup;
+        exrU64 m_ResidentCost = 0;
+    };
+
+    void UpdateResidentCost(exrS64 delta)
+    {
+        exrU64 resident = m_ResidentCost.fetch_add(exrU64(delta)) + exrU64(delta);
+        exrU64 peak = m_PeakResidentCost;
+        while (resident > peak && !m_PeakResidentCost.compare_exchange_weak(peak, resident));
+    }
+
+private:
+    const exrU32 m_NumShards;
+    const exrU64 m_ShardBudget;
+    std::unique_ptr<Shard[]> m_Shards;
+
+    std::atomic<exrU64> m_Hits { 0 };
+    std::atomic<exrU64> m_Misses { 0 };
+    std::atomic<exrU64> m_Evictions { 0 };
+    std::atomic<exrU64> m_ResidentCost { 0 };
+    std::atomic<exrU64> m_PeakResidentCost { 0 };
+};
+
+exrEND_NAMESPACE
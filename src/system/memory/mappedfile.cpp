@@ -0,0 +1,223 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mappedfile.h"
+
+#ifdef EXR_PLATFORM_WIN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+exrBEGIN_NAMESPACE
+
+MappedRegion::~MappedRegion()
+{
+#ifdef EXR_PLATFORM_WIN
+    UnmapViewOfFile(m_Mapping);
+#else
+    munmap(m_Mapping, m_MappingSize);
+#endif
+}
+
+MappedFile::MappedFile(const exrString& filename)
+    : m_FileName(filename)
+{
+#ifdef EXR_PLATFORM_WIN
+    m_FileHandle = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, nullptr);
+    if (m_FileHandle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Unable to create file " + filename);
+#else
+    m_FileDescriptor = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_FileDescriptor < 0)
+        throw std::runtime_error("Unable to create file " + filename);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef EXR_PLATFORM_WIN
+    if (m_MappingHandle != nullptr)
+        CloseHandle(m_MappingHandle);
+    CloseHandle(m_FileHandle);
+#else
+    close(m_FileDescriptor);
+#endif
+    remove(m_FileName.c_str());
+}
+
+exrU64 MappedFile::Append(const void* data, exrU64 size)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const exrU64 offset = m_Size;
+    WriteRegion(offset, data, size);
+    m_Size += size;
+    return offset;
+}
+
+exrU64 MappedFile::Reserve(exrU64 size)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const exrU64 offset = m_Size;
+
+#ifdef EXR_PLATFORM_WIN
+    LARGE_INTEGER newSize;
+    newSize.QuadPart = static_cast<LONGLONG>(offset + size);
+    if (!SetFilePointerEx(m_FileHandle, newSize, nullptr, FILE_BEGIN) || !SetEndOfFile(m_FileHandle))
+        throw std::runtime_error("Unable to grow file " + m_FileName);
+#else
+    if (ftruncate(m_FileDescriptor, static_cast<off_t>(offset + size)) != 0)
+        throw std::runtime_error("Unable to grow file " + m_FileName);
+#endif
+
+    m_Size += size;
+    return offset;
+}
+
+void MappedFile::WriteAt(exrU64 offset, const void* data, exrU64 size)
+{
+    exrAssert(offset + size <= GetSize(), "Mapped file writes must lie within the file!");
+    WriteRegion(offset, data, size);
+}
+
+void MappedFile::WriteRegion(exrU64 offset, const void* data, exrU64 size)
+{
+    const exrByte* src = static_cast<const exrByte*>(data);
+    exrU64 written = 0;
+
+    while (written < size)
+    {
+#ifdef EXR_PLATFORM_WIN
+        // Positioned writes, so that concurrent writers do not race on the file pointer
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = DWORD((offset + written) & 0xFFFFFFFF);
+        overlapped.OffsetHigh = DWORD((offset + written) >> 32);
+
+        DWORD chunk = 0;
+        DWORD toWrite = static_cast<DWORD>(std::min(size - written, exrU64(1 << 30)));
+        if (!WriteFile(m_FileHandle, src + written, toWrite, &chunk, &overlapped) || chunk == 0)
+            throw std::runtime_error("Unable to write to file " + m_FileName);
+#else
+        ssize_t chunk = pwrite(m_FileDescriptor, src + written, size - written, offset + written);
+        if (chunk <= 0)
+            throw std::runtime_error("Unable to write to file " + m_FileName);
+#endif
+        written += chunk;
+    }
+}
+
+std::shared_ptr<MappedRegion> MappedFile::Map(exrU64 offset, exrU64 size) const
+{
+    exrAssert(offset % GetMappingGranularity() == 0, "Mapped file offsets must be aligned to the mapping granularity!");
+
+#ifdef EXR_PLATFORM_WIN
+    {
+        // A file mapping object has a fixed size, so recreate it if the file has grown since.
+        // Views created from the old handle remain valid until they are unmapped.
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_MappingHandle == nullptr || m_MappingHandleSize < m_Size)
+        {
+            if (m_MappingHandle != nullptr)
+                CloseHandle(m_MappingHandle);
+
+            m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            m_MappingHandleSize = m_Size;
+        }
+    }
+
+    void* mapping = MapViewOfFile(m_MappingHandle, FILE_MAP_READ, DWORD(static_cast<unsigned long long>(offset) >> 32), DWORD(offset & 0xFFFFFFFF), SIZE_T(size));
+    if (mapping == nullptr)
+        return nullptr;
+#else
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_FileDescriptor, offset);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+#endif
+
+    return std::make_shared<MappedRegion>(mapping, size, static_cast<const exrByte*>(mapping));
+}
+
+exrU64 MappedFile::GetSize() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Size;
+}
+
+std::shared_ptr<MappedRegion> MappedFile::MapReadOnly(const exrString& filename)
+{
+#ifdef EXR_PLATFORM_WIN
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER size;
+    HANDLE mappingHandle = nullptr;
+    void* mapping = nullptr;
+
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle != nullptr)
+        mapping = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+    // The view keeps the file mapped after the handles are closed
+    if (mappingHandle != nullptr)
+        CloseHandle(mappingHandle);
+    CloseHandle(file);
+
+    if (mapping == nullptr)
+        return nullptr;
+
+    const exrU64 mappingSize = static_cast<exrU64>(size.QuadPart);
+#else
+    exrS32 fileDescriptor = open(filename.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+        return nullptr;
+
+    const off_t size = lseek(fileDescriptor, 0, SEEK_END);
+    void* mapping = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0) : MAP_FAILED;
+
+    // The mapping keeps the file open after the descriptor is closed
+    close(fileDescriptor);
+
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    const exrU64 mappingSize = static_cast<exrU64>(size);
+#endif
+
+    return std::make_shared<MappedRegion>(mapping, mappingSize, static_cast<const exrByte*>(mapping));
+}
+
+exrU64 MappedFile::GetMappingGranularity()
+{
+#ifdef EXR_PLATFORM_WIN
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return static_cast<exrU64>(info.dwAllocationGranularity);
+#else
+    return static_cast<exrU64>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+exrEND_NAMESPACE
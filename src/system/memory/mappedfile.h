@@ -0,0 +1,127 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "system/system.h"
+#include <mutex>
+
+exrBEGIN_NAMESPACE
+
+//! @brief A read-only view of a region of a memory mapped file
+//!
+//! The region is unmapped when the view is destroyed, which allows the operating system
+//! to drop the backing pages from physical memory.
+class MappedRegion
+{
+public:
+    MappedRegion(void* mapping, exrU64 mappingSize, const exrByte* data)
+        : m_Mapping(mapping)
+        , m_MappingSize(mappingSize)
+        , m_Data(data) {};
+
+    ~MappedRegion();
+
+    MappedRegion(const MappedRegion&) = delete;
+    MappedRegion& operator=(const MappedRegion&) = delete;
+
+    //! @brief Returns a pointer to the first byte of the requested region
+    inline const exrByte* GetData() const { return m_Data; }
+
+    //! @brief Returns the number of bytes from GetData() to the end of the region
+    inline exrU64 GetSize() const { return m_MappingSize - (m_Data - static_cast<const exrByte*>(m_Mapping)); }
+
+private:
+    //! The address returned by the OS, which may start before the requested offset
+    void* m_Mapping;
+    exrU64 m_MappingSize;
+    const exrByte* m_Data;
+};
+
+//! @brief A scratch file that is filled by appending and read back through memory mapping
+//!
+//! The file is created (or truncated) on construction and deleted on destruction. Appends
+//! are serialized internally, so multiple threads can write to the same file.
+class MappedFile
+{
+public:
+    //! @brief Creates an empty file on disk
+    //! @param filename         The path of the file to create
+    MappedFile(const exrString& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //! @brief Writes a block of data to the end of the file
+    //! @param data             The data to write
+    //! @param size             The number of bytes to write
+    //! @return                 The offset in the file where the data begins
+    exrU64 Append(const void* data, exrU64 size);
+
+    //! @brief Grows the file by a block of zeroes that can be filled in later with WriteAt()
+    //! @param size             The number of bytes to reserve
+    //! @return                 The offset in the file where the block begins
+    exrU64 Reserve(exrU64 size);
+
+    //! @brief Overwrites data that is already part of the file
+    //!
+    //! Writes to disjoint regions may happen concurrently.
+    //!
+    //! @param offset           The offset to write to. The region must lie within the file.
+    //! @param data             The data to write
+    //! @param size             The number of bytes to write
+    void WriteAt(exrU64 offset, const void* data, exrU64 size);
+
+    //! @brief Maps a region of the file into memory
+    //! @param offset           The offset of the region, must be a multiple of GetMappingGranularity()
+    //! @param size             The number of bytes to map
+    //! @return                 The mapped region, or nullptr if the mapping failed
+    std::shared_ptr<MappedRegion> Map(exrU64 offset, exrU64 size) const;
+
+    //! @brief Returns the current size of the file in bytes
+    exrU64 GetSize() const;
+
+    //! @brief Maps an entire existing file into memory for reading
+    //! @param filename         The path of the file to map
+    //! @return                 The mapped file, or nullptr if it could not be opened or mapped
+    static std::shared_ptr<MappedRegion> MapReadOnly(const exrString& filename);
+
+    //! @brief Returns the alignment that Map() offsets must respect on this platform
+    static exrU64 GetMappingGranularity();
+
+private:
+    //! Writes without taking the lock or growing the file
+    void WriteRegion(exrU64 offset, const void* data, exrU64 size);
+
+    exrString m_FileName;
+    exrU64 m_Size = 0;
+    mutable std::mutex m_Mutex;
+
+#ifdef EXR_PLATFORM_WIN
+    void* m_FileHandle;
+    mutable void* m_MappingHandle = nullptr;
+    mutable exrU64 m_MappingHandleSize = 0;
+#else
+    exrS32 m_FileDescriptor;
+#endif
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,175 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "system/system.h"
+
+exrBEGIN_NAMESPACE
+
+// Returns the index of the smallest power of two that is at least size
+static exrU32 GetBucketIndex(size_t size)
+{
+    exrU32 bucket = 0;
+    while ((size_t(1) << bucket) < size)
+        ++bucket;
+    return bucket;
+}
+
+// Returns the index of the largest power of two that is at most size
+static exrU32 GetFloorBucketIndex(size_t size)
+{
+    exrU32 bucket = 0;
+    while (bucket + 1 < sizeof(size_t) * 8 && (size_t(1) << (bucket + 1)) <= size)
+        ++bucket;
+    return bucket;
+}
+
+MemoryArena::MemoryArena(size_t blockSize)
+    : m_BlockSize(size_t(1) << GetBucketIndex(std::max(blockSize, MinAlignment)))
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+    FreeAligned(m_CurrentBlock);
+    for (const Block& block : m_UsedBlocks) FreeAligned(block.m_Data);
+    for (const std::vector<Block>& bucket : m_FreeBlocks)
+        for (const Block& block : bucket) FreeAligned(block.m_Data);
+}
+
+void MemoryArena::NextBlock(size_t minSize)
+{
+    if (m_CurrentBlock)
+        m_UsedBlocks.push_back({ m_CurrentAllocSize, m_CurrentBlock });
+
+    // Rounding larger requests up to a power of two could nearly double them, so they are only
+    // rounded to a quarter of one. That wastes at most a fifth of the block, while keeping few
+    // enough distinct sizes for released blocks to be reused.
+    size_t size = m_BlockSize;
+    if (minSize > m_BlockSize)
+    {
+        const size_t step = size_t(1) << (GetFloorBucketIndex(minSize) - 2);
+        size = (minSize + step - 1) & ~(step - 1);
+    }
+
+    // Blocks in the bucket of the request itself may be too small, so that bucket is searched
+    exrU32 bucket = GetFloorBucketIndex(size);
+    std::vector<Block>& sameBucket = m_FreeBlocks[bucket];
+    auto fit = std::find_if(sameBucket.rbegin(), sameBucket.rend(), [&](const Block& block) { return block.m_Size >= size; });
+
+    if (fit != sameBucket.rend())
+        std::swap(*fit, sameBucket.back());
+    else
+    {
+        // Any block in a higher bucket is big enough, so take one from the lowest non-empty one
+        const size_t higherBuckets = m_FreeBucketMask & ~((size_t(2) << bucket) - 1);
+        bucket = higherBuckets != 0 ? GetFloorBucketIndex(higherBuckets & (~higherBuckets + 1)) : NumBuckets;
+    }
+
+    if (bucket != NumBuckets)
+    {
+        const Block block = m_FreeBlocks[bucket].back();
+        m_FreeBlocks[bucket].pop_back();
+        if (m_FreeBlocks[bucket].empty())
+            m_FreeBucketMask &= ~(size_t(1) << bucket);
+
+        m_CurrentBlock = block.m_Data;
+        m_CurrentAllocSize = block.m_Size;
+    }
+    else
+    {
+        m_CurrentBlock = static_cast<uint8_t*>(AllocateAligned(size));
+        if (!m_CurrentBlock)
+            throw std::bad_alloc();
+
+        m_ReservedBytes.Add(size);
+        m_BlockAllocations.Add(1);
+        m_CurrentAllocSize = size;
+    }
+
+    m_CurrentBlockPos = 0;
+}
+
+void MemoryArena::PushFreeBlock(const Block& block)
+{
+    const exrU32 bucket = GetFloorBucketIndex(block.m_Size);
+    m_FreeBlocks[bucket].push_back(block);
+    m_FreeBucketMask |= size_t(1) << bucket;
+}
+
+MemoryArena::Statistics MemoryArena::GetStatistics()
+{
+    Statistics stats;
+    ForEach([&](const MemoryArena& arena)
+    {
+        stats.m_PeakBytes = std::max(stats.m_PeakBytes, arena.m_PeakBytes.Get());
+        stats.m_ReservedBytes += arena.m_ReservedBytes.Get();
+        stats.m_BlockAllocations += arena.m_BlockAllocations.Get();
+        stats.m_Resets += arena.m_Resets.Get();
+        stats.m_NumArenas++;
+    });
+
+    return stats;
+}
+
+void MemoryArena::ResetStatistics()
+{
+    ForEach([](MemoryArena& arena)
+    {
+        arena.m_PeakBytes.Reset();
+        arena.m_BlockAllocations.Reset();
+        arena.m_Resets.Reset();
+    });
+}
+
+void MemoryArena::PrintStatistics()
+{
+    Statistics stats = GetStatistics();
+
+    exrInfoLine("Memory arenas: " << stats.m_NumArenas << " arenas, " << stats.m_ReservedBytes / 1024.0 << " KB reserved, "
+        << stats.m_PeakBytes / 1024.0 << " KB peak per reset");
+    exrInfoLine("\t   " << stats.m_BlockAllocations << " block allocations, " << stats.m_Resets << " resets");
+}
+
+void* MemoryArena::AllocateAligned(size_t size)
+{
+#if defined (EXR_HAVE_ALIGNED_MALLOC)
+    return _aligned_malloc(size, EXR_L1_CACHE_LINE_SIZE);
+#elif defined (EXR_HAVE_POSIX_MEMALIGN)
+    void* ptr;
+    if (posix_memalign(&ptr, EXR_L1_CACHE_LINE_SIZE, size) != 0)
+        ptr = nullptr;
+    return ptr;
+#else
+    return memalign(EXR_L1_CACHE_LINE_SIZE, size);
+#endif
+}
+
+void MemoryArena::FreeAligned(void* ptr)
+{
+    if (!ptr)
+        return;
+#if defined (EXR_HAVE_ALIGNED_MALLOC)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+exrEND_NAMESPACE
@@ -20,119 +20,140 @@
 
 #pragma once
 
-#include <list>
+#include <cstdint>
 
 exrBEGIN_NAMESPACE
 
 #define EXR_L1_CACHE_LINE_SIZE 64   // Default cache line size of 64 bytes
 
 // "Placement new" syntax - https://isocpp.org/wiki/faq/dtors#placement-new
-#define EXR_ARENA_ALLOC(arena, Type) new ((arena).Allocate(sizeof(Type))) Type
-
-class MemoryArena 
+#define EXR_ARENA_ALLOC(arena, Type) new ((arena).Allocate(sizeof(Type), alignof(Type))) Type
+
+//! @brief A linear allocator for short-lived objects, such as the BSDFs of a single sample
+//!
+//! Memory is handed out from large blocks and only reclaimed all at once by Release(). Regular
+//! blocks are a power of two in size, while requests larger than that get a block rounded up to
+//! a quarter of a power of two. Released blocks are kept in a free list bucketed by the power of
+//! two below their size, so a block that is big enough is found again with little searching.
+class MemoryArena : public ThreadStatistics<MemoryArena>
 {
 public:
-    //! @brief Constructs a memory arena given a block size (default: 256kb)
-    MemoryArena(size_t blockSize = 262144) : m_BlockSize(blockSize) {};
-
-    ~MemoryArena() {
-        FreeAligned(m_CurrentBlock);
-        for (auto& block : m_UsedBlocks) FreeAligned(block.second);
-        for (auto& block : m_AvailableBlocks) FreeAligned(block.second);
-    }
+    struct Statistics
+    {
+        exrU64 m_PeakBytes = 0;
+        exrU64 m_ReservedBytes = 0;
+        exrU64 m_BlockAllocations = 0;
+        exrU64 m_Resets = 0;
+        exrU32 m_NumArenas = 0;
+    };
 
-    void* Allocate(size_t numBytes)
+    //! @brief Constructs a memory arena given a block size (default: 256kb)
+    //! @param blockSize        The minimum size of a block, rounded up to a power of two
+    MemoryArena(size_t blockSize = 262144);
+    ~MemoryArena();
+
+    //! @brief Allocates uninitialized memory that is valid until the next Release()
+    //! @param numBytes         The number of bytes to allocate
+    //! @param align            The alignment of the returned address, must be a power of two
+    void* Allocate(size_t numBytes, size_t align = MinAlignment)
     {
-        // Round up numBytes to minimum machine alignment
-        const int align = 16;
-        numBytes = ((numBytes + align - 1) & (~align - 1));
+        exrAssert((align & (align - 1)) == 0, "Arena allocations must be aligned to a power of two!");
+        align = std::max(align, MinAlignment);
 
-        // If the requested amount of memory does not fit into the current block,
-        // dynamically allocate a new block.
-        if (m_CurrentBlockPos + numBytes > m_CurrentAllocSize)
+        // Align the address itself, so that alignments above that of the block are honored too
+        uintptr_t current = reinterpret_cast<uintptr_t>(m_CurrentBlock) + m_CurrentBlockPos;
+        size_t padding = ((current + align - 1) & ~uintptr_t(align - 1)) - current;
+
+        if (m_CurrentBlock == nullptr || m_CurrentBlockPos + padding + numBytes > m_CurrentAllocSize)
         {
-            // If current block exist, set to used, since it is not big enough
-            if (m_CurrentBlock)
-            {
-                m_UsedBlocks.emplace_back(m_CurrentAllocSize, m_CurrentBlock);
-                m_CurrentBlock = nullptr;
-                m_CurrentAllocSize = 0;
-            }
-
-            // Find an available block that can fit the size requested
-            for (auto it = m_AvailableBlocks.begin(); it != m_AvailableBlocks.end(); ++it)
-            {
-                if (it->first >= numBytes)
-                {
-                    m_CurrentAllocSize = it->first;
-                    m_CurrentBlock = it->second;
-                    m_AvailableBlocks.erase(it);
-                    break;
-                }
-            }
-
-            // Cannot find any available blocks, so create a new block
-            if (!m_CurrentBlock)
-            {
-                m_CurrentAllocSize = std::max(numBytes, m_BlockSize);
-                m_CurrentBlock = (uint8_t*)AllocateAligned(m_CurrentAllocSize * sizeof(uint8_t));
-            }
-
-            m_CurrentBlockPos = 0;
+            // Blocks start on a cache line, so only larger alignments need room for padding
+            NextBlock(align <= EXR_L1_CACHE_LINE_SIZE ? numBytes : numBytes + align - 1);
+            current = reinterpret_cast<uintptr_t>(m_CurrentBlock);
+            padding = ((current + align - 1) & ~uintptr_t(align - 1)) - current;
         }
 
-        void* ret = m_CurrentBlock + m_CurrentBlockPos;
-        m_CurrentBlockPos += numBytes;
+        void* ret = m_CurrentBlock + m_CurrentBlockPos + padding;
+        m_CurrentBlockPos += padding + numBytes;
+        m_BytesInUse += padding + numBytes;
         return ret;
     }
 
+    //! @brief Reclaims all allocations at once. Destructors of allocated objects are not run.
     void Release()
     {
+        m_PeakBytes.Max(m_BytesInUse);
+        m_Resets.Add(1);
+
+        // The current block stays current, so the common case of a sample fitting into one
+        // block never touches the free list
+        for (const Block& block : m_UsedBlocks)
+            PushFreeBlock(block);
+        m_UsedBlocks.clear();
+
         m_CurrentBlockPos = 0;
-        m_AvailableBlocks.splice(m_AvailableBlocks.begin(), m_UsedBlocks);
+        m_BytesInUse = 0;
     }
 
-    size_t TotalAllocated() const
+    //! @brief Returns the total size of all blocks owned by the arena
+    size_t TotalAllocated() const { return m_ReservedBytes.Get(); }
+
+    //! @brief Returns an arena owned by the calling thread
+    //!
+    //! The arena lives until the thread exits, so its blocks are reused by every render
+    //! job that runs on the thread. Callers must Release() it once they are done with it.
+    static MemoryArena& GetThreadArena()
     {
-        size_t total = m_CurrentAllocSize;
-        for (const auto& block : m_UsedBlocks) total += block.first;
-        for (const auto& block : m_AvailableBlocks) total += block.first;
-        return total;
+        static thread_local MemoryArena threadArena;
+        return threadArena;
     }
 
+    //! @brief Returns the counters of all live arenas combined. The peak is that of the busiest arena.
+    static Statistics GetStatistics();
+
+    //! @brief Clears the peak, block allocation and reset counters of all live arenas
+    static void ResetStatistics();
+
+    //! @brief Logs the combined arena counters
+    static void PrintStatistics();
+
 private:
-    void* AllocateAligned(size_t size)
+    struct Block
     {
-#if defined (EXR_HAVE_ALIGNED_MALLOC)
-        return _aligned_malloc(size, EXR_L1_CACHE_LINE_SIZE);
-#elif defined (EXR_HAVE_POSIX_MEMALIGN)
-        void* ptr;
-        if (posix_memalign(&ptr, EXR_L1_CACHE_LINE_SIZE, size) != 0)
-            ptr = nullptr;
-        return ptr;
-#else
-        return memalign(EXR_L1_CACHE_LINE_SIZE, size);
-#endif
-    }
+        size_t m_Size;
+        uint8_t* m_Data;
+    };
 
-    void FreeAligned(void* ptr)
-    {
-        if (!ptr)
-            return;
-#if defined (EXR_HAVE_ALIGNED_MALLOC)
-        _aligned_free(ptr);
-#else
-        free(ptr);
-#endif
-    }
+    //! Makes a block of at least minSize bytes current, reusing a free block if possible
+    void NextBlock(size_t minSize);
+    void PushFreeBlock(const Block& block);
+
+    static void* AllocateAligned(size_t size);
+    static void FreeAligned(void* ptr);
 
 private:
+    static constexpr size_t MinAlignment = 16;
+    static constexpr exrU32 NumBuckets = sizeof(size_t) * 8;
+
     const size_t m_BlockSize;
     size_t m_CurrentBlockPos = 0;
     size_t m_CurrentAllocSize = 0;
+    size_t m_BytesInUse = 0;
     uint8_t* m_CurrentBlock = nullptr;
-    std::list<std::pair<size_t, uint8_t*>> m_UsedBlocks;
-    std::list<std::pair<size_t, uint8_t*>> m_AvailableBlocks;
+
+    //! Blocks that were filled since the last Release(), not including the current one
+    std::vector<Block> m_UsedBlocks;
+
+    //! Released blocks, where bucket i holds blocks of at least 2^i and less than 2^(i+1) bytes
+    std::vector<Block> m_FreeBlocks[NumBuckets];
+
+    //! One bit per bucket, set if the bucket is not empty
+    size_t m_FreeBucketMask = 0;
+
+    //! Gathered from all arenas by GetStatistics()
+    ThreadCounter<exrU64> m_PeakBytes;
+    ThreadCounter<exrU64> m_ReservedBytes;
+    ThreadCounter<exrU64> m_BlockAllocations;
+    ThreadCounter<exrU64> m_Resets;
 };
 
-exrEND_NAMESPACE
\ No newline at end of file
+exrEND_NAMESPACE
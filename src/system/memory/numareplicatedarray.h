@@ -0,0 +1,95 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "system/system.h"
+#include <mutex>
+
+exrBEGIN_NAMESPACE
+
+//! @brief Per NUMA node copies of a read-only array
+//!
+//! Threads pinned to another node than the one that built an array would read all of it from
+//! remote memory. The first time a thread on such a node asks for the array, it copies the
+//! array, which places the copy in its own node's memory on first touch. Threads on node 0
+//! (including all threads that are not pinned) use the original. Does nothing on machines with
+//! a single node.
+template <typename T>
+class NumaReplicatedArray
+{
+public:
+    NumaReplicatedArray()
+    {
+        const exrU32 numNodes = ThreadAffinity::GetNumNumaNodes();
+        if (numNodes > 1)
+            m_Replicas = std::make_unique<Replica[]>(numNodes);
+    }
+
+    //! @brief Returns the copy of the array that is local to the calling thread
+    //! @param original         The array. Must stay the same for the lifetime of the replicas.
+    //! @param count            The number of elements in the array
+    inline const T* Get(const T* original, exrU64 count) const
+    {
+        const exrU32 node = ThreadAffinity::GetCurrentNumaNode();
+        if (node == 0 || m_Replicas == nullptr || count == 0)
+            return original;
+
+        const T* replica = m_Replicas[node].m_Data.load(std::memory_order_acquire);
+        return replica != nullptr ? replica : CreateReplica(node, original, count);
+    }
+
+    //! @brief Drops all copies, e.g. because the original has changed
+    void Clear()
+    {
+        const exrU32 numNodes = ThreadAffinity::GetNumNumaNodes();
+        if (numNodes > 1)
+            m_Replicas = std::make_unique<Replica[]>(numNodes);
+    }
+
+private:
+    struct Replica
+    {
+        std::atomic<const T*> m_Data { nullptr };
+        std::unique_ptr<T[]> m_Storage;
+        std::mutex m_Mutex;
+    };
+
+    const T* CreateReplica(exrU32 node, const T* original, exrU64 count) const
+    {
+        Replica& replica = m_Replicas[node];
+        std::lock_guard<std::mutex> lock(replica.m_Mutex);
+
+        if (replica.m_Storage == nullptr)
+        {
+            // Allocated by this thread, which is what places the pages on its node on first touch
+            replica.m_Storage.reset(new T[count]);
+            std::copy(original, original + count, replica.m_Storage.get());
+            replica.m_Data.store(replica.m_Storage.get(), std::memory_order_release);
+        }
+
+        return replica.m_Storage.get();
+    }
+
+private:
+    std::unique_ptr<Replica[]> m_Replicas;
+};
+
+exrEND_NAMESPACE
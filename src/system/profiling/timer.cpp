@@ -20,6 +20,7 @@
 
 #include <chrono>
 #include <ctime>
+#include <exception>
 
 #include "timer.h"
 
@@ -29,6 +30,7 @@ Timer::Timer(exrString processName)
     : m_ProcessName(processName)
     , m_StartTime(std::chrono::steady_clock::now())
     , m_HasEarlyExit(false)
+    , m_NumUncaughtExceptions(std::uncaught_exceptions())
 {
     exrInfoLine(processName);
 }
@@ -38,6 +40,13 @@ Timer::~Timer()
     if (m_HasEarlyExit)
         return;
 
+    // The scope is being left by an exception, so the process did not complete
+    if (std::uncaught_exceptions() > m_NumUncaughtExceptions)
+    {
+        exrInfoLine("\t   " << m_ProcessName << " failed");
+        return;
+    }
+
     EndTimer();
 }
 
@@ -36,6 +36,9 @@ public:
     Timer(exrString processName = "Unamed Process");
 
     //! @brief Destructor that stops the timer. This should not be explicitly called
+    //!
+    //! If the scope is left because of an exception, the process is reported as failed
+    //! instead of logging its elapsed time.
     ~Timer();
 
     //! @brief Stops the timer before the timer goes out of scope
@@ -67,6 +70,9 @@ private:
 
     //! A flag that will be set by EndTimer() to prevent destructor from logging again
     exrBool m_HasEarlyExit;
+
+    //! The number of exceptions in flight when the timer was created
+    exrS32 m_NumUncaughtExceptions;
 };
 
 exrEND_NAMESPACE
\ No newline at end of file
@@ -35,7 +35,10 @@
 #include "system/error.h"
 #include "system/utils.h"
 #include "system/types.h"
+#include "system/fileutils.h"
 #include "system/threading/parallel.h"
+#include "system/threading/cancellationtoken.h"
+#include "system/threading/threadstatistics.h"
 #include "system/profiling/profiler.h"
 #include "system/memory/memoryarena.h"
 
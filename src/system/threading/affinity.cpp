@@ -0,0 +1,219 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "system/system.h"
+
+#ifdef EXR_PLATFORM_WIN
+#define NOMINMAX
+#include <windows.h>
+#elif defined EXR_PLATFORM_LINUX
+#include <cctype>
+#include <dirent.h>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+exrBEGIN_NAMESPACE
+
+struct Processor
+{
+    exrU32 m_Id;
+    exrU32 m_NumaNode;
+};
+
+#ifdef EXR_PLATFORM_LINUX
+// Parses a list of processor ranges in the format of /sys, e.g. "0-3,8-11"
+static std::vector<exrU32> ParseProcessorList(const exrString& list)
+{
+    std::vector<exrU32> processors;
+    size_t position = 0;
+
+    while (position < list.size())
+    {
+        size_t end = list.find(',', position);
+        if (end == exrString::npos)
+            end = list.size();
+
+        const exrString range = list.substr(position, end - position);
+        const size_t dash = range.find('-');
+        const exrU32 first = exrU32(atoi(range.c_str()));
+        const exrU32 last = dash == exrString::npos ? first : exrU32(atoi(range.c_str() + dash + 1));
+
+        for (exrU32 id = first; id <= last; ++id)
+            processors.push_back(id);
+
+        position = end + 1;
+    }
+
+    return processors;
+}
+#endif
+
+// Returns the processors that the process may run on, grouped by node with dense node indices
+static std::vector<std::vector<exrU32>> QueryProcessorsPerNode()
+{
+    std::vector<std::vector<exrU32>> nodes;
+
+#ifdef EXR_PLATFORM_WIN
+    DWORD_PTR processMask, systemMask;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+    {
+        std::vector<std::pair<exrU32, exrU32>> processors;
+        for (exrU32 id = 0; id < sizeof(DWORD_PTR) * 8; ++id)
+        {
+            UCHAR node = 0;
+            if ((processMask & (DWORD_PTR(1) << id)) != 0 && GetNumaProcessorNode(UCHAR(id), &node))
+                processors.push_back({ exrU32(node), id });
+        }
+
+        std::sort(processors.begin(), processors.end());
+        for (size_t i = 0; i < processors.size(); ++i)
+        {
+            if (i == 0 || processors[i].first != processors[i - 1].first)
+                nodes.emplace_back();
+
+            nodes.back().push_back(processors[i].second);
+        }
+    }
+#elif defined EXR_PLATFORM_LINUX
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        std::vector<exrU32> nodeIds;
+        if (DIR* directory = opendir("/sys/devices/system/node"))
+        {
+            while (dirent* entry = readdir(directory))
+            {
+                if (strncmp(entry->d_name, "node", 4) == 0 && isdigit(entry->d_name[4]))
+                    nodeIds.push_back(exrU32(atoi(entry->d_name + 4)));
+            }
+
+            closedir(directory);
+        }
+
+        std::sort(nodeIds.begin(), nodeIds.end());
+        for (exrU32 nodeId : nodeIds)
+        {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(nodeId) + "/cpulist");
+            exrString list;
+            std::getline(file, list);
+
+            std::vector<exrU32> processors;
+            for (exrU32 id : ParseProcessorList(list))
+            {
+                if (id < CPU_SETSIZE && CPU_ISSET(id, &allowed))
+                    processors.push_back(id);
+            }
+
+            if (!processors.empty())
+                nodes.push_back(processors);
+        }
+
+        // Without NUMA support in the kernel, all allowed processors are on a single node
+        if (nodes.empty())
+        {
+            nodes.emplace_back();
+            for (exrU32 id = 0; id < CPU_SETSIZE; ++id)
+            {
+                if (CPU_ISSET(id, &allowed))
+                    nodes.back().push_back(id);
+            }
+        }
+    }
+#endif
+
+    if (nodes.empty())
+    {
+        nodes.emplace_back();
+        for (exrU32 id = 0; id < std::max(std::thread::hardware_concurrency(), 1u); ++id)
+            nodes.back().push_back(id);
+    }
+
+    return nodes;
+}
+
+// Returns all processors, alternating between nodes
+static const std::vector<Processor>& GetProcessorOrder()
+{
+    static const std::vector<Processor> order = []
+    {
+        const std::vector<std::vector<exrU32>> nodes = QueryProcessorsPerNode();
+        std::vector<Processor> processors;
+
+        for (size_t round = 0; ; ++round)
+        {
+            const size_t numProcessors = processors.size();
+            for (exrU32 node = 0; node < nodes.size(); ++node)
+            {
+                if (round < nodes[node].size())
+                    processors.push_back({ nodes[node][round], node });
+            }
+
+            if (processors.size() == numProcessors)
+                break;
+        }
+
+        return processors;
+    }();
+
+    return order;
+}
+
+exrU32 ThreadAffinity::GetNumNumaNodes()
+{
+    static const exrU32 numNumaNodes = [] 
+    {
+        exrU32 numNodes = 0;
+        for (const Processor& processor : GetProcessorOrder())
+            numNodes = std::max(numNodes, processor.m_NumaNode + 1);
+
+        return numNodes;
+    }();
+
+    return numNumaNodes;
+}
+
+exrBool ThreadAffinity::PinCurrentThread(exrU32 threadIndex)
+{
+    const std::vector<Processor>& processors = GetProcessorOrder();
+    const Processor& processor = processors[threadIndex % processors.size()];
+
+#ifdef EXR_PLATFORM_WIN
+    if (SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << processor.m_Id) == 0)
+        return false;
+#elif defined EXR_PLATFORM_LINUX
+    cpu_set_t processorSet;
+    CPU_ZERO(&processorSet);
+    CPU_SET(processor.m_Id, &processorSet);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(processorSet), &processorSet) != 0)
+        return false;
+#else
+    // macOS only supports affinity hints between threads, not pinning
+    (void)processor;
+    return false;
+#endif
+
+    m_NumaNode = processor.m_NumaNode;
+    return true;
+}
+
+exrEND_NAMESPACE
@@ -0,0 +1,48 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+exrBEGIN_NAMESPACE
+
+//! @brief Pins threads to processors, and keeps track of the NUMA node that each thread runs on
+//!
+//! Processors are handed out in an order that alternates between NUMA nodes, so that threads
+//! are spread evenly over all sockets. Threads that are not pinned are assumed to run on node 0.
+class ThreadAffinity
+{
+public:
+    //! @brief Returns the number of NUMA nodes that the process may run on
+    static exrU32 GetNumNumaNodes();
+
+    //! @brief Returns the NUMA node that the calling thread is pinned to, or 0 if it is not pinned
+    static exrU32 GetCurrentNumaNode() { return m_NumaNode; }
+
+    //! @brief Pins the calling thread to a single processor
+    //! @param threadIndex      Selects the processor. Wraps around if there are more threads than processors.
+    //! @return                 False if threads cannot be pinned on this platform
+    static exrBool PinCurrentThread(exrU32 threadIndex);
+
+private:
+    ThreadAffinity() {}
+    static inline thread_local exrU32 m_NumaNode = 0;
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,72 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+exrBEGIN_NAMESPACE
+
+//! @brief A flag that long running work polls to find out whether it should stop early
+//!
+//! The token is cancelled either explicitly or once an optional deadline has passed. Work is
+//! never interrupted; it is up to the owner of the work to check IsCancelled() often enough.
+class CancellationToken
+{
+public:
+    //! @brief Requests the work to stop. Lock-free, so this can be called from a signal handler.
+    void Cancel() { m_Cancelled.store(true, std::memory_order_relaxed); }
+
+    //! @brief Clears the cancellation request and the deadline
+    void Reset()
+    {
+        m_Cancelled.store(false, std::memory_order_relaxed);
+        m_Deadline.store(NoDeadline, std::memory_order_relaxed);
+    }
+
+    //! @brief Cancels the token once the given number of seconds from now has passed
+    //! @param seconds          The budget in seconds, or 0 to remove the deadline
+    void SetTimeBudget(exrFloat seconds)
+    {
+        const Clock::duration budget = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<exrFloat>(seconds));
+        m_Deadline.store(seconds > 0 ? (Clock::now() + budget).time_since_epoch().count() : NoDeadline, std::memory_order_relaxed);
+    }
+
+    //! @brief Returns true if the work should stop
+    exrBool IsCancelled() const
+    {
+        if (m_Cancelled.load(std::memory_order_relaxed))
+            return true;
+
+        const Clock::rep deadline = m_Deadline.load(std::memory_order_relaxed);
+        return deadline != NoDeadline && Clock::now().time_since_epoch().count() >= deadline;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr Clock::rep NoDeadline = std::numeric_limits<Clock::rep>::max();
+
+    std::atomic<exrBool> m_Cancelled { false };
+    std::atomic<Clock::rep> m_Deadline { NoDeadline };
+};
+
+exrEND_NAMESPACE
@@ -0,0 +1,126 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "system/system.h"
+
+exrBEGIN_NAMESPACE
+
+//! The state of a single ParallelForChunks() call, shared with the tasks that help run it
+struct ParallelLoop
+{
+    void (*m_Run)(const void*, exrU64);
+    const void* m_Context;
+    exrU64 m_NumChunks;
+
+    std::atomic<exrU64> m_NextChunk { 0 };
+    std::atomic<exrU64> m_NumFinishedChunks { 0 };
+    std::atomic<exrBool> m_HasFailed { false };
+
+    std::mutex m_Mutex;
+    std::condition_variable m_FinishedCondition;
+    std::exception_ptr m_Exception;
+
+    //! Runs chunks until there are none left to start
+    void Work()
+    {
+        exrU64 chunk;
+        while ((chunk = m_NextChunk.fetch_add(1)) < m_NumChunks)
+        {
+            // Once a chunk has failed, the remaining ones are only counted off
+            if (!m_HasFailed.load())
+            {
+                try
+                {
+                    m_Run(m_Context, chunk);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    if (!m_HasFailed.exchange(true))
+                        m_Exception = std::current_exception();
+                }
+            }
+
+            if (m_NumFinishedChunks.fetch_add(1) + 1 == m_NumChunks)
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_FinishedCondition.notify_all();
+            }
+        }
+    }
+};
+
+static std::unique_ptr<ThreadPool> g_ThreadPool;
+
+void ParallelInit(exrU32 numThreads, exrBool pinThreads)
+{
+    exrAssert(g_ThreadPool == nullptr, "The parallel thread pool has already been initialized!");
+
+    if (pinThreads && !ThreadAffinity::PinCurrentThread(0))
+    {
+        exrWarningLine("Threads cannot be pinned to processors on this platform");
+        pinThreads = false;
+    }
+
+    // The thread that starts a loop works on it as well, so it counts as one of the threads
+    if (numThreads > 1)
+        g_ThreadPool = std::make_unique<ThreadPool>(numThreads - 1, pinThreads);
+}
+
+void ParallelCleanup()
+{
+    g_ThreadPool = nullptr;
+}
+
+void ParallelForChunks(exrU64 numChunks, void (*run)(const void*, exrU64), const void* context)
+{
+    if (g_ThreadPool == nullptr || numChunks == 1)
+    {
+        for (exrU64 chunk = 0; chunk < numChunks; ++chunk)
+            run(context, chunk);
+
+        return;
+    }
+
+    // Helpers may only start after the loop is over, so they share ownership of its state. They
+    // never touch the context then, since there are no chunks left for them to start.
+    std::shared_ptr<ParallelLoop> loop = std::make_shared<ParallelLoop>();
+    loop->m_Run = run;
+    loop->m_Context = context;
+    loop->m_NumChunks = numChunks;
+
+    const exrU64 numHelpers = std::min(numChunks - 1, exrU64(g_ThreadPool->GetNumThreads()));
+    for (exrU64 i = 0; i < numHelpers; ++i)
+        g_ThreadPool->ScheduleTask([loop] { loop->Work(); });
+
+    // Working on the loop from the calling thread guarantees progress even if all workers are
+    // busy, or if this is called from a worker itself
+    loop->Work();
+
+    {
+        std::unique_lock<std::mutex> lock(loop->m_Mutex);
+        loop->m_FinishedCondition.wait(lock, [&] { return loop->m_NumFinishedChunks.load() == numChunks; });
+    }
+
+    if (loop->m_Exception)
+        std::rethrow_exception(loop->m_Exception);
+}
+
+exrEND_NAMESPACE
@@ -51,4 +51,111 @@ private:
     std::atomic<exrU32> m_Bits;
 };
 
+//! @brief Starts the process-wide thread pool that all parallel loops run on
+//!
+//! Until this is called (and after ParallelCleanup()), parallel loops run on the calling thread.
+//! @param numThreads       The total number of threads to run loops on, including the caller
+//! @param pinThreads       Pins the caller and the threads of the pool to their own processor
+void ParallelInit(exrU32 numThreads, exrBool pinThreads = false);
+
+//! @brief Finishes all scheduled work and joins the threads of the pool
+void ParallelCleanup();
+
+//! @brief Runs run(context, chunk) for every chunk in [0, numChunks) and waits for all of them
+//!
+//! The calling thread works on chunks too, so this can safely be nested inside other parallel
+//! loops or tasks. If any chunk throws, the first exception is rethrown once all chunks are done.
+void ParallelForChunks(exrU64 numChunks, void (*run)(const void*, exrU64), const void* context);
+
+template <typename ChunkFunc>
+void ParallelForChunks(exrU64 numChunks, const ChunkFunc& chunkFunc)
+{
+    ParallelForChunks(numChunks, [](const void* context, exrU64 chunk)
+    {
+        (*static_cast<const ChunkFunc*>(context))(chunk);
+    }, &chunkFunc);
+}
+
+//! @brief Runs func(i) for every i in [begin, end) on the thread pool
+//! @param grainSize        The number of consecutive indices that a single task processes
+template <typename Func>
+void ParallelFor(exrU64 begin, exrU64 end, exrU64 grainSize, Func&& func)
+{
+    if (begin >= end)
+        return;
+
+    grainSize = std::max(grainSize, exrU64(1));
+    const exrU64 numChunks = (end - begin + grainSize - 1) / grainSize;
+
+    ParallelForChunks(numChunks, [&](exrU64 chunk)
+    {
+        const exrU64 chunkBegin = begin + chunk * grainSize;
+        const exrU64 chunkEnd = std::min(chunkBegin + grainSize, end);
+
+        for (exrU64 i = chunkBegin; i < chunkEnd; ++i)
+            func(i);
+    });
+}
+
+//! @brief Runs func(x, y) for every element of a width x height grid on the thread pool
+//! @param tileSize         The width and height of the square tile that a single task processes
+template <typename Func>
+void ParallelFor2D(exrU32 width, exrU32 height, exrU32 tileSize, Func&& func)
+{
+    if (width == 0 || height == 0)
+        return;
+
+    tileSize = std::max(tileSize, 1u);
+    const exrU32 numTilesX = (width + tileSize - 1) / tileSize;
+    const exrU32 numTilesY = (height + tileSize - 1) / tileSize;
+
+    ParallelForChunks(exrU64(numTilesX) * numTilesY, [&](exrU64 tile)
+    {
+        const exrU32 tileMinX = exrU32(tile % numTilesX) * tileSize;
+        const exrU32 tileMinY = exrU32(tile / numTilesX) * tileSize;
+        const exrU32 tileMaxX = std::min(tileMinX + tileSize, width);
+        const exrU32 tileMaxY = std::min(tileMinY + tileSize, height);
+
+        for (exrU32 y = tileMinY; y < tileMaxY; ++y)
+        {
+            for (exrU32 x = tileMinX; x < tileMaxX; ++x)
+                func(x, y);
+        }
+    });
+}
+
+//! @brief Combines the results of func over [begin, end) on the thread pool
+//!
+//! Each chunk of grainSize indices accumulates into its own copy of identity with
+//! func(i, accumulator). The partial results are then combined with reduce(a, b) in index
+//! order, so the result does not depend on the number of threads or the scheduling.
+template <typename T, typename Func, typename Reduce>
+T ParallelReduce(exrU64 begin, exrU64 end, exrU64 grainSize, const T& identity, Func&& func, Reduce&& reduce)
+{
+    if (begin >= end)
+        return identity;
+
+    grainSize = std::max(grainSize, exrU64(1));
+    const exrU64 numChunks = (end - begin + grainSize - 1) / grainSize;
+
+    // Not a std::vector, whose bool specialization packs the results of neighboring chunks into shared bytes
+    std::unique_ptr<T[]> partialResults(new T[numChunks]);
+    std::fill(partialResults.get(), partialResults.get() + numChunks, identity);
+
+    ParallelForChunks(numChunks, [&](exrU64 chunk)
+    {
+        const exrU64 chunkBegin = begin + chunk * grainSize;
+        const exrU64 chunkEnd = std::min(chunkBegin + grainSize, end);
+
+        for (exrU64 i = chunkBegin; i < chunkEnd; ++i)
+            func(i, partialResults[chunk]);
+    });
+
+    T result = identity;
+    for (exrU64 chunk = 0; chunk < numChunks; ++chunk)
+        result = reduce(result, partialResults[chunk]);
+
+    return result;
+}
+
 exrEND_NAMESPACE
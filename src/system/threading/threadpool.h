@@ -21,92 +21,205 @@
 #pragma once
 
 #include <condition_variable>
+#include <deque>
 #include <mutex>
-#include <future>
-#include <queue>
+#include <thread>
+#include <tuple>
+#include "affinity.h"
+#include "workstealingdeque.h"
 
 exrBEGIN_NAMESPACE
 
-struct ThreadTask
+//! @brief A work-stealing thread pool
+//!
+//! Every worker owns a deque of tasks. Tasks scheduled from a worker go to the bottom of its
+//! own deque, and idle workers steal from the top of the others' deques. Tasks scheduled from
+//! any other thread go into a shared FIFO queue, from which idle workers take batches into
+//! their own deque. There is no global priority: tasks scheduled from outside the pool start
+//! roughly in the order they were scheduled, so callers sort them by priority beforehand.
+class ThreadPool
 {
-    template <typename Func, typename... Args>
-    ThreadTask(exrFloat priority, Func&& func, Args&&... args)
+public:
+    //! @param numThreads       The number of worker threads
+    //! @param pinThreads       Pins worker i to the processor of ThreadAffinity thread index i + 1. Index 0
+    //!                         is left for the thread that owns the pool, as it usually runs tasks too.
+    ThreadPool(exrU32 numThreads, exrBool pinThreads = false)
+        : m_NumWorkers(numThreads)
+        , m_PinThreads(pinThreads)
+        , m_Workers(std::make_unique<Worker[]>(numThreads))
     {
-        // package task function with its arguments
-        auto pTask = std::make_shared<std::packaged_task<void()>>(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+        for (exrU32 i = 0; i < numThreads; ++i)
+            m_Workers[i].m_Thread = std::thread([this, i] { RunWorker(i); });
+    }
 
-        // convert packaged task to a void std::function
-        m_Task = ([pTask]() { (*pTask)(); });
-        m_Priority = priority;
-    };
+    //! Finishes all scheduled tasks before joining the workers
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_Stop = true;
+        }
 
-    inline exrBool operator<(const ThreadTask& t) const { return t.m_Priority < m_Priority; }
+        m_WakeCondition.notify_all();
 
-    std::function<void()> m_Task;
-    exrFloat m_Priority;
-};
+        for (exrU32 i = 0; i < m_NumWorkers; ++i)
+            m_Workers[i].m_Thread.join();
+    };
 
-class ThreadPool
-{
-public:
-    ThreadPool(exrU32 numThreads) : m_Stop(false)
+    //! @brief Schedules task(args...) to run on one of the workers
+    //!
+    //! The task and its arguments are stored by value, without any allocation.
+    template <typename Task, typename... Args>
+    void ScheduleTask(Task&& task, Args&&... args)
     {
-        for (exrU32 i = 0; i < numThreads; ++i)
+        ThreadTask threadTask([task = std::forward<Task>(task), arguments = std::make_tuple(std::forward<Args>(args)...)]() mutable
         {
-            m_Threads.emplace_back([this, i]
-            {
-                while (true)
-                {
-                    std::function<void()> task;
+            std::apply(task, arguments);
+        });
 
-                    {
-                        std::unique_lock<std::mutex> lock(this->m_QueueMutex);
-                        this->m_Condition.wait(lock, [this] { return this->m_Stop || !this->m_Tasks.empty(); });
+        // Running tasks may still schedule more while the pool is stopping
+        const WorkerContext& context = GetWorkerContext();
+        if (m_Stop && context.m_Pool != this)
+            throw std::runtime_error("Task enqueued on a stopped ThreadPool!");
 
-                        if (this->m_Stop && this->m_Tasks.empty())
-                            break;
+        // Count the task first, so that the worker that runs it never sees the count underflow
+        m_NumQueuedTasks.fetch_add(1);
 
-                        task = std::move(this->m_Tasks.top().m_Task);
-                        this->m_Tasks.pop();
-                    }
+        if (context.m_Pool != this || !m_Workers[context.m_Index].m_Tasks.Push(threadTask))
+        {
+            std::lock_guard<std::mutex> lock(m_SharedMutex);
+            m_SharedTasks.push_back(std::move(threadTask));
+        }
 
-                    task();
-                }
-            });
+        if (m_NumSleeping.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_WakeCondition.notify_one();
         }
+    };
+
+    //! @brief Returns the number of worker threads
+    inline exrU32 GetNumThreads() const { return m_NumWorkers; }
+
+private:
+    struct Worker
+    {
+        WorkStealingDeque m_Tasks;
+        std::thread m_Thread;
+    };
+
+    //! Identifies the pool and worker that the current thread belongs to, if any
+    struct WorkerContext
+    {
+        const ThreadPool* m_Pool = nullptr;
+        exrU32 m_Index = 0;
+    };
+
+    static WorkerContext& GetWorkerContext()
+    {
+        static thread_local WorkerContext context;
+        return context;
     }
 
-    ~ThreadPool()
+    void RunWorker(exrU32 index)
     {
+        GetWorkerContext() = { this, index };
+        if (m_PinThreads)
+            ThreadAffinity::PinCurrentThread(index + 1);
+
+        exrU32 randomState = index * 0x9E3779B9u + 1;
+
+        while (true)
         {
-            std::unique_lock<std::mutex> lock(m_QueueMutex);
-            m_Stop = true;
+            ThreadTask task;
+            if (FindTask(index, randomState, task))
+            {
+                m_NumQueuedTasks.fetch_sub(1);
+                RunTask(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_NumSleeping.fetch_add(1);
+            m_WakeCondition.wait(lock, [this] { return m_Stop || m_NumQueuedTasks.load() > 0; });
+            m_NumSleeping.fetch_sub(1);
+
+            if (m_Stop && m_NumQueuedTasks.load() == 0)
+                break;
         }
 
-        m_Condition.notify_all();
+        GetWorkerContext() = WorkerContext();
+    }
 
-        for (std::thread& thread : m_Threads)
-            thread.join();
-    };
+    exrBool FindTask(exrU32 index, exrU32& randomState, ThreadTask& task)
+    {
+        Worker& worker = m_Workers[index];
+        if (worker.m_Tasks.Pop(task))
+            return true;
 
-    template <typename Task, typename... Args>
-    void ScheduleTask(exrFloat priority, Task&& task, Args&&... args)
+        if (TakeSharedTasks(worker, task))
+            return true;
+
+        // Start stealing from a random victim so that thieves spread out
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+
+        for (exrU32 i = 1; i < m_NumWorkers; ++i)
+        {
+            const exrU32 victim = (index + i + randomState) % m_NumWorkers;
+            if (victim != index && m_Workers[victim].m_Tasks.Steal(task))
+                return true;
+        }
+
+        return false;
+    }
+
+    //! Moves a fair share of the shared queue into the worker's own deque, and returns the first task
+    exrBool TakeSharedTasks(Worker& worker, ThreadTask& task)
     {
-        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        std::lock_guard<std::mutex> lock(m_SharedMutex);
+        if (m_SharedTasks.empty())
+            return false;
 
-        if (m_Stop)
-            throw std::runtime_error("Task enqueued on a stopped ThreadPool!");
+        const size_t numShared = m_SharedTasks.size();
+        const size_t batchSize = std::min({ numShared, numShared / m_NumWorkers + 1, size_t(WorkStealingDeque::Capacity / 2) });
+        task = std::move(m_SharedTasks.front());
 
-        m_Tasks.emplace(priority, std::forward<Task>(task), std::forward<Args>(args)...);
-        m_Condition.notify_one();
-    };
+        // Push in reverse so that the worker pops them in order, and thieves steal the last ones.
+        // This cannot overflow, as the worker only takes shared tasks once its own deque is empty.
+        for (size_t i = batchSize - 1; i > 0; --i)
+            worker.m_Tasks.Push(m_SharedTasks[i]);
+
+        m_SharedTasks.erase(m_SharedTasks.begin(), m_SharedTasks.begin() + batchSize);
+        return true;
+    }
+
+    static void RunTask(ThreadTask& task)
+    {
+        try
+        {
+            task();
+        }
+        catch (const std::exception& e)
+        {
+            exrError("Unhandled exception in worker thread: " << e.what());
+        }
+    }
 
 private:
-    std::priority_queue<ThreadTask> m_Tasks;
-    std::mutex m_QueueMutex;
-    std::condition_variable m_Condition;
-    std::vector<std::thread> m_Threads;
-    exrBool m_Stop;
+    const exrU32 m_NumWorkers;
+    const exrBool m_PinThreads;
+    std::unique_ptr<Worker[]> m_Workers;
+
+    std::mutex m_SharedMutex;
+    std::deque<ThreadTask> m_SharedTasks;
+
+    std::atomic<exrU32> m_NumQueuedTasks { 0 };
+    std::atomic<exrU32> m_NumSleeping { 0 };
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WakeCondition;
+    std::atomic<exrBool> m_Stop { false };
 };
 
 exrEND_NAMESPACE
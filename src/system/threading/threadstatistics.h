@@ -0,0 +1,109 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
+exrBEGIN_NAMESPACE
+
+//! @brief A counter that only its owning thread writes, but that any thread may read
+//!
+//! Updates are a relaxed load and store instead of a read-modify-write, so counting costs no
+//! more than a plain add, while a thread that gathers the counters still reads whole values.
+template <typename T>
+class ThreadCounter
+{
+public:
+    ThreadCounter() : m_Value(T()) {}
+
+    void Add(T value) { m_Value.store(m_Value.load(std::memory_order_relaxed) + value, std::memory_order_relaxed); }
+
+    //! @brief Raises the counter to value, if it is lower
+    void Max(T value)
+    {
+        if (value > m_Value.load(std::memory_order_relaxed))
+            m_Value.store(value, std::memory_order_relaxed);
+    }
+
+    T Get() const { return m_Value.load(std::memory_order_relaxed); }
+
+    //! @brief Clears the counter. Only exact while the owning thread is not counting.
+    void Reset() { m_Value.store(T(), std::memory_order_relaxed); }
+
+private:
+    std::atomic<T> m_Value;
+};
+
+//! @brief A base for objects that keep the counters of a single thread, such as thread-local arenas
+//!
+//! Every live object of Derived is registered for its whole lifetime, so that the counters of
+//! all threads can be gathered or cleared once the work is done.
+template <typename Derived>
+class ThreadStatistics
+{
+public:
+    ThreadStatistics(const ThreadStatistics&) = delete;
+    ThreadStatistics& operator=(const ThreadStatistics&) = delete;
+
+    //! @brief Calls visit with every live object, while none can be created or destroyed
+    template <typename Visitor>
+    static void ForEach(Visitor visit)
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.m_Mutex);
+
+        for (ThreadStatistics* statistics : registry.m_Statistics)
+            visit(*static_cast<Derived*>(statistics));
+    }
+
+protected:
+    ThreadStatistics()
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.m_Mutex);
+        registry.m_Statistics.insert(this);
+    }
+
+    ~ThreadStatistics()
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.m_Mutex);
+        registry.m_Statistics.erase(this);
+    }
+
+private:
+    struct Registry
+    {
+        std::mutex m_Mutex;
+        std::unordered_set<ThreadStatistics*> m_Statistics;
+    };
+
+    static Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+};
+
+exrEND_NAMESPACE
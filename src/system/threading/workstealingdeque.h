@@ -0,0 +1,216 @@
+/*
+    This file is part of Elixir, an open-source cross platform physically
+    based renderer.
+
+    Copyright (c) 2019 Samuel Van Allen - All rights reserved.
+
+    Elixir is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+exrBEGIN_NAMESPACE
+
+//! @brief A type erased, move-only callable that is stored inline
+//!
+//! Unlike std::function, a task never allocates. Callables larger than StorageSize are
+//! rejected at compile time, so capture large state by reference or pointer instead.
+class ThreadTask
+{
+public:
+    static constexpr size_t StorageSize = 80;
+
+    ThreadTask() = default;
+
+    template <typename Func, typename = std::enable_if_t<!std::is_same<std::decay_t<Func>, ThreadTask>::value>>
+    explicit ThreadTask(Func&& func)
+    {
+        using Callable = std::decay_t<Func>;
+        static_assert(sizeof(Callable) <= StorageSize, "Task is too large to be stored inline. Capture by reference instead.");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "Task is over-aligned");
+
+        new (m_Storage) Callable(std::forward<Func>(func));
+        m_Operation = &Operate<Callable>;
+    }
+
+    ThreadTask(ThreadTask&& other) noexcept { MoveFrom(other); }
+    ThreadTask& operator=(ThreadTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            MoveFrom(other);
+        }
+
+        return *this;
+    }
+
+    ~ThreadTask() { Reset(); }
+
+    inline void operator()() { m_Operation(OPERATION_INVOKE, this, nullptr); }
+    inline explicit operator bool() const { return m_Operation != nullptr; }
+
+private:
+    enum Operation
+    {
+        OPERATION_INVOKE,
+        OPERATION_MOVE,
+        OPERATION_DESTROY
+    };
+
+    template <typename Callable>
+    static void Operate(Operation operation, ThreadTask* self, ThreadTask* destination)
+    {
+        Callable* callable = std::launder(reinterpret_cast<Callable*>(self->m_Storage));
+
+        switch (operation)
+        {
+        case OPERATION_INVOKE:
+            (*callable)();
+            break;
+        case OPERATION_MOVE:
+            new (destination->m_Storage) Callable(std::move(*callable));
+            callable->~Callable();
+            break;
+        case OPERATION_DESTROY:
+            callable->~Callable();
+            break;
+        }
+    }
+
+    inline void MoveFrom(ThreadTask& other)
+    {
+        m_Operation = other.m_Operation;
+        if (m_Operation != nullptr)
+            m_Operation(OPERATION_MOVE, &other, this);
+        other.m_Operation = nullptr;
+    }
+
+    inline void Reset()
+    {
+        if (m_Operation != nullptr)
+            m_Operation(OPERATION_DESTROY, this, nullptr);
+        m_Operation = nullptr;
+    }
+
+private:
+    alignas(std::max_align_t) exrByte m_Storage[StorageSize];
+    void (*m_Operation)(Operation, ThreadTask*, ThreadTask*) = nullptr;
+};
+
+//! @brief A fixed capacity Chase-Lev work-stealing deque
+//!
+//! The owning thread pushes and pops at the bottom without taking any lock, while other
+//! threads steal from the top with a single compare-and-swap. Tasks are moved in and out of
+//! the slots, so the owner waits for a slow thief to finish moving a task out of a slot before
+//! reusing it. See "Correct and Efficient Work-Stealing for Weak Memory Models", Lê et al. 2013.
+class WorkStealingDeque
+{
+public:
+    static constexpr exrS64 Capacity = 1024;
+
+    WorkStealingDeque()
+        : m_Slots(std::make_unique<Slot[]>(Capacity)) {};
+
+    //! @brief Pushes a task to the bottom of the deque. Must only be called by the owner.
+    //! @return                 False if the deque is full, in which case the task is not moved
+    exrBool Push(ThreadTask& task)
+    {
+        const exrS64 bottom = m_Bottom.load(std::memory_order_relaxed);
+        const exrS64 top = m_Top.load(std::memory_order_acquire);
+        if (bottom - top >= Capacity)
+            return false;
+
+        Slot& slot = m_Slots[bottom & (Capacity - 1)];
+        while (slot.m_IsFull.load(std::memory_order_acquire))
+            std::this_thread::yield();
+
+        slot.m_Task = std::move(task);
+        slot.m_IsFull.store(true, std::memory_order_relaxed);
+        m_Bottom.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! @brief Pops the most recently pushed task. Must only be called by the owner.
+    exrBool Pop(ThreadTask& task)
+    {
+        const exrS64 bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+        m_Bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        exrS64 top = m_Top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // The last task may be contended by thieves
+        if (top == bottom)
+        {
+            const exrBool won = m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+            if (!won)
+                return false;
+        }
+
+        TakeFrom(m_Slots[bottom & (Capacity - 1)], task);
+        return true;
+    }
+
+    //! @brief Steals the least recently pushed task. May be called by any thread.
+    exrBool Steal(ThreadTask& task)
+    {
+        exrS64 top = m_Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const exrS64 bottom = m_Bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+            return false;
+
+        if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return false;
+
+        TakeFrom(m_Slots[top & (Capacity - 1)], task);
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<exrBool> m_IsFull { false };
+        ThreadTask m_Task;
+    };
+
+    static inline void TakeFrom(Slot& slot, ThreadTask& task)
+    {
+        task = std::move(slot.m_Task);
+        slot.m_IsFull.store(false, std::memory_order_release);
+    }
+
+private:
+    std::unique_ptr<Slot[]> m_Slots;
+
+    // Kept on separate cache lines, as the owner writes the bottom and thieves the top
+    alignas(64) std::atomic<exrS64> m_Top { 0 };
+    alignas(64) std::atomic<exrS64> m_Bottom { 0 };
+};
+
+exrEND_NAMESPACE